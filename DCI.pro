@@ -45,13 +45,27 @@ HEADERS = \
     Log_Routines/debug_logger.hpp \
     Log_Routines/default_loggers.hpp \
     Driver_Routines/DriverLevels/chairs.hpp \
+    Driver_Routines/DriverLevels/colorQuantizer.hpp \
     Driver_Routines/DriverLevels/heightmaps.hpp \
+    Driver_Routines/DriverLevels/imageQuantizer.hpp \
     Driver_Routines/DriverLevels/lamps.hpp \
     Driver_Routines/DriverLevels/models.hpp \
+    Driver_Routines/DriverLevels/paletteOptimizer.hpp \
+    Driver_Routines/DriverLevels/paletteRemap.hpp \
     Driver_Routines/DriverLevels/RandomModelPlacement.hpp \
+    Driver_Routines/DriverLevels/roadGraph.hpp \
+    Driver_Routines/DriverLevels/roadGrid.hpp \
     Driver_Routines/DriverLevels/roads.hpp \
+    Driver_Routines/DriverLevels/sectorBitset.hpp \
+    Driver_Routines/DriverLevels/sectorTextureBuilder.hpp \
+    Driver_Routines/DriverLevels/textureAtlas.hpp \
+    Driver_Routines/DriverLevels/textureDuplicates.hpp \
     Driver_Routines/DriverLevels/textures.hpp \
+    Driver_Routines/DriverLevels/textureUsage.hpp \
+    Driver_Routines/DriverLevels/uniformGrid.hpp \
+    Driver_Routines/DriverLevels/visibilityBuilder.hpp \
     Driver_Routines/DriverLevels/world.hpp \
+    Driver_Routines/DriverLevels/worldGrid.hpp \
     Driver_Routines/driver_levels.hpp \
     Driver_Routines/driver_d3d.hpp \
     Driver_Routines/driver_cos.hpp \
@@ -67,6 +81,9 @@ HEADERS = \
     QtGUI/TextureList.hpp \
     QtGUI/Textures/TextureDefinitionEditor.hpp \
     QtGUI/Textures/TextureExportDialog.hpp \
+    QtGUI/Textures/TextureBatchExportDialog.hpp \
+    QtGUI/Textures/TextureBatchImportDialog.hpp \
+    QtGUI/Textures/TextureFilters.hpp \
     QtGUI/Textures/TextureImportDialog.hpp \
     QtGUI/Textures/TexturePropertiesWidget.hpp \
     QtGUI/Textures/TextureView.hpp \
@@ -74,24 +91,40 @@ HEADERS = \
     QtGUI/Palettes/PaletteEditor.hpp \
     QtGUI/Palettes/PaletteDisplay.hpp \
     QtGUI/Palettes/AddPaletteDialog.hpp \
+    QtGUI/Palettes/OptimizePalettesDialog.hpp \
     QtGUI/Models/DriverModelListModel.hpp \
     QtGUI/Models/ModelDialogs.hpp \
     QtGUI/Models/ModelView.hpp \
     QtGUI/Models/ModelRenderer.hpp \
     QtGUI/Models/ModelViewPanel.hpp \
+    QtGUI/World/VisibilityCheckDialog.hpp \
 	MainWindow.hpp
 SOURCES = \
     vector.cpp \
     Log_Routines/debug_logger.cpp \
     Log_Routines/default_loggers.cpp \
     Driver_Routines/DriverLevels/chairs.cpp \
+    Driver_Routines/DriverLevels/colorQuantizer.cpp \
     Driver_Routines/DriverLevels/heightmaps.cpp \
+    Driver_Routines/DriverLevels/imageQuantizer.cpp \
     Driver_Routines/DriverLevels/lamps.cpp \
     Driver_Routines/DriverLevels/models.cpp \
+    Driver_Routines/DriverLevels/paletteOptimizer.cpp \
+    Driver_Routines/DriverLevels/paletteRemap.cpp \
     Driver_Routines/DriverLevels/RandomModelPlacement.cpp \
+    Driver_Routines/DriverLevels/roadGraph.cpp \
+    Driver_Routines/DriverLevels/roadGrid.cpp \
     Driver_Routines/DriverLevels/roads.cpp \
+    Driver_Routines/DriverLevels/sectorBitset.cpp \
+    Driver_Routines/DriverLevels/sectorTextureBuilder.cpp \
+    Driver_Routines/DriverLevels/textureAtlas.cpp \
+    Driver_Routines/DriverLevels/textureDuplicates.cpp \
     Driver_Routines/DriverLevels/textures.cpp \
+    Driver_Routines/DriverLevels/textureUsage.cpp \
+    Driver_Routines/DriverLevels/uniformGrid.cpp \
+    Driver_Routines/DriverLevels/visibilityBuilder.cpp \
     Driver_Routines/DriverLevels/world.cpp \
+    Driver_Routines/DriverLevels/worldGrid.cpp \
     Driver_Routines/driver_levels.cpp \
     Driver_Routines/driver_d3d.cpp \
     Driver_Routines/driver_cos.cpp \
@@ -107,6 +140,8 @@ SOURCES = \
     QtGUI/TextureList.cpp \
     QtGUI/Textures/TextureDefinitionEditor.cpp \
     QtGUI/Textures/TextureExportDialog.cpp \
+    QtGUI/Textures/TextureBatchExportDialog.cpp \
+    QtGUI/Textures/TextureBatchImportDialog.cpp \
     QtGUI/Textures/TextureImportDialog.cpp \
     QtGUI/Textures/TexturePropertiesWidget.cpp \
     QtGUI/Textures/TextureView.cpp \
@@ -114,11 +149,13 @@ SOURCES = \
     QtGUI/Palettes/PaletteEditor.cpp \
     QtGUI/Palettes/PaletteDisplay.cpp \
     QtGUI/Palettes/AddPaletteDialog.cpp \
+    QtGUI/Palettes/OptimizePalettesDialog.cpp \
     QtGUI/Models/DriverModelListModel.cpp \
     QtGUI/Models/ModelDialogs.cpp \
     QtGUI/Models/ModelView.cpp \
     QtGUI/Models/ModelRenderer.cpp \
     QtGUI/Models/ModelViewPanel.cpp \
+    QtGUI/World/VisibilityCheckDialog.cpp \
 	MainWindow.cpp \
 	main.cpp
 TARGET = \
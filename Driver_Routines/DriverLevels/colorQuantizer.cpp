@@ -0,0 +1,242 @@
+#include <algorithm>
+#include "colorQuantizer.hpp"
+#include "paletteRemap.hpp"
+
+ColorQuantizer::ColorQuantizer()
+{
+    iterations = 4;
+};
+
+void ColorQuantizer::clear()
+{
+    colors.clear();
+    histogram.clear();
+};
+
+void ColorQuantizer::setIterations(int n)
+{
+    iterations = (n < 0 ? 0 : n);
+};
+
+void ColorQuantizer::addPixels(const unsigned char* pixels, int bytesPerPixel, int redOffset, int greenOffset, int blueOffset, int count)
+{
+    colors.reserve(colors.size()+count);
+    for(int i = 0; i < count; i++)
+    {
+        colors.push_back((pixels[redOffset] << 16) | (pixels[greenOffset] << 8) | pixels[blueOffset]);
+        pixels += bytesPerPixel;
+    }
+};
+
+void ColorQuantizer::measureBox(ColorBox* box)
+{
+    double sum[3] = {0,0,0};
+    double sumSq[3] = {0,0,0};
+    double total = 0;
+    for(int i = box->start; i < box->end; i++)
+    {
+        const ColorCount& entry = histogram[i];
+        for(int j = 0; j < 3; j++)
+        {
+            sum[j] += (double)entry.c[j]*entry.count;
+            sumSq[j] += (double)entry.c[j]*entry.c[j]*entry.count;
+        }
+        total += entry.count;
+    }
+
+    box->axis = 0;
+    box->error = 0;
+    double largest = -1;
+    for(int j = 0; j < 3; j++)
+    {
+        double variance = sumSq[j]-sum[j]*sum[j]/total;
+        box->error += variance;
+        if(variance > largest)
+        {
+            largest = variance;
+            box->axis = j;
+        }
+    }
+    if(box->end-box->start < 2)
+    box->error = 0;
+};
+
+struct AxisBelow
+{
+    int axis;
+    int threshold;
+    template <typename T> bool operator()(const T& entry) const
+    {
+        return entry.c[axis] <= threshold;
+    };
+};
+
+int ColorQuantizer::quantize(DriverPalette* palette, int numColors)
+{
+    if(!palette)
+    return 0;
+
+    if(numColors > 256)
+    numColors = 256;
+
+    for(int i = 0; i < 256; i++)
+    {
+        palette->colors[i].r = 0;
+        palette->colors[i].g = 0;
+        palette->colors[i].b = 0;
+    }
+
+    if(colors.empty() || numColors < 1)
+    return 0;
+
+    vector<unsigned int> sorted(colors);
+    sort(sorted.begin(),sorted.end());
+
+    histogram.clear();
+    for(unsigned int i = 0; i < sorted.size(); i++)
+    {
+        if(!histogram.empty() && histogram.back().color == sorted[i])
+        {
+            histogram.back().count++;
+            continue;
+        }
+        ColorCount entry;
+        entry.color = sorted[i];
+        entry.c[0] = (sorted[i] >> 16)&0xFF;
+        entry.c[1] = (sorted[i] >> 8)&0xFF;
+        entry.c[2] = sorted[i]&0xFF;
+        entry.count = 1;
+        histogram.push_back(entry);
+    }
+
+    int numHistogram = histogram.size();
+    if(numHistogram <= numColors)
+    {
+        for(int i = 0; i < numHistogram; i++)
+        {
+            palette->colors[i].r = histogram[i].c[0];
+            palette->colors[i].g = histogram[i].c[1];
+            palette->colors[i].b = histogram[i].c[2];
+        }
+        return numHistogram;
+    }
+
+    //Median cut: keep splitting the box with the largest squared error at the weighted median of its widest axis.
+    vector<ColorBox> boxes;
+    ColorBox first;
+    first.start = 0;
+    first.end = numHistogram;
+    measureBox(&first);
+    boxes.push_back(first);
+
+    while((int)boxes.size() < numColors)
+    {
+        int split = -1;
+        for(unsigned int i = 0; i < boxes.size(); i++)
+        {
+            if(boxes[i].error > 0 && (split == -1 || boxes[i].error > boxes[split].error))
+            split = i;
+        }
+        if(split == -1)
+        break;
+
+        //Split by value rather than position, so which side an entry lands on never depends on its order.
+        ColorBox& box = boxes[split];
+        long long valueCounts[256];
+        memset(valueCounts,0,sizeof(valueCounts));
+        long long total = 0;
+        int low = 255, high = 0;
+        for(int i = box.start; i < box.end; i++)
+        {
+            int value = histogram[i].c[box.axis];
+            valueCounts[value] += histogram[i].count;
+            total += histogram[i].count;
+            if(value < low)
+            low = value;
+            if(value > high)
+            high = value;
+        }
+
+        AxisBelow below;
+        below.axis = box.axis;
+        below.threshold = low;
+        long long running = 0;
+        for(int v = low; v < high; v++)
+        {
+            running += valueCounts[v];
+            below.threshold = v;
+            if(running*2 >= total)
+            break;
+        }
+        int middle = partition(histogram.begin()+box.start,histogram.begin()+box.end,below)-histogram.begin();
+
+        ColorBox upper;
+        upper.start = middle;
+        upper.end = box.end;
+        box.end = middle;
+        measureBox(&box);
+        measureBox(&upper);
+        boxes.push_back(upper);
+    }
+
+    int numBoxes = boxes.size();
+    for(int i = 0; i < numBoxes; i++)
+    {
+        double sum[3] = {0,0,0};
+        double total = 0;
+        for(int j = boxes[i].start; j < boxes[i].end; j++)
+        {
+            for(int k = 0; k < 3; k++)
+            sum[k] += (double)histogram[j].c[k]*histogram[j].count;
+            total += histogram[j].count;
+        }
+        palette->colors[i].r = (unsigned char)(sum[0]/total+0.5);
+        palette->colors[i].g = (unsigned char)(sum[1]/total+0.5);
+        palette->colors[i].b = (unsigned char)(sum[2]/total+0.5);
+    }
+
+    //k-means refinement, seeded with the median cut palette. Unused entries stay black and are kept out of the
+    //search by only remapping to the first numBoxes entries.
+    DriverPalette search = *palette;
+    double* sums = new double[numBoxes*4];
+    for(int pass = 0; pass < iterations; pass++)
+    {
+        PaletteRemapper remapper(&search,numBoxes);
+        memset(sums,0,sizeof(double)*numBoxes*4);
+        for(int i = 0; i < numHistogram; i++)
+        {
+            const ColorCount& entry = histogram[i];
+            int idx = remapper.nearest(entry.c[0],entry.c[1],entry.c[2]);
+            sums[idx*4+0] += (double)entry.c[0]*entry.count;
+            sums[idx*4+1] += (double)entry.c[1]*entry.count;
+            sums[idx*4+2] += (double)entry.c[2]*entry.count;
+            sums[idx*4+3] += entry.count;
+        }
+
+        bool changed = false;
+        for(int i = 0; i < numBoxes; i++)
+        {
+            if(sums[i*4+3] <= 0)
+            continue;
+
+            color_4ub c = search.colors[i];
+            c.r = (unsigned char)(sums[i*4+0]/sums[i*4+3]+0.5);
+            c.g = (unsigned char)(sums[i*4+1]/sums[i*4+3]+0.5);
+            c.b = (unsigned char)(sums[i*4+2]/sums[i*4+3]+0.5);
+            if(c.r != search.colors[i].r || c.g != search.colors[i].g || c.b != search.colors[i].b)
+            changed = true;
+            search.colors[i] = c;
+        }
+        if(!changed)
+        break;
+    }
+    delete[] sums;
+
+    for(int i = 0; i < numBoxes; i++)
+    {
+        palette->colors[i].r = search.colors[i].r;
+        palette->colors[i].g = search.colors[i].g;
+        palette->colors[i].b = search.colors[i].b;
+    }
+    return numBoxes;
+};
@@ -0,0 +1,43 @@
+#ifndef COLOR_QUANTIZER_HPP
+#define COLOR_QUANTIZER_HPP
+
+#include "textures.hpp"
+
+//Builds a palette with median cut followed by a few k-means passes. Boxes are split by colour value and never
+//by position, so the same pixels always give the same palette regardless of platform or the order they were added in.
+class ColorQuantizer
+{
+    public:
+        ColorQuantizer();
+
+        void clear();
+        void setIterations(int n);
+        //Pixels may be added from several images to build one palette shared by all of them.
+        void addPixels(const unsigned char* pixels, int bytesPerPixel, int redOffset, int greenOffset, int blueOffset, int count);
+        //Returns the number of palette entries used, the rest are set to black.
+        int quantize(DriverPalette* palette, int numColors = 256);
+
+    protected:
+        struct ColorCount
+        {
+            unsigned int color;
+            unsigned char c[3];
+            int count;
+        };
+
+        struct ColorBox
+        {
+            int start;
+            int end;
+            int axis;
+            double error;
+        };
+
+        void measureBox(ColorBox* box);
+
+        vector<unsigned int> colors;
+        vector<ColorCount> histogram;
+        int iterations;
+};
+
+#endif
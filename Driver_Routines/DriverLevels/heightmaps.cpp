@@ -5,6 +5,64 @@ HeightmapTileFace::HeightmapTileFace()
     numVerts = 0;
 };
 
+void HeightmapTileFace::decode(const unsigned char* data, HeightmapTileFace* faces, int count)
+{
+    for(int i = 0; i < count; i++, data += HEIGHTMAP_TILE_FACE_SIZE)
+    {
+        memcpy(&faces[i].v1,data,8);
+        memcpy(&faces[i].v2,data+8,8);
+        memcpy(&faces[i].v3,data+16,8);
+        memcpy(&faces[i].v4,data+24,8);
+        memcpy(&faces[i].normal,data+32,16);
+        memcpy(&faces[i].numVerts,data+48,4);
+    }
+};
+
+void HeightmapTileFace::encode(unsigned char* data, const HeightmapTileFace* faces, int count)
+{
+    for(int i = 0; i < count; i++, data += HEIGHTMAP_TILE_FACE_SIZE)
+    {
+        memcpy(data,&faces[i].v1,8);
+        memcpy(data+8,&faces[i].v2,8);
+        memcpy(data+16,&faces[i].v3,8);
+        memcpy(data+24,&faces[i].v4,8);
+        memcpy(data+32,&faces[i].normal,16);
+        memcpy(data+48,&faces[i].numVerts,4);
+    }
+};
+
+bool HeightmapTileFace::containsTilePoint(float x, float z) const
+{
+    const Vector2i* verts[4] = {&v1,&v2,&v3,&v4};
+    int count = (numVerts == 3 ? 3 : 4);
+
+    //Faces are convex, so the point is inside if it is on the same side of every edge whatever the winding.
+    bool positive = false, negative = false;
+    for(int i = 0; i < count; i++)
+    {
+        const Vector2i* a = verts[i];
+        const Vector2i* b = verts[(i+1)%count];
+        double cross = (double)(b->x-a->x)*(z-a->y)-(double)(b->y-a->y)*(x-a->x);
+        if(cross > 0.0)
+        positive = true;
+        else if(cross < 0.0)
+        negative = true;
+        if(positive && negative)
+        return false;
+    }
+    return true;
+};
+
+bool HeightmapTileFace::getTileHeight(float x, float z, float* height) const
+{
+    if(normal.y == 0.0f || !containsTilePoint(x,z))
+    return false;
+
+    if(height)
+    *height = -(x*normal.x+z*normal.z+normal.w)/normal.y;
+    return true;
+};
+
 HeightmapTile::HeightmapTile()
 {
     modelIdx = 0;
@@ -32,6 +90,36 @@ int HeightmapTile::getNumFaces()
     return numFaces;
 };
 
+HeightmapTileFace* HeightmapTile::getFace(int idx)
+{
+    if(idx >= 0 && idx < numFaces)
+    return &faces[idx];
+    return NULL;
+};
+
+int HeightmapTile::findFaceAtTilePoint(float x, float z, float* height) const
+{
+    int found = -1;
+    float best = 0.0f;
+    for(int i = 0; i < numFaces; i++)
+    {
+        float y;
+        if(faces[i].getTileHeight(x,z,&y) && (found == -1 || y > best))
+        {
+            found = i;
+            best = y;
+        }
+    }
+    if(found != -1 && height)
+    *height = best;
+    return found;
+};
+
+bool HeightmapTile::getTileHeightAt(float x, float z, float* height) const
+{
+    return findFaceAtTilePoint(x,z,height) != -1;
+};
+
 int HeightmapTile::getModelIndex()
 {
     return modelIdx;
@@ -67,35 +155,29 @@ int HeightmapTile::load(IOHandle handle, IOCallbacks* callbacks, int size, Debug
     if(log)
     log->Log(DEBUG_LEVEL_DEBUG,"Model index: %d, Unk1: %d, Unk2: %d, Number of faces: %d",modelIdx,unk1,unk2,numFaces);
 
-    if(size < 8+numFaces*0x34)
+    if(size < 8+numFaces*HEIGHTMAP_TILE_FACE_SIZE)
         return -2;
 
     faces = new HeightmapTileFace[numFaces];
-    for(int i = 0; i < numFaces; i++)
+    unsigned char* buffer = new unsigned char[numFaces*HEIGHTMAP_TILE_FACE_SIZE];
+    callbacks->read(buffer,HEIGHTMAP_TILE_FACE_SIZE,numFaces,handle);
+    HeightmapTileFace::decode(buffer,faces,numFaces);
+    delete[] buffer;
+
+    if(log->getLogPriority() >= DEBUG_LEVEL_RIDICULOUS)
     {
-        callbacks->read(&faces[i].v1.x,4,1,handle);
-        callbacks->read(&faces[i].v1.y,4,1,handle);
-        callbacks->read(&faces[i].v2.x,4,1,handle);
-        callbacks->read(&faces[i].v2.y,4,1,handle);
-        callbacks->read(&faces[i].v3.x,4,1,handle);
-        callbacks->read(&faces[i].v3.y,4,1,handle);
-        callbacks->read(&faces[i].v4.x,4,1,handle);
-        callbacks->read(&faces[i].v4.y,4,1,handle);
-        callbacks->read(&faces[i].normal.x,4,1,handle);
-        callbacks->read(&faces[i].normal.y,4,1,handle);
-        callbacks->read(&faces[i].normal.z,4,1,handle);
-        callbacks->read(&faces[i].normal.w,4,1,handle);
-        callbacks->read(&faces[i].numVerts,4,1,handle);
-        if(log)
-        log->Log(DEBUG_LEVEL_RIDICULOUS,"V1: (%d,%d), V2: (%d,%d), V3: (%d,%d), V4: (%d,%d), Normal: (%f,%f,%f,%f), Num Verts: %d", faces[i].v1.x,faces[i].v1.y,faces[i].v2.x,
-                 faces[i].v2.y,faces[i].v3.x,faces[i].v3.y,faces[i].v4.x,faces[i].v4.y,faces[i].normal.x,faces[i].normal.y,faces[i].normal.z,faces[i].normal.w,faces[i].numVerts);
+        for(int i = 0; i < numFaces; i++)
+        {
+            log->Log(DEBUG_LEVEL_RIDICULOUS,"V1: (%d,%d), V2: (%d,%d), V3: (%d,%d), V4: (%d,%d), Normal: (%f,%f,%f,%f), Num Verts: %d", faces[i].v1.x,faces[i].v1.y,faces[i].v2.x,
+                     faces[i].v2.y,faces[i].v3.x,faces[i].v3.y,faces[i].v4.x,faces[i].v4.y,faces[i].normal.x,faces[i].normal.y,faces[i].normal.z,faces[i].normal.w,faces[i].numVerts);
+        }
     }
-    return 8+numFaces*0x34;
+    return 8+numFaces*HEIGHTMAP_TILE_FACE_SIZE;
 };
 
 unsigned int HeightmapTile::getRequiredSize()
 {
-    return 8+numFaces*0x34;
+    return 8+numFaces*HEIGHTMAP_TILE_FACE_SIZE;
 };
 
 int HeightmapTile::save(IOHandle handle, IOCallbacks* callbacks)
@@ -108,22 +190,10 @@ int HeightmapTile::save(IOHandle handle, IOCallbacks* callbacks)
     callbacks->write(&unk2,2,1,handle);
     callbacks->write(&numFaces,2,1,handle);
 
-    for(int i = 0; i < numFaces; i++)
-    {
-        callbacks->write(&faces[i].v1.x,4,1,handle);
-        callbacks->write(&faces[i].v1.y,4,1,handle);
-        callbacks->write(&faces[i].v2.x,4,1,handle);
-        callbacks->write(&faces[i].v2.y,4,1,handle);
-        callbacks->write(&faces[i].v3.x,4,1,handle);
-        callbacks->write(&faces[i].v3.y,4,1,handle);
-        callbacks->write(&faces[i].v4.x,4,1,handle);
-        callbacks->write(&faces[i].v4.y,4,1,handle);
-        callbacks->write(&faces[i].normal.x,4,1,handle);
-        callbacks->write(&faces[i].normal.y,4,1,handle);
-        callbacks->write(&faces[i].normal.z,4,1,handle);
-        callbacks->write(&faces[i].normal.w,4,1,handle);
-        callbacks->write(&faces[i].numVerts,4,1,handle);
-    }
+    unsigned char* buffer = new unsigned char[numFaces*HEIGHTMAP_TILE_FACE_SIZE];
+    HeightmapTileFace::encode(buffer,faces,numFaces);
+    callbacks->write(buffer,HEIGHTMAP_TILE_FACE_SIZE,numFaces,handle);
+    delete[] buffer;
     return getRequiredSize();
 };
 
@@ -269,6 +339,16 @@ int DriverHeightmap::save(IOHandle handle, IOCallbacks* callbacks)
     return 0;
 };
 
+int DriverHeightmap::getDataSize() const
+{
+    return compressedDataSize;
+};
+
+const unsigned char* DriverHeightmap::getData() const
+{
+    return compressedData;
+};
+
 DriverHeightmaps::DriverHeightmaps()
 {
     numHeightmaps = 0;
@@ -378,3 +458,42 @@ int DriverHeightmaps::save(IOHandle handle, IOCallbacks* callbacks)
     }
     return 0;
 };
+
+int DriverHeightmaps::getNumTilesX() const
+{
+    return numTilesX;
+};
+
+int DriverHeightmaps::getNumTilesZ() const
+{
+    return numTilesZ;
+};
+
+int DriverHeightmaps::getNumSectorsX() const
+{
+    return numSectorsX;
+};
+
+int DriverHeightmaps::getNumSectorsZ() const
+{
+    return numSectorsZ;
+};
+
+int DriverHeightmaps::getNumHeightmaps() const
+{
+    return numHeightmaps;
+};
+
+DriverHeightmap* DriverHeightmaps::getHeightmap(int idx)
+{
+    if(idx >= 0 && idx < numHeightmaps)
+    return &heightmaps[idx];
+    return NULL;
+};
+
+DriverHeightmap* DriverHeightmaps::getHeightmap(int sectorX, int sectorZ)
+{
+    if(sectorX < 0 || sectorX >= numSectorsX || sectorZ < 0 || sectorZ >= numSectorsZ)
+    return NULL;
+    return getHeightmap(sectorZ*numSectorsX+sectorX);
+};
@@ -5,10 +5,21 @@
 #include "../../vector.hpp"
 #include "../../Log_Routines/debug_logger.hpp"
 
+#define HEIGHTMAP_TILE_FACE_SIZE 0x34
+
 class HeightmapTileFace
 {
     public:
         HeightmapTileFace();
+        //Convert count records to and from a buffer in one pass.
+        static void decode(const unsigned char* data, HeightmapTileFace* faces, int count);
+        static void encode(unsigned char* data, const HeightmapTileFace* faces, int count);
+
+        //Everything is in the space of the tile's model, not the world. The vertices are (x,z) pairs and the normal
+        //holds a plane, so y = -(x*normal.x+z*normal.z+normal.w)/normal.y.
+        bool containsTilePoint(float x, float z) const;
+        bool getTileHeight(float x, float z, float* height) const;
+
         Vector2i v1,v2,v3,v4;
         Vector4f normal;
         int numVerts;
@@ -26,7 +37,12 @@ class HeightmapTile
         int save(IOHandle handle, IOCallbacks* callbacks);
 
         int getNumFaces();
+        HeightmapTileFace* getFace(int idx);
         int getModelIndex();
+        //Face under a point in tile space, the highest one where faces overlap. Returns -1 if none.
+        //World positions must first be made relative to the placed tile model, including its rotation.
+        int findFaceAtTilePoint(float x, float z, float* height = NULL) const;
+        bool getTileHeightAt(float x, float z, float* height) const;
 
         void setModelIndex(int index);
 
@@ -56,6 +72,8 @@ class HeightmapTiles
         HeightmapTile* tiles;
 };
 
+//A sector's compressed height table. The compression isn't known, so the payload is only exposed and saved
+//byte for byte. There is no decoded grid or world space height query, only HeightmapTile's tile-local ones.
 class DriverHeightmap
 {
     public:
@@ -68,6 +86,9 @@ class DriverHeightmap
         unsigned int getRequiredSize();
         int save(IOHandle handle, IOCallbacks* callbacks);
 
+        int getDataSize() const;
+        const unsigned char* getData() const;
+
     protected:
         int compressedDataSize;
         unsigned char* compressedData;
@@ -85,6 +106,15 @@ class DriverHeightmaps
         unsigned int getRequiredSize();
         int save(IOHandle handle, IOCallbacks* callbacks);
 
+        int getNumTilesX() const;
+        int getNumTilesZ() const;
+        int getNumSectorsX() const;
+        int getNumSectorsZ() const;
+        int getNumHeightmaps() const;
+        DriverHeightmap* getHeightmap(int idx);
+        //NULL outside the grid. Sectors without a table return an empty heightmap.
+        DriverHeightmap* getHeightmap(int sectorX, int sectorZ);
+
     protected:
         int numHeightmaps;
         DriverHeightmap* heightmaps;
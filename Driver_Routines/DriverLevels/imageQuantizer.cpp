@@ -0,0 +1,59 @@
+#include "imageQuantizer.hpp"
+#include "paletteRemap.hpp"
+
+FIBITMAP* quantizeImage(FIBITMAP* dib, DriverPalette* palette)
+{
+    FIBITMAP* temp8 = NULL;
+    if(FreeImage_GetBPP(dib) == 8)
+    {
+        temp8 = FreeImage_Clone(dib);
+    }
+    else
+    {
+        FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(dib);
+        if(!temp24)
+        return NULL;
+
+        int width = FreeImage_GetWidth(temp24);
+        int height = FreeImage_GetHeight(temp24);
+
+        DriverPalette quantized;
+        ColorQuantizer quantizer;
+        for(int y = 0; y < height; y++)
+        {
+            quantizer.addPixels(FreeImage_GetScanLine(temp24,y), 3, FI_RGBA_RED, FI_RGBA_GREEN, FI_RGBA_BLUE, width);
+        }
+        quantizer.quantize(&quantized);
+
+        temp8 = FreeImage_Allocate(width,height,8);
+        if(temp8)
+        {
+            RGBQUAD* pal = FreeImage_GetPalette(temp8);
+            for(int i = 0; i < 256; i++)
+            {
+                pal[i].rgbRed = quantized.colors[i].r;
+                pal[i].rgbGreen = quantized.colors[i].g;
+                pal[i].rgbBlue = quantized.colors[i].b;
+            }
+
+            PaletteRemapper remapper(&quantized);
+            for(int y = 0; y < height; y++)
+            {
+                remapper.remapScanLine(FreeImage_GetScanLine(temp24,y), 3, FI_RGBA_RED, FI_RGBA_GREEN, FI_RGBA_BLUE, width, y, FreeImage_GetScanLine(temp8,y));
+            }
+        }
+        FreeImage_Unload(temp24);
+    }
+
+    if(temp8 && palette)
+    {
+        RGBQUAD *pal = FreeImage_GetPalette(temp8);
+        for (int i = 0; i < 256; i++)
+        {
+            palette->colors[i].r = pal[i].rgbRed;
+            palette->colors[i].g = pal[i].rgbGreen;
+            palette->colors[i].b = pal[i].rgbBlue;
+        }
+    }
+    return temp8;
+};
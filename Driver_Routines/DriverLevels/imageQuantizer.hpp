@@ -0,0 +1,11 @@
+#ifndef IMAGE_QUANTIZER_HPP
+#define IMAGE_QUANTIZER_HPP
+
+#include <FreeImage.h>
+#include "colorQuantizer.hpp"
+
+//Converts a FreeImage bitmap to 8 bit with a palette built by ColorQuantizer. 8 bit bitmaps are copied as they are.
+//The palette used is also stored in palette if it isn't NULL. Returns NULL if the bitmap could not be converted.
+FIBITMAP* quantizeImage(FIBITMAP* dib, DriverPalette* palette);
+
+#endif
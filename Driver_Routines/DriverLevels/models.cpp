@@ -1523,6 +1523,12 @@ void ModelContainer::insertModel(int idx)
     }
 };
 
+void ModelContainer::markModelChanged(int idx)
+{
+    if(idx >= 0 && idx < numModels)
+    eventManager.Raise(EVENT(IDriverModelEvents::modelChanged)(this, idx));
+};
+
 DriverModel* ModelContainer::getReferencedModel(DriverModel* in)
 {
     if(!in)
@@ -169,6 +169,7 @@ class IDriverModelEvents
         DEFINE_EVENT2(IDriverModelEvents, modelsSaved, ModelContainer* /*container*/, bool /*aboutToBe*/);
 
         DEFINE_EVENT2(IDriverModelEvents, modelInserted, ModelContainer* /*container*/, int /*idx*/);
+        DEFINE_EVENT2(IDriverModelEvents, modelChanged, ModelContainer* /*container*/, int /*idx*/);
 };
 IMPLEMENT_EVENTS(IDriverModelEvents);
 
@@ -191,6 +192,8 @@ class ModelContainer
         const DriverModel* getModel(int idx) const;
         void insertModel(int idx);
         void appendModel();
+        //Models are edited in place, so whoever changes one raises the event.
+        void markModelChanged(int idx);
 
         DriverModel* getReferencedModel(DriverModel* mod);
         const DriverModel* getReferencedModel(const DriverModel* mod) const;
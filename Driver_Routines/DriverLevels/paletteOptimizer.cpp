@@ -0,0 +1,364 @@
+#include <cmath>
+#include "paletteOptimizer.hpp"
+#include "paletteRemap.hpp"
+
+static unsigned long long mixHash(unsigned long long hash, unsigned long long value)
+{
+    return (hash^value)*1099511628211ULL;
+};
+
+PaletteOptimizer::PaletteOptimizer()
+{
+    tolerance = 8;
+    reindexTextures = true;
+    compactSlots = false;
+    numSlots = 0;
+    numSlotMoves = 0;
+};
+
+void PaletteOptimizer::setTolerance(int newTolerance)
+{
+    tolerance = max(0,newTolerance);
+};
+
+int PaletteOptimizer::getTolerance() const
+{
+    return tolerance;
+};
+
+void PaletteOptimizer::setReindexTextures(bool reindex)
+{
+    reindexTextures = reindex;
+};
+
+bool PaletteOptimizer::getReindexTextures() const
+{
+    return reindexTextures;
+};
+
+void PaletteOptimizer::setCompactSlots(bool compact)
+{
+    compactSlots = compact;
+};
+
+bool PaletteOptimizer::getCompactSlots() const
+{
+    return compactSlots;
+};
+
+void PaletteOptimizer::clear()
+{
+    merges.clear();
+    numSlots = 0;
+    numSlotMoves = 0;
+};
+
+int PaletteOptimizer::colorDistance(const color_4ub& a, const color_4ub& b)
+{
+    int rmean = (a.r+b.r)/2;
+    int dr = a.r-b.r;
+    int dg = a.g-b.g;
+    int db = a.b-b.b;
+    return (512+rmean)*dr*dr + 1024*dg*dg + (767-rmean)*db*db;
+};
+
+int PaletteOptimizer::usageError(const DriverPalette* from, const DriverPalette* to, const unsigned int* usage, const unsigned char* indexMap) const
+{
+    unsigned long long total = 0;
+    unsigned long long sum = 0;
+    for(int i = 0; i < 256; i++)
+    {
+        if(!usage[i])
+            continue;
+        total += usage[i];
+        sum += (unsigned long long)usage[i]*colorDistance(from->colors[i], to->colors[(indexMap ? indexMap[i] : i)]);
+    }
+    if(!total)
+    return 0;
+    return (int)(sqrt((double)sum/(total*2304.0))+0.5);
+};
+
+void PaletteOptimizer::analyze(DriverTextures* textures, DriverD3D* d3d)
+{
+    clear();
+    if(!textures || !d3d)
+        return;
+
+    for(int i = 0; i < textures->getNumPalettes(); i++)
+    {
+        if(textures->getPalette(i)->paletteNumber >= numSlots)
+        numSlots = textures->getPalette(i)->paletteNumber+1;
+    }
+    if(numSlots == 0)
+        return;
+
+    vector<unsigned long long> hashes;
+    hashSlots(textures, d3d, hashes);
+
+    //How many pixels use each colour of each slot.
+    vector<unsigned int> usage(numSlots*256,0);
+    vector<bool> canReindex(numSlots,reindexTextures);
+    vector<bool> used(numSlots,false);
+    unsigned int histogram[256];
+
+    for(int i = 0; i < d3d->getNumEntries(); i++)
+    {
+        D3DEntry* entry = d3d->getEntry(i);
+        const DriverTexture* tex = textures->getTexture(entry->getTexture());
+        if(!tex || !tex->usesPalette() || entry->getNumPaletteIndicies() == 0)
+            continue;
+
+        memset(histogram,0,sizeof(unsigned int)*256);
+        const unsigned char* data = tex->getData();
+        for(int j = 0; j < 256*256; j++)
+        histogram[data[j]]++;
+
+        //Pixels shared by several palettes, or holding transparent colours, must keep their indices.
+        bool singlePalette = (entry->getNumPaletteIndicies() == 1 && !tex->hasTransparency());
+        for(int j = 0; j < entry->getNumPaletteIndicies(); j++)
+        {
+            int slot = entry->getPaletteIndex(j);
+            if(slot < 0 || slot >= numSlots)
+                continue;
+
+            used[slot] = true;
+            if(!singlePalette)
+            canReindex[slot] = false;
+            for(int k = 0; k < 256; k++)
+            usage[slot*256+k] += histogram[k];
+        }
+    }
+
+    //Slots are visited in order, each one joining the closest cluster it fits or starting a new one.
+    //Cluster palettes are never changed, so earlier decisions stay valid.
+    vector<int> leaders;
+    vector<PaletteRemapper*> remappers;
+    for(int slot = 0; slot < numSlots; slot++)
+    {
+        const DriverPalette* palette = textures->getIndexedPalette(slot);
+        if(!palette || !used[slot])
+            continue;
+
+        PaletteMerge best;
+        best.target = -1;
+        best.error = 0;
+        for(unsigned int i = 0; i < leaders.size(); i++)
+        {
+            const DriverPalette* leader = textures->getIndexedPalette(leaders[i]);
+            int error = usageError(palette, leader, &usage[slot*256], NULL);
+            bool reindex = false;
+            unsigned char indexMap[256];
+
+            if(error > tolerance && canReindex[slot])
+            {
+                if(!remappers[i])
+                remappers[i] = new PaletteRemapper(leader);
+
+                for(int j = 0; j < 256; j++)
+                indexMap[j] = remappers[i]->nearest(palette->colors[j].r, palette->colors[j].g, palette->colors[j].b);
+
+                int reindexError = usageError(palette, leader, &usage[slot*256], indexMap);
+                if(reindexError < error)
+                {
+                    error = reindexError;
+                    reindex = true;
+                }
+            }
+
+            if(error <= tolerance && (best.target == -1 || error < best.error))
+            {
+                best.target = leaders[i];
+                best.error = error;
+                best.reindex = reindex;
+                if(reindex)
+                memcpy(best.indexMap,indexMap,256);
+            }
+        }
+
+        if(best.target == -1)
+        {
+            leaders.push_back(slot);
+            remappers.push_back(NULL);
+        }
+        else
+        {
+            best.slot = slot;
+            best.slotHash = hashes[slot];
+            best.targetHash = hashes[best.target];
+            merges.push_back(best);
+        }
+    }
+    for(unsigned int i = 0; i < remappers.size(); i++)
+    {
+        if(remappers[i])
+        delete remappers[i];
+    }
+
+    if(compactSlots)
+    {
+        vector<bool> merged(numSlots,false);
+        for(unsigned int i = 0; i < merges.size(); i++)
+        merged[merges[i].slot] = true;
+
+        int next = 0;
+        for(int slot = 0; slot < numSlots; slot++)
+        {
+            if(!textures->getIndexedPalette(slot) || merged[slot])
+                continue;
+            if(slot != next)
+            numSlotMoves++;
+            next++;
+        }
+    }
+};
+
+int PaletteOptimizer::apply(DriverTextures* textures, DriverD3D* d3d)
+{
+    if(!textures || !d3d || numSlots == 0)
+    return 0;
+
+    //Anything edited since analyze invalidates the merges touching it, the rest are still safe to apply.
+    vector<unsigned long long> hashes;
+    hashSlots(textures, d3d, hashes);
+    vector<PaletteMerge> valid;
+    for(unsigned int i = 0; i < merges.size(); i++)
+    {
+        int slot = merges[i].slot;
+        int target = merges[i].target;
+        if(slot >= (int)hashes.size() || hashes[slot] != merges[i].slotHash || hashes[target] != merges[i].targetHash)
+            continue;
+        valid.push_back(merges[i]);
+    }
+    merges.swap(valid);
+    numSlots = hashes.size();
+
+    textures->beginChanges();
+
+    unsigned char* pixels = new unsigned char[256*256];
+    vector<bool> reindexed(textures->getNumTextures(),false);
+    vector<int> slotMap(numSlots);
+    for(int i = 0; i < numSlots; i++)
+    slotMap[i] = i;
+
+    for(unsigned int i = 0; i < merges.size(); i++)
+    {
+        const PaletteMerge& merge = merges[i];
+        slotMap[merge.slot] = merge.target;
+        if(!merge.reindex)
+            continue;
+
+        for(int j = 0; j < d3d->getNumPaletteReferences(merge.slot); j++)
+        {
+            D3DEntry* entry = d3d->getEntry(d3d->getPaletteReference(merge.slot, j));
+            int texIdx = entry->getTexture();
+            if(entry->getNumPaletteIndicies() != 1 || entry->getPaletteIndex(0) != merge.slot)
+                continue;
+            if(texIdx < 0 || texIdx >= textures->getNumTextures() || reindexed[texIdx])
+                continue;
+
+            DriverTexture tex = *textures->getTexture(texIdx);
+            const unsigned char* data = tex.getData();
+            for(int k = 0; k < 256*256; k++)
+            pixels[k] = merge.indexMap[data[k]];
+            tex.setData(pixels);
+            textures->setTexture(texIdx, &tex);
+            reindexed[texIdx] = true;
+        }
+    }
+    delete[] pixels;
+
+    //Entries are moved off a slot before its palette goes away.
+    remapEntries(d3d, slotMap);
+    for(unsigned int i = 0; i < merges.size(); i++)
+    textures->removeIndexedPalette(merges[i].slot);
+
+    if(compactSlots)
+    {
+        int next = 0;
+        for(int slot = 0; slot < numSlots; slot++)
+        {
+            slotMap[slot] = slot;
+            if(!textures->getIndexedPalette(slot))
+                continue;
+            if(slot != next)
+            {
+                textures->movePaletteSlot(slot, next);
+                slotMap[slot] = next;
+            }
+            next++;
+        }
+        remapEntries(d3d, slotMap);
+    }
+
+    textures->commitChanges();
+
+    int numRemoved = merges.size();
+    clear();
+    return numRemoved;
+};
+
+//Covers the palette in each slot and every entry and texture drawn with it.
+void PaletteOptimizer::hashSlots(DriverTextures* textures, DriverD3D* d3d, vector<unsigned long long>& hashes) const
+{
+    int slots = 0;
+    for(int i = 0; i < textures->getNumPalettes(); i++)
+    {
+        if(textures->getPalette(i)->paletteNumber >= slots)
+        slots = textures->getPalette(i)->paletteNumber+1;
+    }
+
+    hashes.assign(slots,14695981039346656037ULL);
+    for(int slot = 0; slot < slots; slot++)
+    {
+        const DriverPalette* palette = textures->getIndexedPalette(slot);
+        if(palette)
+        hashes[slot] = mixHash(hashes[slot], palette->getContentHash());
+    }
+
+    for(int i = 0; i < d3d->getNumEntries(); i++)
+    {
+        D3DEntry* entry = d3d->getEntry(i);
+        const DriverTexture* tex = textures->getTexture(entry->getTexture());
+        unsigned long long entryHash = mixHash(entry->getTexture(), entry->getNumPaletteIndicies());
+        if(tex)
+        entryHash = mixHash(mixHash(entryHash, tex->getFlags()), tex->getContentHash());
+
+        for(int j = 0; j < entry->getNumPaletteIndicies(); j++)
+        {
+            int slot = entry->getPaletteIndex(j);
+            if(slot >= 0 && slot < slots)
+            hashes[slot] = mixHash(hashes[slot], entryHash);
+        }
+    }
+};
+
+void PaletteOptimizer::remapEntries(DriverD3D* d3d, const vector<int>& slotMap)
+{
+    for(int i = 0; i < d3d->getNumEntries(); i++)
+    {
+        D3DEntry* entry = d3d->getEntry(i);
+        for(int j = 0; j < entry->getNumPaletteIndicies(); j++)
+        {
+            int slot = entry->getPaletteIndex(j);
+            if(slot >= 0 && slot < (int)slotMap.size() && slotMap[slot] != slot)
+            entry->setPaletteIndex(j, slotMap[slot]);
+        }
+    }
+};
+
+int PaletteOptimizer::getNumMerges() const
+{
+    return merges.size();
+};
+
+const PaletteMerge* PaletteOptimizer::getMerge(int idx) const
+{
+    if(idx >= 0 && idx < (int)merges.size())
+    return &merges[idx];
+    return NULL;
+};
+
+int PaletteOptimizer::getNumSlotMoves() const
+{
+    return numSlotMoves;
+};
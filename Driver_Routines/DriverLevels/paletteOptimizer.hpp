@@ -0,0 +1,63 @@
+#ifndef PALETTE_OPTIMIZER_HPP
+#define PALETTE_OPTIMIZER_HPP
+
+#include "textures.hpp"
+#include "../driver_d3d.hpp"
+
+struct PaletteMerge
+{
+    int slot;
+    int target; //Always lower than slot.
+    int error;
+    bool reindex; //Pixels of the textures using slot are remapped through indexMap.
+    unsigned char indexMap[256];
+    unsigned long long slotHash; //State of both slots at analyze time, a merge is skipped if either changed.
+    unsigned long long targetHash;
+};
+
+//Clusters palettes that look alike and merges each cluster into its first palette. Only colours the textures
+//actually use are compared, weighted by how many pixels use them, so unused entries never block a merge.
+class PaletteOptimizer
+{
+    public:
+        PaletteOptimizer();
+
+        //Largest average colour error allowed for a merge, on the same 0-255 scale as a single channel.
+        void setTolerance(int tolerance);
+        int getTolerance() const;
+        //Lets palettes with the same colours in a different order merge by rewriting the texture pixels.
+        //Only done for textures that have a single palette and no transparency.
+        void setReindexTextures(bool reindex);
+        bool getReindexTextures() const;
+        //Renumbers the remaining palettes so the slots have no gaps.
+        void setCompactSlots(bool compact);
+        bool getCompactSlots() const;
+
+        void analyze(DriverTextures* textures, DriverD3D* d3d);
+        //Applies the result of the last analyze. Merges whose palettes or textures changed since are skipped.
+        //Returns the number of palettes removed.
+        int apply(DriverTextures* textures, DriverD3D* d3d);
+        void clear();
+
+        int getNumMerges() const;
+        const PaletteMerge* getMerge(int idx) const;
+        int getNumSlotMoves() const;
+
+        //Weighted "redmean" distance, squared and scaled by 2304 so the weights average to one per channel.
+        static int colorDistance(const color_4ub& a, const color_4ub& b);
+
+    protected:
+        int usageError(const DriverPalette* from, const DriverPalette* to, const unsigned int* usage, const unsigned char* indexMap) const;
+        void remapEntries(DriverD3D* d3d, const vector<int>& slotMap);
+        void hashSlots(DriverTextures* textures, DriverD3D* d3d, vector<unsigned long long>& hashes) const;
+
+        int tolerance;
+        bool reindexTextures;
+        bool compactSlots;
+
+        int numSlots;
+        int numSlotMoves;
+        vector<PaletteMerge> merges;
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "paletteRemap.hpp"
+
+static const unsigned char bayerMatrix[8][8] =
+{
+    { 0,32, 8,40, 2,34,10,42},
+    {48,16,56,24,50,18,58,26},
+    {12,44, 4,36,14,46, 6,38},
+    {60,28,52,20,62,30,54,22},
+    { 3,35,11,43, 1,33, 9,41},
+    {51,19,59,27,49,17,57,25},
+    {15,47, 7,39,13,45, 5,37},
+    {63,31,55,23,61,29,53,21}
+};
+
+static inline int clampChannel(int value)
+{
+    return (value < 0 ? 0 : (value > 255 ? 255 : value));
+};
+
+static inline int boxMinDistance(int value, int low, int high)
+{
+    int d = 0;
+    if(value < low)
+    d = low-value;
+    else if(value > high)
+    d = value-high;
+    return d*d;
+};
+
+static inline int boxMaxDistance(int value, int low, int high)
+{
+    int a = value-low;
+    int b = high-value;
+    return (a*a > b*b ? a*a : b*b);
+};
+
+PaletteRemapper::PaletteRemapper()
+{
+    cellStart = NULL;
+    candidates = NULL;
+    candidateRed = NULL;
+    candidateGreen = NULL;
+    candidateBlue = NULL;
+    dither = 0;
+};
+
+PaletteRemapper::PaletteRemapper(const DriverPalette* palette, int numColors)
+{
+    cellStart = NULL;
+    candidates = NULL;
+    candidateRed = NULL;
+    candidateGreen = NULL;
+    candidateBlue = NULL;
+    dither = 0;
+    setPalette(palette,numColors);
+};
+
+PaletteRemapper::~PaletteRemapper()
+{
+    cleanup();
+};
+
+void PaletteRemapper::cleanup()
+{
+    if(cellStart)
+    delete[] cellStart;
+    if(candidates)
+    delete[] candidates;
+    if(candidateRed)
+    delete[] candidateRed;
+    if(candidateGreen)
+    delete[] candidateGreen;
+    if(candidateBlue)
+    delete[] candidateBlue;
+
+    cellStart = NULL;
+    candidates = NULL;
+    candidateRed = NULL;
+    candidateGreen = NULL;
+    candidateBlue = NULL;
+};
+
+void PaletteRemapper::setPalette(const DriverPalette* palette, int numColors)
+{
+    cleanup();
+    if(!palette || numColors <= 0)
+    return;
+    if(numColors > 256)
+    numColors = 256;
+
+    //Repeated colours can never win over their first occurrence, so they are left out of every cell.
+    int numUnique = 0;
+    unsigned char unique[256];
+    for(int i = 0; i < numColors; i++)
+    {
+        const color_4ub& c = palette->colors[i];
+        bool repeated = false;
+        for(int j = 0; j < numUnique && !repeated; j++)
+        {
+            const color_4ub& o = palette->colors[unique[j]];
+            repeated = (o.r == c.r && o.g == c.g && o.b == c.b);
+        }
+        if(!repeated)
+        unique[numUnique++] = i;
+    }
+
+    //Distance bounds are separable, so each channel's share is worked out once per cell row and summed per cell.
+    //Kept on the heap, they are too big for the stacks of the worker threads this runs on.
+    vector<int> axisMin(3*REMAP_CELLS*256);
+    vector<int> axisMax(3*REMAP_CELLS*256);
+    for(int c = 0; c < REMAP_CELLS; c++)
+    {
+        int low = c*REMAP_CELL_SIZE;
+        int high = low+REMAP_CELL_SIZE-1;
+        for(int i = 0; i < numUnique; i++)
+        {
+            const color_4ub& color = palette->colors[unique[i]];
+            axisMin[(0*REMAP_CELLS+c)*256+i] = boxMinDistance(color.r,low,high);
+            axisMin[(1*REMAP_CELLS+c)*256+i] = boxMinDistance(color.g,low,high);
+            axisMin[(2*REMAP_CELLS+c)*256+i] = boxMinDistance(color.b,low,high);
+            axisMax[(0*REMAP_CELLS+c)*256+i] = boxMaxDistance(color.r,low,high);
+            axisMax[(1*REMAP_CELLS+c)*256+i] = boxMaxDistance(color.g,low,high);
+            axisMax[(2*REMAP_CELLS+c)*256+i] = boxMaxDistance(color.b,low,high);
+        }
+    }
+
+    vector<unsigned char> list;
+    list.reserve(REMAP_CELLS*REMAP_CELLS*REMAP_CELLS*8);
+    cellStart = new int[REMAP_CELLS*REMAP_CELLS*REMAP_CELLS+1];
+
+    int minDist[256];
+    int maxDist[256];
+    int cell = 0;
+    for(int r = 0; r < REMAP_CELLS; r++)
+    {
+        for(int g = 0; g < REMAP_CELLS; g++)
+        {
+            for(int b = 0; b < REMAP_CELLS; b++, cell++)
+            {
+                for(int i = 0; i < numUnique; i++)
+                {
+                    minDist[i] = axisMin[(0*REMAP_CELLS+r)*256+i]+axisMin[(1*REMAP_CELLS+g)*256+i]+axisMin[(2*REMAP_CELLS+b)*256+i];
+                    maxDist[i] = axisMax[(0*REMAP_CELLS+r)*256+i]+axisMax[(1*REMAP_CELLS+g)*256+i]+axisMax[(2*REMAP_CELLS+b)*256+i];
+                }
+
+                //Any entry closer to the whole cell than the best worst case of all entries may be nearest somewhere inside it.
+                int bestMax = 0x7FFFFFFF;
+                for(int i = 0; i < numUnique; i++)
+                {
+                    if(maxDist[i] < bestMax)
+                    bestMax = maxDist[i];
+                }
+
+                cellStart[cell] = list.size();
+                for(int i = 0; i < numUnique; i++)
+                {
+                    if(minDist[i] <= bestMax)
+                    list.push_back(unique[i]);
+                }
+            }
+        }
+    }
+    cellStart[cell] = list.size();
+
+    int numCandidates = list.size();
+    candidates = new unsigned char[numCandidates];
+    candidateRed = new int[numCandidates];
+    candidateGreen = new int[numCandidates];
+    candidateBlue = new int[numCandidates];
+    for(int i = 0; i < numCandidates; i++)
+    {
+        candidates[i] = list[i];
+        candidateRed[i] = palette->colors[list[i]].r;
+        candidateGreen[i] = palette->colors[list[i]].g;
+        candidateBlue[i] = palette->colors[list[i]].b;
+    }
+};
+
+void PaletteRemapper::setDither(int amount)
+{
+    dither = (amount < 0 ? 0 : amount);
+};
+
+int PaletteRemapper::getDither()
+{
+    return dither;
+};
+
+unsigned char PaletteRemapper::nearest(int r, int g, int b) const
+{
+    if(!cellStart)
+    return 0;
+
+    r = clampChannel(r);
+    g = clampChannel(g);
+    b = clampChannel(b);
+
+    int cell = (((r >> (8-REMAP_CELL_BITS)) << (REMAP_CELL_BITS*2)) | ((g >> (8-REMAP_CELL_BITS)) << REMAP_CELL_BITS) | (b >> (8-REMAP_CELL_BITS)));
+    int start = cellStart[cell];
+    int end = cellStart[cell+1];
+
+    int best = start;
+    int bestDist = 0x7FFFFFFF;
+    for(int i = start; i < end; i++)
+    {
+        int dr = candidateRed[i]-r;
+        int dg = candidateGreen[i]-g;
+        int db = candidateBlue[i]-b;
+        int dist = dr*dr+dg*dg+db*db;
+        if(dist < bestDist)
+        {
+            bestDist = dist;
+            best = i;
+        }
+    }
+    return candidates[best];
+};
+
+void PaletteRemapper::remapScanLine(const unsigned char* pixels, int bytesPerPixel, int redOffset, int greenOffset, int blueOffset, int width, int y, unsigned char* indices) const
+{
+    const unsigned char* ditherRow = bayerMatrix[y&7];
+    for(int x = 0; x < width; x++)
+    {
+        int offset = 0;
+        if(dither)
+        offset = ((ditherRow[x&7]*2+1)*dither)/64-dither;
+
+        indices[x] = nearest(pixels[redOffset]+offset, pixels[greenOffset]+offset, pixels[blueOffset]+offset);
+        pixels += bytesPerPixel;
+    }
+};
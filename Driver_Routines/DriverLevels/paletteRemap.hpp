@@ -0,0 +1,42 @@
+#ifndef PALETTE_REMAP_HPP
+#define PALETTE_REMAP_HPP
+
+#include "textures.hpp"
+
+//Colour space is split into REMAP_CELLS^3 cells, each with the list of palette entries that can be nearest to
+//some colour inside it. Lookups only measure those few entries, so results are exact without a full 24 bit table.
+const int REMAP_CELL_BITS = 4;
+const int REMAP_CELLS = 1 << REMAP_CELL_BITS;
+const int REMAP_CELL_SIZE = 256 >> REMAP_CELL_BITS;
+
+class PaletteRemapper
+{
+    public:
+        PaletteRemapper();
+        PaletteRemapper(const DriverPalette* palette, int numColors = 256);
+        ~PaletteRemapper();
+
+        //Only the first numColors entries are ever returned.
+        void setPalette(const DriverPalette* palette, int numColors = 256);
+        //Amount is the largest offset ordered dithering adds to a channel, 0 disables dithering.
+        void setDither(int amount);
+        int getDither();
+
+        unsigned char nearest(int r, int g, int b) const;
+        //Pixels are read with the given stride and channel offsets so BGR(A) images can be remapped in place.
+        void remapScanLine(const unsigned char* pixels, int bytesPerPixel, int redOffset, int greenOffset, int blueOffset, int width, int y, unsigned char* indices) const;
+
+    protected:
+        void cleanup();
+
+        //Candidates of each cell are stored one after another with their colours in separate channel arrays,
+        //so the distance loop reads sequential memory and can be vectorized by the compiler.
+        int* cellStart;
+        unsigned char* candidates;
+        int* candidateRed;
+        int* candidateGreen;
+        int* candidateBlue;
+        int dither;
+};
+
+#endif
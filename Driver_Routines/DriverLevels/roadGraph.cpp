@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include "roadGraph.hpp"
+
+RoadGraph::RoadGraph()
+{
+    clear();
+};
+
+void RoadGraph::clear()
+{
+    numNodes = 0;
+    usePositions = false;
+    positions.clear();
+    edgeStart.assign(1,0);
+    edges.clear();
+    components.clear();
+    componentSizes.clear();
+    issues.clear();
+};
+
+void RoadGraph::addIssue(int type, int intersection, int connection)
+{
+    RoadGraphIssue issue;
+    issue.type = type;
+    issue.intersection = intersection;
+    issue.connection = connection;
+    issues.push_back(issue);
+};
+
+void RoadGraph::build(DriverLevel* level)
+{
+    clear();
+    if(!level)
+        return;
+
+    numNodes = level->intersections.getNumIntersections();
+    usePositions = (level->intersectionPositions.getNumIntersections() >= numNodes);
+    positions.resize(numNodes);
+    if(usePositions)
+    {
+        for(int i = 0; i < numNodes; i++)
+        positions[i] = level->intersectionPositions.getPosition(i);
+    }
+
+    int numRoads = level->roadConnections.getNumRoads();
+    edgeStart.resize(numNodes+1);
+    for(int i = 0; i < numNodes; i++)
+    {
+        edgeStart[i] = edges.size();
+        Intersection* intersection = level->intersections.getIntersection(i);
+        for(int j = 0; j < 4; j++)
+        {
+            const IntersectionConnection& connection = intersection->connections[j];
+
+            //Unused slots hold -1.
+            if(connection.intersectionIndex < 0 && connection.roadIndex < 0)
+                continue;
+            if(connection.intersectionIndex < 0 || connection.intersectionIndex >= numNodes)
+            {
+                addIssue(ROAD_ISSUE_DANGLING,i,j);
+                continue;
+            }
+            if(connection.roadIndex < 0 || connection.roadIndex >= numRoads)
+            addIssue(ROAD_ISSUE_BAD_ROAD,i,j);
+
+            RoadGraphEdge edge;
+            edge.to = connection.intersectionIndex;
+            edge.road = connection.roadIndex;
+            edge.connection = j;
+            edge.length = 1.0f;
+            if(usePositions)
+            {
+                float dx = positions[edge.to].x-positions[i].x;
+                float dz = positions[edge.to].y-positions[i].y;
+                edge.length = sqrt(dx*dx+dz*dz);
+            }
+            edges.push_back(edge);
+        }
+    }
+    edgeStart[numNodes] = edges.size();
+
+    for(int i = 0; i < numNodes; i++)
+    {
+        for(int j = edgeStart[i]; j < edgeStart[i+1]; j++)
+        {
+            int to = edges[j].to;
+            bool found = false;
+            for(int k = edgeStart[to]; k < edgeStart[to+1] && !found; k++)
+            found = (edges[k].to == i);
+            if(!found)
+            addIssue(ROAD_ISSUE_ONE_WAY,i,edges[j].connection);
+        }
+    }
+
+    findComponents();
+};
+
+void RoadGraph::findComponents()
+{
+    //Edges are followed both ways, so collect the incoming links first.
+    vector<int> incomingStart(numNodes+1,0);
+    for(unsigned int i = 0; i < edges.size(); i++)
+    incomingStart[edges[i].to+1]++;
+    for(int i = 0; i < numNodes; i++)
+    incomingStart[i+1] += incomingStart[i];
+    vector<int> incoming(edges.size());
+    vector<int> next(incomingStart.begin(),incomingStart.end()-1);
+    for(int i = 0; i < numNodes; i++)
+    {
+        for(int j = edgeStart[i]; j < edgeStart[i+1]; j++)
+        incoming[next[edges[j].to]++] = i;
+    }
+
+    components.assign(numNodes,-1);
+    componentSizes.clear();
+    vector<int> stack;
+    for(int i = 0; i < numNodes; i++)
+    {
+        if(components[i] != -1)
+            continue;
+
+        int component = componentSizes.size();
+        int size = 0;
+        components[i] = component;
+        stack.push_back(i);
+        while(!stack.empty())
+        {
+            int node = stack.back();
+            stack.pop_back();
+            size++;
+            for(int j = edgeStart[node]; j < edgeStart[node+1]; j++)
+            {
+                if(components[edges[j].to] == -1)
+                {
+                    components[edges[j].to] = component;
+                    stack.push_back(edges[j].to);
+                }
+            }
+            for(int j = incomingStart[node]; j < incomingStart[node+1]; j++)
+            {
+                if(components[incoming[j]] == -1)
+                {
+                    components[incoming[j]] = component;
+                    stack.push_back(incoming[j]);
+                }
+            }
+        }
+        componentSizes.push_back(size);
+    }
+};
+
+float RoadGraph::estimate(int from, int to) const
+{
+    if(!usePositions)
+    return 0.0f;
+
+    float dx = positions[to].x-positions[from].x;
+    float dz = positions[to].y-positions[from].y;
+    return sqrt(dx*dx+dz*dz);
+};
+
+float RoadGraph::findPath(int from, int to, vector<int>* path) const
+{
+    if(path)
+    path->clear();
+    if(from < 0 || from >= numNodes || to < 0 || to >= numNodes)
+    return -1.0f;
+    if(components[from] != components[to])
+    return -1.0f;
+
+    vector<float> distance(numNodes,-1.0f);
+    vector<int> previous(numNodes,-1);
+    vector<bool> done(numNodes,false);
+
+    //Ordered by estimated total length, smallest first.
+    priority_queue<pair<float,int>, vector<pair<float,int> >, greater<pair<float,int> > > open;
+    distance[from] = 0.0f;
+    open.push(make_pair(estimate(from,to),from));
+    while(!open.empty())
+    {
+        int node = open.top().second;
+        open.pop();
+        if(done[node])
+            continue;
+        done[node] = true;
+        if(node == to)
+            break;
+
+        for(int i = edgeStart[node]; i < edgeStart[node+1]; i++)
+        {
+            const RoadGraphEdge& edge = edges[i];
+            float length = distance[node]+edge.length;
+            if(!done[edge.to] && (distance[edge.to] < 0.0f || length < distance[edge.to]))
+            {
+                distance[edge.to] = length;
+                previous[edge.to] = node;
+                open.push(make_pair(length+estimate(edge.to,to),edge.to));
+            }
+        }
+    }
+
+    if(!done[to])
+    return -1.0f;
+
+    if(path)
+    {
+        for(int node = to; node != -1; node = previous[node])
+        path->push_back(node);
+        reverse(path->begin(),path->end());
+    }
+    return distance[to];
+};
+
+int RoadGraph::getNumNodes() const
+{
+    return numNodes;
+};
+
+int RoadGraph::getNumEdges() const
+{
+    return edges.size();
+};
+
+int RoadGraph::getNumEdges(int node) const
+{
+    if(node >= 0 && node < numNodes)
+    return edgeStart[node+1]-edgeStart[node];
+    return 0;
+};
+
+const RoadGraphEdge* RoadGraph::getEdge(int node, int idx) const
+{
+    if(idx >= 0 && idx < getNumEdges(node))
+    return &edges[edgeStart[node]+idx];
+    return NULL;
+};
+
+int RoadGraph::getNumComponents() const
+{
+    return componentSizes.size();
+};
+
+int RoadGraph::getComponent(int node) const
+{
+    if(node >= 0 && node < numNodes)
+    return components[node];
+    return -1;
+};
+
+int RoadGraph::getComponentSize(int component) const
+{
+    if(component >= 0 && component < (int)componentSizes.size())
+    return componentSizes[component];
+    return 0;
+};
+
+int RoadGraph::getNumIssues() const
+{
+    return issues.size();
+};
+
+const RoadGraphIssue* RoadGraph::getIssue(int idx) const
+{
+    if(idx >= 0 && idx < (int)issues.size())
+    return &issues[idx];
+    return NULL;
+};
@@ -0,0 +1,71 @@
+#ifndef ROAD_GRAPH_HPP
+#define ROAD_GRAPH_HPP
+
+#include "../driver_levels.hpp"
+
+enum RoadGraphIssueType
+{
+    ROAD_ISSUE_DANGLING = 0, //Connection leads to an intersection that doesn't exist.
+    ROAD_ISSUE_ONE_WAY,      //Nothing leads back from the other intersection.
+    ROAD_ISSUE_BAD_ROAD      //Road index is outside the road connections.
+};
+
+struct RoadGraphIssue
+{
+    int type;
+    int intersection;
+    int connection;
+};
+
+struct RoadGraphEdge
+{
+    int to;
+    int road;
+    int connection;
+    float length;
+};
+
+//Directed graph of the intersections, linked through the connections of each intersection.
+//Edge lengths are the distances between intersection positions, or 1 where an intersection has no position, in which
+//case path finding falls back from A* to plain Dijkstra. Components treat every edge as two way.
+//The level raises no events, so rebuild after editing intersections or positions.
+class RoadGraph
+{
+    public:
+        RoadGraph();
+
+        void build(DriverLevel* level);
+        void clear();
+
+        int getNumNodes() const;
+        int getNumEdges() const;
+        int getNumEdges(int node) const;
+        const RoadGraphEdge* getEdge(int node, int idx) const;
+
+        //Length of the shortest path, storing the intersections along it from start to end in path.
+        //Returns -1 if there is no path.
+        float findPath(int from, int to, vector<int>* path = NULL) const;
+
+        int getNumComponents() const;
+        int getComponent(int node) const;
+        int getComponentSize(int component) const;
+
+        int getNumIssues() const;
+        const RoadGraphIssue* getIssue(int idx) const;
+
+    protected:
+        void addIssue(int type, int intersection, int connection);
+        void findComponents();
+        float estimate(int from, int to) const;
+
+        int numNodes;
+        vector<Vector2f> positions;
+        bool usePositions;
+        vector<int> edgeStart; //Edges of node i are edgeStart[i] to edgeStart[i+1]-1.
+        vector<RoadGraphEdge> edges;
+        vector<int> components;
+        vector<int> componentSizes;
+        vector<RoadGraphIssue> issues;
+};
+
+#endif
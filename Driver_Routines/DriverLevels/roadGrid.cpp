@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include "roadGrid.hpp"
+
+#define ROAD_GRID_MAX_CELLS 4096 //Per side.
+
+RoadGrid::RoadGrid()
+{
+    tileSize = 0.0f;
+    requestedCellSize = 0.0f;
+    clear();
+};
+
+float RoadGrid::getTileSize() const
+{
+    return tileSize;
+};
+
+void RoadGrid::setCellSize(float size)
+{
+    requestedCellSize = (size > 0.0f ? size : 0.0f);
+};
+
+float RoadGrid::getCellSize() const
+{
+    return grid.getCellSize();
+};
+
+void RoadGrid::clear()
+{
+    grid.clear();
+    roads.clear();
+    intersections.clear();
+    roadCells.clear();
+    intersectionCells.clear();
+};
+
+void RoadGrid::build(DriverLevel* level, float size)
+{
+    clear();
+    if(!level || size <= 0.0f)
+        return;
+
+    tileSize = size;
+
+    for(int i = 0; i < level->roadSections.getNumRoadSections(); i++)
+    {
+        RoadSection* section = level->roadSections.getRoadSection(i);
+        RoadSegment road;
+        road.x1 = section->tileStartX*tileSize;
+        road.z1 = section->tileStartZ*tileSize;
+        road.x2 = section->tileEndX*tileSize;
+        road.z2 = section->tileEndZ*tileSize;
+        roads.push_back(road);
+    }
+    for(int i = 0; i < level->intersectionPositions.getNumIntersections(); i++)
+    intersections.push_back(level->intersectionPositions.getPosition(i));
+
+    if(roads.empty() && intersections.empty())
+        return;
+
+    float minX = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxZ = -FLT_MAX;
+    for(unsigned int i = 0; i < roads.size(); i++)
+    {
+        minX = min(minX, min(roads[i].x1, roads[i].x2));
+        minZ = min(minZ, min(roads[i].z1, roads[i].z2));
+        maxX = max(maxX, max(roads[i].x1, roads[i].x2));
+        maxZ = max(maxZ, max(roads[i].z1, roads[i].z2));
+    }
+    for(unsigned int i = 0; i < intersections.size(); i++)
+    {
+        minX = min(minX, intersections[i].x);
+        minZ = min(minZ, intersections[i].y);
+        maxX = max(maxX, intersections[i].x);
+        maxZ = max(maxZ, intersections[i].y);
+    }
+
+    grid.setup(minX, minZ, maxX, maxZ, roads.size()+intersections.size(), requestedCellSize, ROAD_GRID_MAX_CELLS);
+    roadCells.assign(grid.getNumCells(), vector<int>());
+    intersectionCells.assign(grid.getNumCells(), vector<int>());
+
+    //Sections go in every cell their bounds touch, most are straight along x or z so this is rarely more than needed.
+    for(unsigned int i = 0; i < roads.size(); i++)
+    {
+        int x1,z1,x2,z2;
+        grid.getCellRange(min(roads[i].x1, roads[i].x2), min(roads[i].z1, roads[i].z2), max(roads[i].x1, roads[i].x2), max(roads[i].z1, roads[i].z2), &x1, &z1, &x2, &z2);
+        for(int z = z1; z <= z2; z++)
+        {
+            for(int x = x1; x <= x2; x++)
+            roadCells[z*grid.getNumCellsX()+x].push_back(i);
+        }
+    }
+    for(unsigned int i = 0; i < intersections.size(); i++)
+    intersectionCells[grid.getCell(intersections[i].x, intersections[i].y)].push_back(i);
+};
+
+int RoadGrid::getNumRoads() const
+{
+    return roads.size();
+};
+
+const RoadSegment* RoadGrid::getRoad(int idx) const
+{
+    if(idx >= 0 && idx < (int)roads.size())
+    return &roads[idx];
+    return NULL;
+};
+
+int RoadGrid::getNumIntersections() const
+{
+    return intersections.size();
+};
+
+float RoadGrid::getDistance(bool findRoads, int idx, float x, float z) const
+{
+    if(!findRoads)
+    return sqrt((intersections[idx].x-x)*(intersections[idx].x-x)+(intersections[idx].y-z)*(intersections[idx].y-z));
+
+    const RoadSegment& road = roads[idx];
+    float dx = road.x2-road.x1;
+    float dz = road.z2-road.z1;
+    float lengthSq = dx*dx+dz*dz;
+    float t = 0.0f;
+    if(lengthSq > 0.0f)
+    t = max(0.0f, min(1.0f, ((x-road.x1)*dx+(z-road.z1)*dz)/lengthSq));
+    float px = road.x1+dx*t-x;
+    float pz = road.z1+dz*t-z;
+    return sqrt(px*px+pz*pz);
+};
+
+//Searches rings of cells outwards from the point, like WorldModelGrid::findNearest. Every section is in each cell
+//its bounds touch, so the ring distance holds for them too.
+int RoadGrid::findNearest(bool findRoads, float x, float z, float maxDistance, float* distance) const
+{
+    const vector<vector<int> >& cells = (findRoads ? roadCells : intersectionCells);
+    if(cells.empty())
+        return -1;
+
+    int best = -1;
+    float bestDist = (maxDistance >= 0.0f ? maxDistance : FLT_MAX);
+    int centre = grid.getCell(x, z);
+    vector<int> ring;
+
+    for(int r = 0; r <= grid.getMaxRing(); r++)
+    {
+        if(grid.getRingDistance(r) > bestDist)
+            break;
+
+        grid.getRing(centre, r, ring);
+        for(unsigned int j = 0; j < ring.size(); j++)
+        {
+            const vector<int>& cell = cells[ring[j]];
+            for(unsigned int i = 0; i < cell.size(); i++)
+            {
+                float dist = getDistance(findRoads, cell[i], x, z);
+                if(dist < bestDist || (dist == bestDist && (best == -1 || cell[i] < best)))
+                {
+                    bestDist = dist;
+                    best = cell[i];
+                }
+            }
+        }
+    }
+
+    if(best != -1 && distance)
+    *distance = bestDist;
+    return best;
+};
+
+int RoadGrid::findNearestRoad(float x, float z, float maxDistance, float* distance) const
+{
+    return findNearest(true, x, z, maxDistance, distance);
+};
+
+int RoadGrid::findNearestIntersection(float x, float z, float maxDistance, float* distance) const
+{
+    return findNearest(false, x, z, maxDistance, distance);
+};
+
+//Clips the section against the rect, so sections crossing it without an end inside are found too.
+static bool segmentInRect(const RoadSegment& road, float minX, float minZ, float maxX, float maxZ)
+{
+    float t1 = 0.0f, t2 = 1.0f;
+    float start[2] = {road.x1, road.z1};
+    float delta[2] = {road.x2-road.x1, road.z2-road.z1};
+    float lower[2] = {minX, minZ};
+    float upper[2] = {maxX, maxZ};
+    for(int i = 0; i < 2; i++)
+    {
+        if(delta[i] == 0.0f)
+        {
+            if(start[i] < lower[i] || start[i] > upper[i])
+            return false;
+            continue;
+        }
+        float a = (lower[i]-start[i])/delta[i];
+        float b = (upper[i]-start[i])/delta[i];
+        t1 = max(t1, min(a,b));
+        t2 = min(t2, max(a,b));
+    }
+    return t1 <= t2;
+};
+
+int RoadGrid::findRoadsInRect(float minX, float minZ, float maxX, float maxZ, vector<int>& out) const
+{
+    if(roadCells.empty())
+        return 0;
+
+    int x1,z1,x2,z2;
+    unsigned int first = out.size();
+    grid.getCellRange(minX, minZ, maxX, maxZ, &x1, &z1, &x2, &z2);
+    for(int z = z1; z <= z2; z++)
+    {
+        for(int x = x1; x <= x2; x++)
+        {
+            const vector<int>& cell = roadCells[z*grid.getNumCellsX()+x];
+            for(unsigned int i = 0; i < cell.size(); i++)
+            {
+                if(segmentInRect(roads[cell[i]], minX, minZ, maxX, maxZ))
+                out.push_back(cell[i]);
+            }
+        }
+    }
+
+    //Sections spanning several cells are found once for each.
+    sort(out.begin()+first, out.end());
+    out.erase(unique(out.begin()+first, out.end()), out.end());
+    return out.size()-first;
+};
+
+int RoadGrid::findIntersectionsInRect(float minX, float minZ, float maxX, float maxZ, vector<int>& out) const
+{
+    if(intersectionCells.empty())
+        return 0;
+
+    int x1,z1,x2,z2;
+    int found = 0;
+    grid.getCellRange(minX, minZ, maxX, maxZ, &x1, &z1, &x2, &z2);
+    for(int z = z1; z <= z2; z++)
+    {
+        for(int x = x1; x <= x2; x++)
+        {
+            const vector<int>& cell = intersectionCells[z*grid.getNumCellsX()+x];
+            for(unsigned int i = 0; i < cell.size(); i++)
+            {
+                const Vector2f& pos = intersections[cell[i]];
+                if(pos.x >= minX && pos.x <= maxX && pos.y >= minZ && pos.y <= maxZ)
+                {
+                    out.push_back(cell[i]);
+                    found++;
+                }
+            }
+        }
+    }
+    return found;
+};
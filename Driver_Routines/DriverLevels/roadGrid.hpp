@@ -0,0 +1,54 @@
+#ifndef ROAD_GRID_HPP
+#define ROAD_GRID_HPP
+
+#include "../driver_levels.hpp"
+#include "uniformGrid.hpp"
+
+//Road section as a line in the same units as the intersection positions.
+struct RoadSegment
+{
+    float x1,z1,x2,z2;
+};
+
+//Uniform top down grid over the road sections and intersection positions for picking and snapping.
+//Sections are stored in tiles, so build scales them by the size of a tile in the units of the intersection positions.
+//Rebuild after editing either table.
+class RoadGrid
+{
+    public:
+        RoadGrid();
+
+        float getTileSize() const;
+        //Width of a cell, 0 picks one from the number of roads and intersections when building.
+        void setCellSize(float size);
+        float getCellSize() const;
+
+        void build(DriverLevel* level, float tileSize);
+        void clear();
+
+        int getNumRoads() const;
+        const RoadSegment* getRoad(int idx) const;
+        int getNumIntersections() const;
+
+        //Rect queries append section or intersection indices to out, each at most once, returning how many were added.
+        int findRoadsInRect(float minX, float minZ, float maxX, float maxZ, vector<int>& out) const;
+        int findIntersectionsInRect(float minX, float minZ, float maxX, float maxZ, vector<int>& out) const;
+        //Closest section or intersection to a point, -1 if there is none within maxDistance (negative for no limit).
+        //The distance found is stored in distance.
+        int findNearestRoad(float x, float z, float maxDistance = -1.0f, float* distance = NULL) const;
+        int findNearestIntersection(float x, float z, float maxDistance = -1.0f, float* distance = NULL) const;
+
+    protected:
+        float getDistance(bool roads, int idx, float x, float z) const;
+        int findNearest(bool roads, float x, float z, float maxDistance, float* distance) const;
+
+        float tileSize;
+        float requestedCellSize;
+        UniformGrid grid;
+        vector<RoadSegment> roads;
+        vector<Vector2f> intersections;
+        vector<vector<int> > roadCells;
+        vector<vector<int> > intersectionCells;
+};
+
+#endif
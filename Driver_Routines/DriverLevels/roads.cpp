@@ -48,6 +48,16 @@ int RoadTable::save(IOHandle handle, IOCallbacks* callbacks)
     return 0;
 };
 
+int RoadTable::getDataSize() const
+{
+    return compressedDataSize;
+};
+
+const unsigned char* RoadTable::getData() const
+{
+    return compressedData;
+};
+
 RoadTables::RoadTables()
 {
     numRoadTables = 0;
@@ -149,6 +159,45 @@ int RoadTables::load(IOHandle handle, IOCallbacks* callbacks, int size, DebugLog
     return 0;
 };
 
+int RoadTables::getNumTilesX() const
+{
+    return numTilesX;
+};
+
+int RoadTables::getNumTilesZ() const
+{
+    return numTilesZ;
+};
+
+int RoadTables::getNumSectorsX() const
+{
+    return numSectorsX;
+};
+
+int RoadTables::getNumSectorsZ() const
+{
+    return numSectorsZ;
+};
+
+int RoadTables::getNumRoadTables() const
+{
+    return numRoadTables;
+};
+
+RoadTable* RoadTables::getRoadTable(int idx)
+{
+    if(idx >= 0 && idx < numRoadTables)
+    return &roadTables[idx];
+    return NULL;
+};
+
+RoadTable* RoadTables::getRoadTable(int sectorX, int sectorZ)
+{
+    if(sectorX < 0 || sectorX >= numSectorsX || sectorZ < 0 || sectorZ >= numSectorsZ)
+    return NULL;
+    return getRoadTable(sectorZ*numSectorsX+sectorX);
+};
+
 unsigned int RoadTables::getRequiredSize()
 {
     unsigned int size = 0;
@@ -281,6 +330,18 @@ int RoadConnections::load(IOHandle handle, IOCallbacks* callbacks, int size, Deb
     return 0;
 };
 
+int RoadConnections::getNumRoads()
+{
+    return numRoads;
+};
+
+RoadConnection* RoadConnections::getRoad(int idx)
+{
+    if(idx >= 0 && idx < numRoads)
+    return &roadConnections[idx];
+    return NULL;
+};
+
 unsigned int RoadConnections::getRequiredSize()
 {
     return 4+numRoads*66;
@@ -347,6 +408,13 @@ int RoadSections::getNumRoadSections()
     return numRoadSections;
 };
 
+RoadSection* RoadSections::getRoadSection(int idx)
+{
+    if(idx >= 0 && idx < numRoadSections)
+    return &roadSections[idx];
+    return NULL;
+};
+
 int RoadSections::load(IOHandle handle, IOCallbacks* callbacks, int size, DebugLogger* log)
 {
     DebugLogger dummy;
@@ -449,6 +517,13 @@ int Intersections::getNumIntersections()
     return numIntersections;
 };
 
+Intersection* Intersections::getIntersection(int idx)
+{
+    if(idx >= 0 && idx < numIntersections)
+    return &intersections[idx];
+    return NULL;
+};
+
 int Intersections::load(IOHandle handle, IOCallbacks* callbacks, int size, DebugLogger* log)
 {
     DebugLogger dummy;
@@ -5,6 +5,7 @@
 #include "../ioFuncs.hpp"
 #include "../../Log_Routines/debug_logger.hpp"
 
+//A sector's compressed road tile table. Like DriverHeightmap, the payload is kept and saved as it was loaded.
 class RoadTable
 {
     public:
@@ -17,6 +18,9 @@ class RoadTable
         unsigned int getRequiredSize();
         int save(IOHandle handle, IOCallbacks* callbacks);
 
+        int getDataSize() const;
+        const unsigned char* getData() const;
+
     protected:
         int compressedDataSize;
         unsigned char* compressedData;
@@ -34,6 +38,15 @@ class RoadTables
         unsigned int getRequiredSize();
         int save(IOHandle handle, IOCallbacks* callbacks);
 
+        int getNumTilesX() const;
+        int getNumTilesZ() const;
+        int getNumSectorsX() const;
+        int getNumSectorsZ() const;
+        int getNumRoadTables() const;
+        RoadTable* getRoadTable(int idx);
+        //NULL outside the grid. Sectors without a table return an empty one.
+        RoadTable* getRoadTable(int sectorX, int sectorZ);
+
     protected:
         int numRoadTables;
         RoadTable* roadTables;
@@ -73,6 +86,8 @@ class RoadConnections
         unsigned int getRequiredSize();
         int save(IOHandle handle, IOCallbacks* callbacks);
 
+        int getNumRoads();
+        RoadConnection* getRoad(int idx);
     protected:
         int numRoads;
         RoadConnection* roadConnections;
@@ -102,6 +117,7 @@ class RoadSections
         int save(IOHandle handle, IOCallbacks* callbacks);
 
         int getNumRoadSections();
+        RoadSection* getRoadSection(int idx);
     protected:
         int numRoadSections;
         RoadSection* roadSections;
@@ -143,6 +159,7 @@ class Intersections
         int save(IOHandle handle, IOCallbacks* callbacks);
 
         int getNumIntersections();
+        Intersection* getIntersection(int idx);
     protected:
         int numIntersections;
         Intersection* intersections;
@@ -0,0 +1,132 @@
+#include "sectorBitset.hpp"
+
+SectorBitset::SectorBitset()
+{
+    size = 0;
+};
+
+SectorBitset::SectorBitset(int size)
+{
+    this->size = 0;
+    resize(size);
+};
+
+void SectorBitset::resize(int newSize)
+{
+    size = (newSize > 0 ? newSize : 0);
+    words.resize((size+63)/64, 0);
+    trim();
+};
+
+int SectorBitset::getSize() const
+{
+    return size;
+};
+
+void SectorBitset::clear()
+{
+    for(unsigned int i = 0; i < words.size(); i++)
+    words[i] = 0;
+};
+
+void SectorBitset::fill()
+{
+    for(unsigned int i = 0; i < words.size(); i++)
+    words[i] = ~0ULL;
+    trim();
+};
+
+//Bits past the size are kept clear so counts and comparisons can work on whole words.
+void SectorBitset::trim()
+{
+    if(size%64 && !words.empty())
+    words.back() &= (1ULL << (size%64))-1;
+};
+
+bool SectorBitset::test(int idx) const
+{
+    if(idx >= 0 && idx < size)
+    return (words[idx/64] >> (idx%64)) & 1;
+    return false;
+};
+
+void SectorBitset::set(int idx, bool value)
+{
+    if(idx >= 0 && idx < size)
+    {
+        if(value)
+        words[idx/64] |= 1ULL << (idx%64);
+        else words[idx/64] &= ~(1ULL << (idx%64));
+    }
+};
+
+int SectorBitset::count() const
+{
+    int total = 0;
+    for(unsigned int i = 0; i < words.size(); i++)
+    {
+        unsigned long long word = words[i];
+        word = word-((word >> 1) & 0x5555555555555555ULL);
+        word = (word & 0x3333333333333333ULL)+((word >> 2) & 0x3333333333333333ULL);
+        word = (word+(word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        total += (int)((word*0x0101010101010101ULL) >> 56);
+    }
+    return total;
+};
+
+int SectorBitset::list(vector<int>& out) const
+{
+    int found = 0;
+    for(unsigned int i = 0; i < words.size(); i++)
+    {
+        unsigned long long word = words[i];
+        for(int bit = 0; word; bit++, word >>= 1)
+        {
+            if(word & 1)
+            {
+                out.push_back(i*64+bit);
+                found++;
+            }
+        }
+    }
+    return found;
+};
+
+void SectorBitset::unite(const SectorBitset& other)
+{
+    unsigned int n = (words.size() < other.words.size() ? words.size() : other.words.size());
+    for(unsigned int i = 0; i < n; i++)
+    words[i] |= other.words[i];
+    trim();
+};
+
+void SectorBitset::intersect(const SectorBitset& other)
+{
+    for(unsigned int i = 0; i < words.size(); i++)
+    words[i] &= (i < other.words.size() ? other.words[i] : 0);
+};
+
+void SectorBitset::subtract(const SectorBitset& other)
+{
+    unsigned int n = (words.size() < other.words.size() ? words.size() : other.words.size());
+    for(unsigned int i = 0; i < n; i++)
+    words[i] &= ~other.words[i];
+};
+
+void SectorBitset::difference(const SectorBitset& other)
+{
+    unsigned int n = (words.size() < other.words.size() ? words.size() : other.words.size());
+    for(unsigned int i = 0; i < n; i++)
+    words[i] ^= other.words[i];
+    trim();
+};
+
+bool SectorBitset::operator==(const SectorBitset& other) const
+{
+    return size == other.size && words == other.words;
+};
+
+bool SectorBitset::operator!=(const SectorBitset& other) const
+{
+    return !(*this == other);
+};
@@ -0,0 +1,43 @@
+#ifndef SECTOR_BITSET_HPP
+#define SECTOR_BITSET_HPP
+
+#include <vector>
+
+using namespace std;
+
+//Set of sector indices, stored one bit per sector in 64 bit words so set operations work a word at a time.
+class SectorBitset
+{
+    public:
+        SectorBitset();
+        SectorBitset(int size);
+
+        void resize(int size);
+        int getSize() const;
+        void clear();
+        void fill();
+
+        bool test(int idx) const;
+        void set(int idx, bool value = true);
+        int count() const;
+        //Appends the indices of every set bit to out, lowest first, returning how many were added.
+        int list(vector<int>& out) const;
+
+        //Operations on two sets use the smaller size, bits past the end of other count as clear.
+        void unite(const SectorBitset& other);
+        void intersect(const SectorBitset& other);
+        void subtract(const SectorBitset& other);
+        //Sets the bits that differ between the two sets.
+        void difference(const SectorBitset& other);
+
+        bool operator==(const SectorBitset& other) const;
+        bool operator!=(const SectorBitset& other) const;
+
+    protected:
+        void trim();
+
+        int size;
+        vector<unsigned long long> words;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include "sectorTextureBuilder.hpp"
+
+SectorTextureBuilder::SectorTextureBuilder()
+{
+    clear();
+};
+
+void SectorTextureBuilder::clear()
+{
+    sectorTextures.clear();
+    texturesNeeded.clear();
+    changed.clear();
+    overflows.clear();
+    numChanged = 0;
+};
+
+//Sector a bridged definition belongs to, the one whose placements' bounds contain it or are nearest to it.
+static int findBridgedSector(const vector<float>& bounds, const Vector3f& position)
+{
+    int best = -1;
+    float bestDistance = 0.0f, bestArea = 0.0f;
+    for(unsigned int i = 0; i*4 < bounds.size(); i++)
+    {
+        const float* box = &bounds[i*4];
+        if(box[0] > box[2])
+            continue;
+
+        float dx = max(max(box[0]-position.x, position.x-box[2]), 0.0f);
+        float dz = max(max(box[1]-position.z, position.z-box[3]), 0.0f);
+        float distance = dx*dx+dz*dz;
+        float area = (box[2]-box[0])*(box[3]-box[1]);
+        if(best == -1 || distance < bestDistance || (distance == bestDistance && area < bestArea))
+        {
+            best = i;
+            bestDistance = distance;
+            bestArea = area;
+        }
+    }
+    return best;
+};
+
+void SectorTextureBuilder::analyze(DriverLevel* level)
+{
+    clear();
+    if(!level)
+        return;
+
+    //Resolve each model's textures once rather than for every placement.
+    vector<vector<int> > modelTextures(level->models.getNumModels());
+    for(int i = 0; i < level->models.getNumModels(); i++)
+    {
+        DriverModel* model = level->models.getReferencedModel(level->models.getModel(i));
+        if(!model)
+            continue;
+        for(int j = 0; j < model->getNumTexturesUsed(); j++)
+        {
+            int tex = model->getTextureUsed(j);
+            if(tex >= 0 && tex < 256)
+            modelTextures[i].push_back(tex);
+        }
+    }
+
+    int numSectors = min(level->world.getNumSectors(), 1024);
+    sectorTextures.resize(numSectors);
+    texturesNeeded.resize(numSectors, 0);
+    changed.resize(numSectors, false);
+
+    //Bridged definitions are stored outside the sectors, so each one is counted in the sector its position falls in.
+    vector<float> bounds(numSectors*4);
+    for(int i = 0; i < numSectors; i++)
+    {
+        WorldSector* sector = level->world.getSector(i);
+        float* box = &bounds[i*4];
+        box[0] = box[1] = 1e30f;
+        box[2] = box[3] = -1e30f;
+        for(int j = 0; j < sector->getNumModelDefs(); j++)
+        {
+            const Vector3f& pos = sector->getModelDef(j)->position;
+            box[0] = min(box[0], pos.x);
+            box[1] = min(box[1], pos.z);
+            box[2] = max(box[2], pos.x);
+            box[3] = max(box[3], pos.z);
+        }
+    }
+    vector<vector<int> > bridgedModels(numSectors);
+    for(int i = 0; i < level->world.getNumBridgedDefs(); i++)
+    {
+        WorldModelDef* def = level->world.getBridgedDef(i);
+        int sector = findBridgedSector(bounds, def->position);
+        if(sector != -1)
+        bridgedModels[sector].push_back(def->getModelIndex());
+    }
+
+    bool used[256];
+    for(int i = 0; i < numSectors; i++)
+    {
+        WorldSector* sector = level->world.getSector(i);
+        vector<int>& textures = sectorTextures[i];
+        memset(used, 0, sizeof(bool)*256);
+
+        vector<int> models = bridgedModels[i];
+        for(int j = 0; j < sector->getNumModelDefs(); j++)
+        models.push_back(sector->getModelDef(j)->getModelIndex());
+
+        for(unsigned int j = 0; j < models.size(); j++)
+        {
+            int modelIdx = models[j];
+            if(modelIdx < 0 || modelIdx >= (int)modelTextures.size())
+                continue;
+            for(unsigned int k = 0; k < modelTextures[modelIdx].size(); k++)
+            {
+                int tex = modelTextures[modelIdx][k];
+                if(!used[tex])
+                {
+                    used[tex] = true;
+                    textures.push_back(tex);
+                }
+            }
+        }
+        sort(textures.begin(), textures.end());
+
+        //Sectors that don't fit keep their current list, dropping textures would leave faces untextured.
+        texturesNeeded[i] = textures.size();
+        if((int)textures.size() > SECTOR_TEXTURE_LIMIT)
+        {
+            overflows.push_back(i);
+            continue;
+        }
+
+        //Current lists are compared as sets, their order doesn't matter to the game.
+        SectorTextureList* list = level->sectorTextures.getTextureList(i);
+        vector<int> current;
+        for(int j = 0; j < list->getNumTexturesUsed(); j++)
+        current.push_back(list->getTexture(j));
+        sort(current.begin(), current.end());
+        current.erase(unique(current.begin(), current.end()), current.end());
+        if(current != textures)
+        {
+            changed[i] = true;
+            numChanged++;
+        }
+    }
+};
+
+int SectorTextureBuilder::apply(DriverLevel* level)
+{
+    if(!level)
+    return 0;
+
+    for(unsigned int i = 0; i < sectorTextures.size(); i++)
+    {
+        if(!changed[i])
+            continue;
+
+        SectorTextureList* list = level->sectorTextures.getTextureList(i);
+        list->cleanup();
+        for(unsigned int j = 0; j < sectorTextures[i].size(); j++)
+        list->addTexture(sectorTextures[i][j]);
+    }
+    return numChanged;
+};
+
+int SectorTextureBuilder::getNumSectors() const
+{
+    return sectorTextures.size();
+};
+
+int SectorTextureBuilder::getNumTexturesNeeded(int sector) const
+{
+    if(sector >= 0 && sector < (int)texturesNeeded.size())
+    return texturesNeeded[sector];
+    return 0;
+};
+
+int SectorTextureBuilder::getNumChangedSectors() const
+{
+    return numChanged;
+};
+
+int SectorTextureBuilder::getNumOverflows() const
+{
+    return overflows.size();
+};
+
+int SectorTextureBuilder::getOverflowSector(int idx) const
+{
+    if(idx >= 0 && idx < (int)overflows.size())
+    return overflows[idx];
+    return -1;
+};
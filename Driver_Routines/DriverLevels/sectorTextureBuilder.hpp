@@ -0,0 +1,36 @@
+#ifndef SECTOR_TEXTURE_BUILDER_HPP
+#define SECTOR_TEXTURE_BUILDER_HPP
+
+#include "../driver_levels.hpp"
+
+//Rebuilds every sector's texture list from the textures used by the models placed in it.
+//Bridged definitions count towards the sector whose placements they lie among.
+//Sectors needing more than SECTOR_TEXTURE_LIMIT textures overflow, their lists are left unchanged and they are
+//reported so the sector can be split or simplified.
+class SectorTextureBuilder
+{
+    public:
+        SectorTextureBuilder();
+
+        void analyze(DriverLevel* level);
+        //Applies the result of the last analyze, which must have been run on the same level.
+        //Returns the number of sector lists that changed.
+        int apply(DriverLevel* level);
+        void clear();
+
+        int getNumSectors() const;
+        //Every texture the sector's models use, which can be more than fits in its list.
+        int getNumTexturesNeeded(int sector) const;
+        int getNumChangedSectors() const;
+        int getNumOverflows() const;
+        int getOverflowSector(int idx) const;
+
+    protected:
+        vector<vector<int> > sectorTextures; //Needed textures, sorted by index.
+        vector<int> texturesNeeded;
+        vector<bool> changed;
+        vector<int> overflows;
+        int numChanged;
+};
+
+#endif
@@ -0,0 +1,559 @@
+#include <map>
+#include <algorithm>
+#include "textureAtlas.hpp"
+
+struct SkylineSegment
+{
+    int x,y,w;
+};
+
+//Bottom left placement: the lowest position the rectangle fits at, leftmost on ties.
+static int findSkylinePosition(const vector<SkylineSegment>& skyline, int w, int h, int* bestX, int* bestY)
+{
+    int bestIdx = -1;
+    for(unsigned int i = 0; i < skyline.size(); i++)
+    {
+        int x = skyline[i].x;
+        if(x+w > 256)
+            break;
+
+        int y = 0;
+        int remaining = w;
+        for(unsigned int j = i; remaining > 0; j++)
+        {
+            y = max(y,skyline[j].y);
+            remaining -= skyline[j].w;
+        }
+        if(y+h <= 256 && (bestIdx == -1 || y < *bestY))
+        {
+            bestIdx = i;
+            *bestX = x;
+            *bestY = y;
+        }
+    }
+    return bestIdx;
+};
+
+static void addSkylineLevel(vector<SkylineSegment>& skyline, int idx, int x, int y, int w, int h)
+{
+    SkylineSegment segment;
+    segment.x = x;
+    segment.y = y+h;
+    segment.w = w;
+    skyline.insert(skyline.begin()+idx, segment);
+
+    for(unsigned int i = idx+1; i < skyline.size(); i++)
+    {
+        int overlap = x+w-skyline[i].x;
+        if(overlap <= 0)
+            break;
+        if(overlap < skyline[i].w)
+        {
+            skyline[i].x += overlap;
+            skyline[i].w -= overlap;
+            break;
+        }
+        skyline.erase(skyline.begin()+i);
+        i--;
+    }
+
+    for(unsigned int i = 1; i < skyline.size(); i++)
+    {
+        if(skyline[i-1].y == skyline[i].y)
+        {
+            skyline[i-1].w += skyline[i].w;
+            skyline.erase(skyline.begin()+i);
+            i--;
+        }
+    }
+};
+
+static bool compareBlockSize(const AtlasBlock& a, const AtlasBlock& b)
+{
+    if(a.h != b.h)
+    return a.h > b.h;
+    if(a.w != b.w)
+    return a.w > b.w;
+    if(a.texture != b.texture)
+    return a.texture < b.texture;
+    if(a.y != b.y)
+    return a.y < b.y;
+    return a.x < b.x;
+};
+
+static bool compareBlockPosition(const AtlasBlock& a, const AtlasBlock& b)
+{
+    if(a.texture != b.texture)
+    return a.texture < b.texture;
+    if(a.y != b.y)
+    return a.y < b.y;
+    return a.x < b.x;
+};
+
+TextureAtlasPacker::TextureAtlasPacker()
+{
+    padding = 0;
+    numPackedPages = 0;
+    numRejectedPages = 0;
+};
+
+void TextureAtlasPacker::setPadding(int pixels)
+{
+    padding = max(0,min(pixels,255));
+};
+
+int TextureAtlasPacker::getPadding() const
+{
+    return padding;
+};
+
+void TextureAtlasPacker::clear()
+{
+    blocks.clear();
+    pageStart.clear();
+    freedTextures.clear();
+    sectorOverflows.clear();
+    numPackedPages = 0;
+    numRejectedPages = 0;
+};
+
+//Returns false if a definition runs past the edge of the page, its block would be clipped and the definition lost.
+bool TextureAtlasPacker::findBlocks(DriverLevel* level, int texture, vector<AtlasBlock>& pageBlocks)
+{
+    bool inside = true;
+    int first = 0;
+    int last = level->textureDefinitions.getNumTextureDefinitions();
+    int count = 0;
+    int start = level->textureDefinitions.getTextureDefinitionRange(texture, &count);
+    if(start != -1)
+    {
+        first = start;
+        last = start+count;
+    }
+
+    for(int i = first; i < last; i++)
+    {
+        TextureDefinition* def = level->textureDefinitions.getTextureDefinition(i);
+        if(def->getTexture() != texture)
+            continue;
+        if(def->getX()+def->getW() > 255 || def->getY()+def->getH() > 255)
+        inside = false;
+
+        AtlasBlock block;
+        block.texture = texture;
+        block.x = def->getX();
+        block.y = def->getY();
+        block.w = min(def->getW(),255-block.x);
+        block.h = min(def->getH(),255-block.y);
+        block.newTexture = texture;
+        block.newX = block.x;
+        block.newY = block.y;
+        pageBlocks.push_back(block);
+    }
+
+    //Overlapping definitions have to stay together, so they are merged into their bounding block.
+    bool merged = true;
+    while(merged)
+    {
+        merged = false;
+        for(unsigned int i = 0; i < pageBlocks.size() && !merged; i++)
+        {
+            for(unsigned int j = i+1; j < pageBlocks.size() && !merged; j++)
+            {
+                AtlasBlock& a = pageBlocks[i];
+                const AtlasBlock& b = pageBlocks[j];
+                if(a.x <= b.x+b.w && b.x <= a.x+a.w && a.y <= b.y+b.h && b.y <= a.y+a.h)
+                {
+                    int x2 = max(a.x+a.w,b.x+b.w);
+                    int y2 = max(a.y+a.h,b.y+b.h);
+                    a.x = min(a.x,b.x);
+                    a.y = min(a.y,b.y);
+                    a.w = x2-a.x;
+                    a.h = y2-a.y;
+                    a.newX = a.x;
+                    a.newY = a.y;
+                    pageBlocks.erase(pageBlocks.begin()+j);
+                    merged = true;
+                }
+            }
+        }
+    }
+    return inside;
+};
+
+int TextureAtlasPacker::findBlock(int texture, int x1, int y1, int x2, int y2) const
+{
+    if(texture < 0 || texture+1 >= (int)pageStart.size())
+    return -1;
+
+    for(int i = pageStart[texture]; i < pageStart[texture+1]; i++)
+    {
+        const AtlasBlock& block = blocks[i];
+        if(x1 >= block.x && y1 >= block.y && x2 <= block.x+block.w && y2 <= block.y+block.h)
+        return i;
+    }
+    return -1;
+};
+
+bool TextureAtlasPacker::packGroup(const vector<int>& pages, vector<AtlasBlock>& groupBlocks)
+{
+    sort(groupBlocks.begin(), groupBlocks.end(), compareBlockSize);
+
+    vector<vector<SkylineSegment> > bins;
+    for(unsigned int i = 0; i < groupBlocks.size(); i++)
+    {
+        AtlasBlock& block = groupBlocks[i];
+        int w = min(block.w+1+padding,256);
+        int h = min(block.h+1+padding,256);
+
+        int x = 0, y = 0;
+        int segment = -1;
+        unsigned int bin = 0;
+        for(bin = 0; bin < bins.size() && segment == -1; bin++)
+        segment = findSkylinePosition(bins[bin], w, h, &x, &y);
+
+        if(segment == -1)
+        {
+            //Needing as many pages as we started with means there is nothing to gain.
+            if(bins.size()+1 >= pages.size())
+            return false;
+
+            SkylineSegment empty;
+            empty.x = 0;
+            empty.y = 0;
+            empty.w = 256;
+            bins.push_back(vector<SkylineSegment>(1,empty));
+            bin = bins.size();
+            segment = findSkylinePosition(bins.back(), w, h, &x, &y);
+        }
+        bin--;
+
+        addSkylineLevel(bins[bin], segment, x, y, w, h);
+        block.newTexture = pages[bin];
+        block.newX = x;
+        block.newY = y;
+    }
+
+    for(unsigned int i = bins.size(); i < pages.size(); i++)
+    freedTextures.push_back(pages[i]);
+    return true;
+};
+
+void TextureAtlasPacker::analyze(DriverLevel* level)
+{
+    clear();
+    if(!level)
+        return;
+
+    int numTextures = level->textures.getNumTextures();
+    vector<bool> candidate(numTextures,false);
+
+    pageStart.resize(numTextures+1,0);
+    for(int i = 0; i < numTextures; i++)
+    {
+        pageStart[i] = blocks.size();
+        const DriverTexture* tex = level->textures.getTexture(i);
+        if(tex->usesPalette() || tex->getCarNumber() != -1)
+            continue;
+
+        vector<AtlasBlock> pageBlocks;
+        bool inside = findBlocks(level, i, pageBlocks);
+        blocks.insert(blocks.end(), pageBlocks.begin(), pageBlocks.end());
+        candidate[i] = (inside && !pageBlocks.empty());
+        if(!inside)
+        numRejectedPages++;
+    }
+    pageStart[numTextures] = blocks.size();
+
+    for(int i = 0; i < level->models.getNumModels(); i++)
+    {
+        DriverModel* model = level->models.getModel(i);
+        for(int j = 0; j < model->getNumFaces(); j++)
+        {
+            ModelFace face = model->getFace(j);
+            if(!face.hasAttribute(FACE_TEXTURED) || face.texture < 0 || face.texture >= numTextures || !candidate[face.texture])
+                continue;
+
+            int numCoords = (face.hasAttribute(FACE_QUAD) ? 4 : 3);
+            int x1 = 255, y1 = 255, x2 = 0, y2 = 0;
+            for(int k = 0; k < numCoords; k++)
+            {
+                x1 = min(x1,(int)face.textureCoords[k].x);
+                y1 = min(y1,(int)face.textureCoords[k].y);
+                x2 = max(x2,(int)face.textureCoords[k].x);
+                y2 = max(y2,(int)face.textureCoords[k].y);
+            }
+            if(findBlock(face.texture, x1, y1, x2, y2) == -1)
+            {
+                candidate[face.texture] = false;
+                numRejectedPages++;
+            }
+        }
+    }
+
+    //Pages can only share pixels with pages that have the same flags.
+    map<unsigned short, vector<int> > groups;
+    for(int i = 0; i < numTextures; i++)
+    {
+        if(candidate[i])
+        groups[level->textures.getTexture(i)->getFlags()].push_back(i);
+    }
+
+    vector<AtlasBlock> packed;
+    for(map<unsigned short, vector<int> >::iterator it = groups.begin(); it != groups.end(); it++)
+    {
+        const vector<int>& pages = it->second;
+        if(pages.size() < 2)
+            continue;
+
+        vector<AtlasBlock> groupBlocks;
+        for(unsigned int i = 0; i < pages.size(); i++)
+        groupBlocks.insert(groupBlocks.end(), blocks.begin()+pageStart[pages[i]], blocks.begin()+pageStart[pages[i]+1]);
+
+        if(packGroup(pages, groupBlocks))
+        {
+            packed.insert(packed.end(), groupBlocks.begin(), groupBlocks.end());
+            numPackedPages += pages.size();
+        }
+    }
+    sort(freedTextures.begin(), freedTextures.end());
+
+    //Only the blocks that move are kept, grouped by their current page for findBlock.
+    sort(packed.begin(), packed.end(), compareBlockPosition);
+    blocks = packed;
+    unsigned int current = 0;
+    for(int i = 0; i <= numTextures; i++)
+    {
+        while(current < blocks.size() && blocks[current].texture < i)
+        current++;
+        pageStart[i] = current;
+    }
+
+    buildSectorLists(level, NULL, &sectorOverflows);
+};
+
+//Sectors that use a moved page will use every page its blocks go to. Only the lists that change are filled in,
+//the rest are left empty. Returns the number of sectors that would need more than SECTOR_TEXTURE_LIMIT textures.
+int TextureAtlasPacker::buildSectorLists(DriverLevel* level, vector<vector<int> >* lists, vector<int>* overflows) const
+{
+    int numTextures = level->textures.getNumTextures();
+    vector<vector<int> > destinations(numTextures);
+    for(unsigned int i = 0; i < blocks.size(); i++)
+    {
+        vector<int>& pageDestinations = destinations[blocks[i].texture];
+        if(find(pageDestinations.begin(), pageDestinations.end(), blocks[i].newTexture) == pageDestinations.end())
+        pageDestinations.push_back(blocks[i].newTexture);
+    }
+
+    int numOverflows = 0;
+    int numSectors = min(level->world.getNumSectors(), 1024);
+    if(lists)
+    lists->assign(numSectors, vector<int>());
+    for(int i = 0; i < numSectors; i++)
+    {
+        SectorTextureList* list = level->sectorTextures.getTextureList(i);
+        if(!list)
+            continue;
+
+        vector<int> used;
+        bool changed = false;
+        for(int j = 0; j < list->getNumTexturesUsed(); j++)
+        {
+            int tex = list->getTexture(j);
+            if(tex >= 0 && tex < numTextures && !destinations[tex].empty())
+            {
+                changed = true;
+                for(unsigned int k = 0; k < destinations[tex].size(); k++)
+                {
+                    if(find(used.begin(), used.end(), destinations[tex][k]) == used.end())
+                    used.push_back(destinations[tex][k]);
+                }
+            }
+            else if(find(used.begin(), used.end(), tex) == used.end())
+            used.push_back(tex);
+        }
+        if(!changed)
+            continue;
+
+        if((int)used.size() > SECTOR_TEXTURE_LIMIT)
+        {
+            numOverflows++;
+            if(overflows)
+            overflows->push_back(i);
+        }
+        if(lists)
+        (*lists)[i] = used;
+    }
+    return numOverflows;
+};
+
+int TextureAtlasPacker::apply(DriverLevel* level)
+{
+    if(!level || blocks.empty())
+    return 0;
+
+    vector<vector<int> > sectorLists;
+    if(buildSectorLists(level, &sectorLists, NULL) > 0)
+    return -1;
+
+    //Copies share their pixels with the level, and keep the old pixels once a page is overwritten.
+    map<int, DriverTexture> originals;
+    for(unsigned int i = 0; i < blocks.size(); i++)
+    {
+        if(originals.find(blocks[i].texture) == originals.end())
+        originals[blocks[i].texture] = *level->textures.getTexture(blocks[i].texture);
+    }
+
+    level->textures.beginChanges();
+    unsigned char* buffer = new unsigned char[256*256*2];
+    for(map<int, DriverTexture>::iterator it = originals.begin(); it != originals.end(); it++)
+    {
+        int page = it->first;
+        if(binary_search(freedTextures.begin(), freedTextures.end(), page))
+            continue;
+
+        memset(buffer,0,256*256*2);
+        for(unsigned int i = 0; i < blocks.size(); i++)
+        {
+            const AtlasBlock& block = blocks[i];
+            if(block.newTexture != page)
+                continue;
+
+            const unsigned char* source = originals[block.texture].getData();
+            for(int y = 0; y <= block.h; y++)
+            memcpy(buffer+((block.newY+y)*256+block.newX)*2, source+((block.y+y)*256+block.x)*2, (block.w+1)*2);
+        }
+
+        DriverTexture tex = it->second;
+        tex.setData(buffer);
+        level->textures.setTexture(page, &tex);
+    }
+    delete[] buffer;
+    level->textures.commitChanges();
+
+    for(int i = 0; i < level->textureDefinitions.getNumTextureDefinitions(); i++)
+    {
+        TextureDefinition def = *level->textureDefinitions.getTextureDefinition(i);
+        int b = findBlock(def.getTexture(), def.getX(), def.getY(), def.getX()+def.getW(), def.getY()+def.getH());
+        if(b == -1)
+            continue;
+
+        def.setTexture(blocks[b].newTexture);
+        def.setX(def.getX()-blocks[b].x+blocks[b].newX);
+        def.setY(def.getY()-blocks[b].y+blocks[b].newY);
+        level->textureDefinitions.setTextureDefinition(i, def);
+    }
+    //Definitions are kept sorted by texture.
+    for(int i = 0; i < level->textureDefinitions.getNumTextureDefinitions(); i++)
+    {
+        if(level->textureDefinitions.resortTextureDefinition(i) > i)
+        i--; //A definition moved further down, so another one is now at i.
+    }
+
+    for(int i = 0; i < level->models.getNumModels(); i++)
+    {
+        DriverModel* model = level->models.getModel(i);
+        bool changed = false;
+        for(int j = 0; j < model->getNumFaces(); j++)
+        {
+            ModelFace face = model->getFace(j);
+            if(!face.hasAttribute(FACE_TEXTURED))
+                continue;
+
+            int numCoords = (face.hasAttribute(FACE_QUAD) ? 4 : 3);
+            int x1 = 255, y1 = 255, x2 = 0, y2 = 0;
+            for(int k = 0; k < numCoords; k++)
+            {
+                x1 = min(x1,(int)face.textureCoords[k].x);
+                y1 = min(y1,(int)face.textureCoords[k].y);
+                x2 = max(x2,(int)face.textureCoords[k].x);
+                y2 = max(y2,(int)face.textureCoords[k].y);
+            }
+            int b = findBlock(face.texture, x1, y1, x2, y2);
+            if(b == -1)
+                continue;
+
+            for(int k = 0; k < numCoords; k++)
+            {
+                face.textureCoords[k].x += blocks[b].newX-blocks[b].x;
+                face.textureCoords[k].y += blocks[b].newY-blocks[b].y;
+            }
+            face.setTexture(blocks[b].newTexture);
+            model->setFace(j, face);
+            changed = true;
+        }
+        if(changed)
+        {
+            model->recalculateTexturesUsed();
+            level->models.markModelChanged(i);
+        }
+    }
+
+    for(unsigned int i = 0; i < sectorLists.size(); i++)
+    {
+        const vector<int>& used = sectorLists[i];
+        if(used.empty())
+            continue;
+
+        SectorTextureList* list = level->sectorTextures.getTextureList(i);
+        while(list->getNumTexturesUsed() > (int)used.size())
+        list->removeTexture(list->getNumTexturesUsed()-1);
+        for(unsigned int j = 0; j < used.size(); j++)
+        {
+            if((int)j < list->getNumTexturesUsed())
+            list->setTexture(j, used[j]);
+            else list->addTexture(used[j]);
+        }
+    }
+
+    int numFreed = freedTextures.size();
+    blocks.clear();
+    pageStart.clear();
+    return numFreed;
+};
+
+int TextureAtlasPacker::getNumBlocks() const
+{
+    return blocks.size();
+};
+
+int TextureAtlasPacker::getNumSectorOverflows() const
+{
+    return sectorOverflows.size();
+};
+
+int TextureAtlasPacker::getSectorOverflow(int idx) const
+{
+    if(idx >= 0 && idx < (int)sectorOverflows.size())
+    return sectorOverflows[idx];
+    return -1;
+};
+
+const AtlasBlock* TextureAtlasPacker::getBlock(int idx) const
+{
+    if(idx >= 0 && idx < (int)blocks.size())
+    return &blocks[idx];
+    return NULL;
+};
+
+int TextureAtlasPacker::getNumPackedPages() const
+{
+    return numPackedPages;
+};
+
+int TextureAtlasPacker::getNumRejectedPages() const
+{
+    return numRejectedPages;
+};
+
+int TextureAtlasPacker::getNumFreedTextures() const
+{
+    return freedTextures.size();
+};
+
+int TextureAtlasPacker::getFreedTexture(int idx) const
+{
+    if(idx >= 0 && idx < (int)freedTextures.size())
+    return freedTextures[idx];
+    return -1;
+};
@@ -0,0 +1,62 @@
+#ifndef TEXTURE_ATLAS_HPP
+#define TEXTURE_ATLAS_HPP
+
+#include "../driver_levels.hpp"
+
+//Rectangle of a texture page covered by one or more overlapping texture definitions.
+//Like the definitions, w and h are the offset of the last pixel, so a block is w+1 by h+1 pixels.
+struct AtlasBlock
+{
+    int texture;
+    int x,y,w,h;
+    int newTexture;
+    int newX,newY;
+};
+
+//Repacks the definitions of sparsely used 15 bit pages into as few pages as possible.
+//A page is only moved when every textured face on it stays inside a single block and no definition runs off the
+//page, otherwise pixels outside the blocks would be lost. Paletted and car textures are never moved.
+class TextureAtlasPacker
+{
+    public:
+        TextureAtlasPacker();
+
+        //Empty pixels kept to the right of and below each block, to stop filtering bleeding between them.
+        void setPadding(int pixels);
+        int getPadding() const;
+
+        void analyze(DriverLevel* level);
+        //Applies the result of the last analyze, which must have been run on the same level.
+        //Pixels, definitions, model faces and sector texture lists are moved onto the packed pages. The freed pages
+        //are no longer referenced by anything but are left in place, so the caller can remove them along with their D3D entries.
+        //Returns -1 without changing anything if a sector texture list would overflow.
+        int apply(DriverLevel* level);
+        void clear();
+
+        int getNumBlocks() const;
+        const AtlasBlock* getBlock(int idx) const;
+        int getNumPackedPages() const;
+        int getNumRejectedPages() const;
+        //Sectors whose texture list would grow past SECTOR_TEXTURE_LIMIT once their pages are split up.
+        int getNumSectorOverflows() const;
+        int getSectorOverflow(int idx) const;
+        //Sorted from lowest to highest.
+        int getNumFreedTextures() const;
+        int getFreedTexture(int idx) const;
+
+    protected:
+        bool findBlocks(DriverLevel* level, int texture, vector<AtlasBlock>& pageBlocks);
+        int buildSectorLists(DriverLevel* level, vector<vector<int> >* lists, vector<int>* overflows) const;
+        int findBlock(int texture, int x1, int y1, int x2, int y2) const;
+        bool packGroup(const vector<int>& pages, vector<AtlasBlock>& groupBlocks);
+
+        int padding;
+        int numPackedPages;
+        int numRejectedPages;
+        vector<AtlasBlock> blocks;
+        vector<int> pageStart; //Blocks are sorted by page, the ones on page i are pageStart[i] to pageStart[i+1]-1.
+        vector<int> freedTextures;
+        vector<int> sectorOverflows;
+};
+
+#endif
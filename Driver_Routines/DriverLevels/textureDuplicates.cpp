@@ -0,0 +1,156 @@
+#include <map>
+#include "textureDuplicates.hpp"
+
+TextureDuplicateFinder::TextureDuplicateFinder()
+{
+};
+
+void TextureDuplicateFinder::clear()
+{
+    textureDuplicates.clear();
+    paletteDuplicates.clear();
+};
+
+void TextureDuplicateFinder::find(DriverTextures* textures, DriverD3D* d3d, int paletteTolerance)
+{
+    clear();
+    if(!textures)
+    return;
+
+    findPalettes(textures, paletteTolerance);
+    findTextures(textures, d3d);
+};
+
+void TextureDuplicateFinder::findPalettes(DriverTextures* textures, int tolerance)
+{
+    //Slots are visited in order, so each palette is matched against the first palette of every group found so far.
+    vector<int> originals;
+    vector<unsigned long long> originalHashes;
+
+    int numSlots = 0;
+    for(int i = 0; i < textures->getNumPalettes(); i++)
+    {
+        if(textures->getPalette(i)->paletteNumber >= numSlots)
+        numSlots = textures->getPalette(i)->paletteNumber+1;
+    }
+
+    for(int slot = 0; slot < numSlots; slot++)
+    {
+        const DriverPalette* palette = textures->getIndexedPalette(slot);
+        if(!palette)
+            continue;
+
+        unsigned long long hash = palette->getContentHash();
+        int match = -1;
+        int difference = 0;
+        for(unsigned int i = 0; i < originals.size() && match == -1; i++)
+        {
+            if(originalHashes[i] == hash)
+            {
+                difference = palette->getMaxDifference(textures->getIndexedPalette(originals[i]));
+                if(difference == 0)
+                match = originals[i];
+            }
+        }
+        if(match == -1 && tolerance > 0)
+        {
+            for(unsigned int i = 0; i < originals.size() && match == -1; i++)
+            {
+                difference = palette->getMaxDifference(textures->getIndexedPalette(originals[i]));
+                if(difference <= tolerance)
+                match = originals[i];
+            }
+        }
+
+        if(match == -1)
+        {
+            originals.push_back(slot);
+            originalHashes.push_back(hash);
+        }
+        else
+        {
+            PaletteDuplicate duplicate;
+            duplicate.slot = slot;
+            duplicate.original = match;
+            duplicate.difference = difference;
+            paletteDuplicates.push_back(duplicate);
+        }
+    }
+};
+
+void TextureDuplicateFinder::findTextures(DriverTextures* textures, DriverD3D* d3d)
+{
+    multimap<unsigned long long, int> originals;
+
+    for(int i = 0; i < textures->getNumTextures(); i++)
+    {
+        const DriverTexture* tex = textures->getTexture(i);
+        unsigned long long hash = tex->getContentHash();
+
+        int match = -1;
+        pair<multimap<unsigned long long, int>::iterator, multimap<unsigned long long, int>::iterator> range = originals.equal_range(hash);
+        for(multimap<unsigned long long, int>::iterator it = range.first; it != range.second && match == -1; it++)
+        {
+            const DriverTexture* original = textures->getTexture(it->second);
+            if(original->getFlags() == tex->getFlags() && original->getCarNumber() == tex->getCarNumber() && original->hasSameData(tex))
+            match = it->second;
+        }
+
+        if(match == -1)
+        {
+            originals.insert(pair<unsigned long long, int>(hash, i));
+            continue;
+        }
+
+        TextureDuplicate duplicate;
+        duplicate.texture = i;
+        duplicate.original = match;
+        duplicate.type = DUPLICATE_EXACT;
+
+        //Paletted textures are only the same if every palette they use has the same colours.
+        if(tex->usesPalette())
+        {
+            duplicate.type = DUPLICATE_PALETTE_ONLY;
+            D3DEntry* entry = (d3d ? d3d->getTextureEntry(i) : NULL);
+            D3DEntry* originalEntry = (d3d ? d3d->getTextureEntry(match) : NULL);
+            if(entry && originalEntry && entry->getNumPaletteIndicies() == originalEntry->getNumPaletteIndicies())
+            {
+                bool samePalettes = true;
+                for(int j = 0; j < entry->getNumPaletteIndicies() && samePalettes; j++)
+                {
+                    const DriverPalette* a = textures->getIndexedPalette(entry->getPaletteIndex(j));
+                    const DriverPalette* b = textures->getIndexedPalette(originalEntry->getPaletteIndex(j));
+                    if(a != b)
+                    samePalettes = (a && b && a->getMaxDifference(b) == 0);
+                }
+                if(samePalettes)
+                duplicate.type = DUPLICATE_EXACT;
+            }
+        }
+        textureDuplicates.push_back(duplicate);
+    }
+};
+
+int TextureDuplicateFinder::getNumTextureDuplicates() const
+{
+    return textureDuplicates.size();
+};
+
+const TextureDuplicate* TextureDuplicateFinder::getTextureDuplicate(int idx) const
+{
+    if(idx >= 0 && idx < (int)textureDuplicates.size())
+    return &textureDuplicates[idx];
+    return NULL;
+};
+
+int TextureDuplicateFinder::getNumPaletteDuplicates() const
+{
+    return paletteDuplicates.size();
+};
+
+const PaletteDuplicate* TextureDuplicateFinder::getPaletteDuplicate(int idx) const
+{
+    if(idx >= 0 && idx < (int)paletteDuplicates.size())
+    return &paletteDuplicates[idx];
+    return NULL;
+};
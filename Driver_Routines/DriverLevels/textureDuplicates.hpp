@@ -0,0 +1,48 @@
+#ifndef TEXTURE_DUPLICATES_HPP
+#define TEXTURE_DUPLICATES_HPP
+
+#include "textures.hpp"
+#include "../driver_d3d.hpp"
+
+const int DUPLICATE_EXACT = 0;
+const int DUPLICATE_PALETTE_ONLY = 1; //Same pixels and flags, but the textures use different palettes.
+
+struct TextureDuplicate
+{
+    int texture;
+    int original; //Always lower than texture.
+    int type;
+};
+
+struct PaletteDuplicate
+{
+    int slot;
+    int original; //Always lower than slot.
+    int difference;
+};
+
+//Finds textures and palettes with the same content. Candidates are grouped by content hash first, so only
+//textures that hash the same are ever compared byte for byte.
+class TextureDuplicateFinder
+{
+    public:
+        TextureDuplicateFinder();
+
+        void find(DriverTextures* textures, DriverD3D* d3d, int paletteTolerance = 0);
+        void clear();
+
+        int getNumTextureDuplicates() const;
+        const TextureDuplicate* getTextureDuplicate(int idx) const;
+
+        int getNumPaletteDuplicates() const;
+        const PaletteDuplicate* getPaletteDuplicate(int idx) const;
+
+    protected:
+        void findPalettes(DriverTextures* textures, int tolerance);
+        void findTextures(DriverTextures* textures, DriverD3D* d3d);
+
+        vector<TextureDuplicate> textureDuplicates;
+        vector<PaletteDuplicate> paletteDuplicates;
+};
+
+#endif
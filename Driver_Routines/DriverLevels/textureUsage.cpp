@@ -0,0 +1,343 @@
+#include <algorithm>
+#include "textureUsage.hpp"
+
+TextureUsageIndex::TextureUsageIndex()
+{
+    level = NULL;
+    sectorsDirty = true;
+    definitionsDirty = true;
+};
+
+TextureUsageIndex::~TextureUsageIndex()
+{
+    unregisterHandlers();
+};
+
+void TextureUsageIndex::setLevel(DriverLevel* lev)
+{
+    unregisterHandlers();
+    level = lev;
+    registerHandlers();
+    rebuildModels();
+};
+
+void TextureUsageIndex::registerHandlers()
+{
+    if(level)
+    {
+        level->registerEventHandler(this);
+        level->textures.registerEventHandler(this);
+        level->models.registerEventHandler(this);
+        level->textureDefinitions.registerEventHandler(this);
+    }
+};
+
+void TextureUsageIndex::unregisterHandlers()
+{
+    if(level)
+    {
+        level->unregisterEventHandler(this);
+        level->textures.unregisterEventHandler(this);
+        level->models.unregisterEventHandler(this);
+        level->textureDefinitions.unregisterEventHandler(this);
+    }
+};
+
+void TextureUsageIndex::clear()
+{
+    modelTextures.clear();
+    textureModels.clear();
+    textureSectors.clear();
+    textureDefinitions.clear();
+    sectorsDirty = true;
+    definitionsDirty = true;
+};
+
+void TextureUsageIndex::insertSorted(vector<int>& list, int value)
+{
+    vector<int>::iterator it = lower_bound(list.begin(), list.end(), value);
+    if(it == list.end() || *it != value)
+    list.insert(it, value);
+};
+
+void TextureUsageIndex::eraseSorted(vector<int>& list, int value)
+{
+    vector<int>::iterator it = lower_bound(list.begin(), list.end(), value);
+    if(it != list.end() && *it == value)
+    list.erase(it);
+};
+
+void TextureUsageIndex::rebuildModels()
+{
+    clear();
+    if(!level)
+        return;
+
+    textureModels.resize(level->textures.getNumTextures());
+    modelTextures.resize(level->models.getNumModels());
+    for(int i = 0; i < level->models.getNumModels(); i++)
+    addModel(i);
+};
+
+void TextureUsageIndex::addModel(int idx)
+{
+    DriverModel* model = level->models.getModel(idx);
+    vector<int>& textures = modelTextures[idx];
+    textures.clear();
+    for(int i = 0; i < model->getNumTexturesUsed(); i++)
+    {
+        int tex = model->getTextureUsed(i);
+        if(tex < 0 || tex >= (int)textureModels.size())
+            continue;
+        insertSorted(textures, tex);
+    }
+    for(unsigned int i = 0; i < textures.size(); i++)
+    insertSorted(textureModels[textures[i]], idx);
+};
+
+void TextureUsageIndex::removeModel(int idx)
+{
+    vector<int>& textures = modelTextures[idx];
+    for(unsigned int i = 0; i < textures.size(); i++)
+    eraseSorted(textureModels[textures[i]], idx);
+    textures.clear();
+};
+
+//mapping holds the new index of every old texture, -1 for a removed one.
+void TextureUsageIndex::remapTextures(const vector<int>& mapping)
+{
+    for(unsigned int i = 0; i < modelTextures.size(); i++)
+    {
+        vector<int>& textures = modelTextures[i];
+        for(unsigned int j = 0; j < textures.size(); j++)
+        {
+            if(textures[j] < (int)mapping.size())
+            textures[j] = mapping[textures[j]];
+        }
+        textures.erase(remove(textures.begin(), textures.end(), -1), textures.end());
+        sort(textures.begin(), textures.end());
+    }
+
+    textureModels.assign(level->textures.getNumTextures(), vector<int>());
+    for(unsigned int i = 0; i < modelTextures.size(); i++)
+    {
+        for(unsigned int j = 0; j < modelTextures[i].size(); j++)
+        {
+            if(modelTextures[i][j] < (int)textureModels.size())
+            textureModels[modelTextures[i][j]].push_back(i);
+        }
+    }
+    sectorsDirty = true;
+    definitionsDirty = true;
+};
+
+void TextureUsageIndex::refreshSectors()
+{
+    if(!sectorsDirty || !level)
+        return;
+
+    textureSectors.assign(level->textures.getNumTextures(), vector<int>());
+    for(int i = 0; i < level->world.getNumSectors(); i++)
+    {
+        SectorTextureList* list = level->sectorTextures.getTextureList(i);
+        if(!list)
+            continue;
+        for(int j = 0; j < list->getNumTexturesUsed(); j++)
+        {
+            int tex = list->getTexture(j);
+            if(tex >= 0 && tex < (int)textureSectors.size() && (textureSectors[tex].empty() || textureSectors[tex].back() != i))
+            textureSectors[tex].push_back(i);
+        }
+    }
+    sectorsDirty = false;
+};
+
+void TextureUsageIndex::refreshDefinitions()
+{
+    if(!definitionsDirty || !level)
+        return;
+
+    textureDefinitions.assign(level->textures.getNumTextures(), vector<int>());
+    for(int i = 0; i < level->textureDefinitions.getNumTextureDefinitions(); i++)
+    {
+        int tex = level->textureDefinitions.getTextureDefinition(i)->getTexture();
+        if(tex >= 0 && tex < (int)textureDefinitions.size())
+        textureDefinitions[tex].push_back(i);
+    }
+    definitionsDirty = false;
+};
+
+const vector<int>& TextureUsageIndex::getModels(int texture)
+{
+    if(texture >= 0 && texture < (int)textureModels.size())
+    return textureModels[texture];
+    return empty;
+};
+
+const vector<int>& TextureUsageIndex::getSectors(int texture)
+{
+    refreshSectors();
+    if(texture >= 0 && texture < (int)textureSectors.size())
+    return textureSectors[texture];
+    return empty;
+};
+
+const vector<int>& TextureUsageIndex::getDefinitions(int texture)
+{
+    refreshDefinitions();
+    if(texture >= 0 && texture < (int)textureDefinitions.size())
+    return textureDefinitions[texture];
+    return empty;
+};
+
+bool TextureUsageIndex::isTextureUsed(int texture)
+{
+    return !getModels(texture).empty() || !getSectors(texture).empty() || !getDefinitions(texture).empty();
+};
+
+void TextureUsageIndex::invalidateSectors()
+{
+    sectorsDirty = true;
+};
+
+void TextureUsageIndex::levelDestroyed()
+{
+    level = NULL;
+    clear();
+};
+
+void TextureUsageIndex::levelReset(bool aboutToBe)
+{
+    if(!aboutToBe)
+    rebuildModels();
+};
+
+void TextureUsageIndex::levelOpened()
+{
+    rebuildModels();
+};
+
+void TextureUsageIndex::texturesDestroyed()
+{
+    clear();
+};
+
+void TextureUsageIndex::texturesReset(bool aboutToBe)
+{
+    if(!aboutToBe)
+    rebuildModels();
+};
+
+void TextureUsageIndex::texturesOpened()
+{
+    rebuildModels();
+};
+
+void TextureUsageIndex::textureInserted(int idx)
+{
+    vector<int> mapping(level->textures.getNumTextures()-1);
+    for(int i = 0; i < (int)mapping.size(); i++)
+    mapping[i] = (i >= idx ? i+1 : i);
+    remapTextures(mapping);
+};
+
+void TextureUsageIndex::textureRemoved(int idx)
+{
+    vector<int> mapping(level->textures.getNumTextures()+1);
+    for(int i = 0; i < (int)mapping.size(); i++)
+    mapping[i] = (i == idx ? -1 : (i > idx ? i-1 : i));
+    remapTextures(mapping);
+};
+
+void TextureUsageIndex::textureMoved(int from, int to)
+{
+    vector<int> mapping(level->textures.getNumTextures());
+    for(int i = 0; i < (int)mapping.size(); i++)
+    {
+        if(i == from)
+        mapping[i] = to;
+        else if(from < to && i > from && i <= to)
+        mapping[i] = i-1;
+        else if(from > to && i >= to && i < from)
+        mapping[i] = i+1;
+        else mapping[i] = i;
+    }
+    remapTextures(mapping);
+};
+
+void TextureUsageIndex::modelsDestroyed(ModelContainer* container)
+{
+    if(level && container == &level->models)
+    clear();
+};
+
+void TextureUsageIndex::modelsReset(ModelContainer* container, bool aboutToBe)
+{
+    if(level && container == &level->models && !aboutToBe)
+    rebuildModels();
+};
+
+void TextureUsageIndex::modelsOpened(ModelContainer* container)
+{
+    if(level && container == &level->models)
+    rebuildModels();
+};
+
+void TextureUsageIndex::modelInserted(ModelContainer* container, int idx)
+{
+    if(!level || container != &level->models)
+        return;
+
+    for(unsigned int i = 0; i < textureModels.size(); i++)
+    {
+        vector<int>& models = textureModels[i];
+        for(vector<int>::iterator it = lower_bound(models.begin(), models.end(), idx); it != models.end(); it++)
+        (*it)++;
+    }
+    modelTextures.insert(modelTextures.begin()+idx, vector<int>());
+    addModel(idx);
+};
+
+void TextureUsageIndex::modelChanged(ModelContainer* container, int idx)
+{
+    if(!level || container != &level->models || idx < 0 || idx >= (int)modelTextures.size())
+        return;
+
+    removeModel(idx);
+    addModel(idx);
+};
+
+void TextureUsageIndex::definitionsDestroyed()
+{
+    definitionsDirty = true;
+};
+
+void TextureUsageIndex::definitionsReset(bool /*aboutToBe*/)
+{
+    definitionsDirty = true;
+};
+
+void TextureUsageIndex::definitionsOpened()
+{
+    definitionsDirty = true;
+};
+
+void TextureUsageIndex::definitionMoved(int /*fromIdx*/, int /*toIdx*/)
+{
+    definitionsDirty = true;
+};
+
+void TextureUsageIndex::definitionRemoved(int /*whichIdx*/)
+{
+    definitionsDirty = true;
+};
+
+void TextureUsageIndex::definitionsInserted(int /*whereIdx*/, int /*count*/)
+{
+    definitionsDirty = true;
+};
+
+void TextureUsageIndex::definitionChanged(int /*whichIdx*/)
+{
+    definitionsDirty = true;
+};
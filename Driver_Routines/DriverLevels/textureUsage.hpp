@@ -0,0 +1,76 @@
+#ifndef TEXTURE_USAGE_HPP
+#define TEXTURE_USAGE_HPP
+
+#include "../driver_levels.hpp"
+
+//Maps each texture to the models, sectors and texture definitions that use it.
+//Models are tracked through their texture used lists and updated one at a time from model events, so callers that
+//edit faces must call recalculateTexturesUsed and ModelContainer::markModelChanged. Sector and definition lists are
+//cheap to build, so they are rebuilt on the next query after anything that could change them.
+class TextureUsageIndex : public IDriverLevelEvents, public IDriverTextureEvents, public IDriverModelEvents, public IDriverTexDefEvents
+{
+    public:
+        TextureUsageIndex();
+        ~TextureUsageIndex();
+
+        void setLevel(DriverLevel* lev);
+
+        //Lists are sorted and stay valid until the level changes.
+        const vector<int>& getModels(int texture);
+        const vector<int>& getSectors(int texture);
+        const vector<int>& getDefinitions(int texture);
+        bool isTextureUsed(int texture);
+
+        //SectorTextureList raises no events, call this after editing one directly.
+        void invalidateSectors();
+
+        void levelDestroyed();
+        void levelReset(bool aboutToBe);
+        void levelOpened();
+
+        void texturesDestroyed();
+        void texturesReset(bool aboutToBe);
+        void texturesOpened();
+        void textureInserted(int idx);
+        void textureRemoved(int idx);
+        void textureMoved(int from, int to);
+
+        void modelsDestroyed(ModelContainer* container);
+        void modelsReset(ModelContainer* container, bool aboutToBe);
+        void modelsOpened(ModelContainer* container);
+        void modelInserted(ModelContainer* container, int idx);
+        void modelChanged(ModelContainer* container, int idx);
+
+        void definitionsDestroyed();
+        void definitionsReset(bool aboutToBe);
+        void definitionsOpened();
+        void definitionMoved(int fromIdx, int toIdx);
+        void definitionRemoved(int whichIdx);
+        void definitionsInserted(int whereIdx, int count);
+        void definitionChanged(int whichIdx);
+
+    protected:
+        void registerHandlers();
+        void unregisterHandlers();
+        void clear();
+        void rebuildModels();
+        void addModel(int idx);
+        void removeModel(int idx);
+        void remapTextures(const vector<int>& mapping);
+        void refreshSectors();
+        void refreshDefinitions();
+        static void insertSorted(vector<int>& list, int value);
+        static void eraseSorted(vector<int>& list, int value);
+
+        DriverLevel* level;
+
+        vector<vector<int> > modelTextures;
+        vector<vector<int> > textureModels;
+        vector<vector<int> > textureSectors;
+        vector<vector<int> > textureDefinitions;
+        bool sectorsDirty;
+        bool definitionsDirty;
+        vector<int> empty;
+};
+
+#endif
@@ -1,5 +1,17 @@
+#include <cstdlib>
 #include "textures.hpp"
 
+//Palettes are stored as BGRA, so red and blue are swapped for a whole palette at once.
+static void swizzlePalette(color_4ub* colors)
+{
+    for(int j = 0; j < 256; j++)
+    {
+        unsigned char temp = colors[j].r;
+        colors[j].r = colors[j].b;
+        colors[j].b = temp;
+    }
+};
+
 TextureDefinition::TextureDefinition()
 {
     memset(name,0,9);
@@ -94,6 +106,7 @@ TextureDefinitions::TextureDefinitions()
 {
     numTextureDefinitions = 0;
     definitions = NULL;
+    rebuildIndex();
 };
 
 TextureDefinitions::~TextureDefinitions()
@@ -123,6 +136,7 @@ void TextureDefinitions::cleanup()
     delete[] definitions;
     definitions = NULL;
     numTextureDefinitions = 0;
+    rebuildIndex();
 
     //Raise definitions have been reset event.
     eventManager.Raise(EVENT(IDriverTexDefEvents::definitionsReset)(false));
@@ -169,6 +183,7 @@ int TextureDefinitions::load(IOHandle handle, IOCallbacks* callbacks, int size,
                  i, definitions[i].texture, definitions[i].x, definitions[i].y, definitions[i].w, definitions[i].h, definitions[i].getName());
     }
     log->decreaseIndent();
+    rebuildIndex();
 
     //Raise definitions opened event.
     eventManager.Raise(EVENT(IDriverTexDefEvents::definitionsOpened)());
@@ -226,19 +241,110 @@ TextureDefinition* TextureDefinitions::getTextureDefinition(int idx)
 
 int TextureDefinitions::findTextureDefByName(const char* name)
 {
-    for(int i = 0; i < numTextureDefinitions; i++)
+    if(!name)
+    return -1;
+
+    const vector<int>& bucket = nameBuckets[hashName(name) & (nameBuckets.size()-1)];
+    for(unsigned int i = 0; i < bucket.size(); i++)
     {
-        if(strncmp(definitions[i].getName(),name,8) == 0)
-        return i;
+        if(strncmp(definitions[bucket[i]].getName(),name,8) == 0)
+        return bucket[i];
     }
     return -1;
 };
 
+int TextureDefinitions::getTextureDefinitionRange(int texture, int* count)
+{
+    if(count)
+    *count = 0;
+    if(texture < 0 || texture > 255 || numUnsorted > 0)
+    return -1;
+
+    if(!textureStartsValid)
+    {
+        int start = 0;
+        for(int i = 0; i < 256; i++)
+        {
+            textureStarts[i] = start;
+            start += textureCounts[i];
+        }
+        textureStartsValid = true;
+    }
+    if(count)
+    *count = textureCounts[texture];
+    return textureStarts[texture];
+};
+
+bool TextureDefinitions::isSortedByTexture()
+{
+    return numUnsorted == 0;
+};
+
+//Only the first 8 characters are hashed, matching the strncmp in findTextureDefByName.
+unsigned int TextureDefinitions::hashName(const char* name)
+{
+    unsigned int hash = 2166136261U;
+    for(int i = 0; i < 8 && name[i]; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619U;
+    }
+    return hash;
+};
+
+void TextureDefinitions::addToIndex(int idx)
+{
+    vector<int>& bucket = nameBuckets[hashName(definitions[idx].getName()) & (nameBuckets.size()-1)];
+    bucket.insert(lower_bound(bucket.begin(), bucket.end(), idx), idx);
+    textureCounts[definitions[idx].texture]++;
+    textureStartsValid = false;
+};
+
+void TextureDefinitions::removeFromIndex(int idx)
+{
+    vector<int>& bucket = nameBuckets[hashName(definitions[idx].getName()) & (nameBuckets.size()-1)];
+    vector<int>::iterator it = lower_bound(bucket.begin(), bucket.end(), idx);
+    if(it != bucket.end() && *it == idx)
+    bucket.erase(it);
+    textureCounts[definitions[idx].texture]--;
+    textureStartsValid = false;
+};
+
+int TextureDefinitions::countUnsorted(int first, int last)
+{
+    int count = 0;
+    for(int i = max(first,0); i <= last && i < numTextureDefinitions-1; i++)
+    {
+        if(definitions[i].texture > definitions[i+1].texture)
+        count++;
+    }
+    return count;
+};
+
+//Inserting, removing and moving already copy the whole list, so the index is simply rebuilt alongside.
+void TextureDefinitions::rebuildIndex()
+{
+    unsigned int numBuckets = 16;
+    while(numBuckets < (unsigned int)numTextureDefinitions)
+    numBuckets <<= 1;
+
+    nameBuckets.assign(numBuckets, vector<int>());
+    memset(textureCounts,0,sizeof(int)*256);
+    textureStartsValid = false;
+    for(int i = 0; i < numTextureDefinitions; i++)
+    addToIndex(i);
+    numUnsorted = countUnsorted(0,numTextureDefinitions-2);
+};
+
 void TextureDefinitions::setTextureDefinition(int idx, TextureDefinition def)
 {
     if(idx >= 0 && idx < numTextureDefinitions)
     {
+        removeFromIndex(idx);
+        numUnsorted -= countUnsorted(idx-1,idx);
         definitions[idx] = def;
+        addToIndex(idx);
+        numUnsorted += countUnsorted(idx-1,idx);
 
         //Raise definition changed event.
         eventManager.Raise(EVENT(IDriverTexDefEvents::definitionChanged)(idx));
@@ -255,6 +361,7 @@ void TextureDefinitions::removeTextureDefinition(int idx)
         delete[] definitions;
         definitions = temp;
         numTextureDefinitions--;
+        rebuildIndex();
 
         //Raise definition removed event.
         eventManager.Raise(EVENT(IDriverTexDefEvents::definitionRemoved)(idx));
@@ -274,11 +381,11 @@ int TextureDefinitions::getSortedPosition(int idx)
     if(idx >= 0 && idx < numTextureDefinitions)
     {
         int i = 0;
-        for(i = idx; i > 0 && definitions[i-1].texture > definitions[i].texture; i--);
+        for(i = idx; i > 0 && definitions[i-1].texture > definitions[idx].texture; i--);
 
         if(i == idx)
         {
-            for(i = idx; i < numTextureDefinitions-1 && definitions[i+1].texture < definitions[i].texture; i++);
+            for(i = idx; i < numTextureDefinitions-1 && definitions[i+1].texture < definitions[idx].texture; i++);
         }
         return i;
     }
@@ -304,6 +411,7 @@ int TextureDefinitions::resortTextureDefinition(int idx)
                 memmove(&definitions[dest+1],&definitions[dest],(idx-dest)*sizeof(TextureDefinition));
                 definitions[dest] = temp;
             }
+            rebuildIndex();
 
             //Raise definition moved event.
             eventManager.Raise(EVENT(IDriverTexDefEvents::definitionMoved)(idx, dest));
@@ -336,6 +444,7 @@ void TextureDefinitions::insertTextureDefinitions(int idx,int count,TextureDefin
         {
             definitions[idx+i] = def;
         }
+        rebuildIndex();
 
         //Raise definition changed event.
         eventManager.Raise(EVENT(IDriverTexDefEvents::definitionsInserted)(idx,count));
@@ -343,42 +452,112 @@ void TextureDefinitions::insertTextureDefinitions(int idx,int count,TextureDefin
 
 };
 
+static const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+static const unsigned long long FNV_PRIME = 1099511628211ULL;
+
 DriverPalette::DriverPalette()
 {
     paletteNumber = 0;
 };
 
+unsigned long long DriverPalette::getContentHash() const
+{
+    unsigned long long hash = FNV_OFFSET;
+    for(int i = 0; i < 256; i++)
+    {
+        hash = (hash^colors[i].r)*FNV_PRIME;
+        hash = (hash^colors[i].g)*FNV_PRIME;
+        hash = (hash^colors[i].b)*FNV_PRIME;
+    }
+    return hash;
+};
+
+int DriverPalette::getMaxDifference(const DriverPalette* other) const
+{
+    int largest = 0;
+    for(int i = 0; i < 256; i++)
+    {
+        int dr = abs(colors[i].r-other->colors[i].r);
+        int dg = abs(colors[i].g-other->colors[i].g);
+        int db = abs(colors[i].b-other->colors[i].b);
+        largest = max(largest,max(dr,max(dg,db)));
+    }
+    return largest;
+};
+
+TextureBuffer::TextureBuffer(unsigned int bufferSize, unsigned int alignment) : refCount(1)
+{
+    size = bufferSize;
+    owner = NULL;
+    allocation = new unsigned char[size+alignment];
+    data = allocation;
+    if(alignment > 1)
+    data += (alignment-((size_t)allocation)%alignment)%alignment;
+};
+
+TextureBuffer::TextureBuffer(TextureBuffer* arena, unsigned int offset, unsigned int bufferSize) : refCount(1)
+{
+    size = bufferSize;
+    allocation = NULL;
+    owner = arena;
+    owner->acquire();
+    data = owner->data+offset;
+};
+
+TextureBuffer::~TextureBuffer()
+{
+    if(owner)
+    owner->release();
+    else delete[] allocation;
+};
+
+void TextureBuffer::acquire()
+{
+    refCount++;
+};
+
+void TextureBuffer::release()
+{
+    if(--refCount == 0)
+    delete this;
+};
+
+bool TextureBuffer::isShared() const
+{
+    return refCount > 1;
+};
+
 DriverTexture::DriverTexture()
 {
     flags = 0;
     carnum = -1;
-    data = NULL;
+    pixels = NULL;
 };
 
 DriverTexture::DriverTexture(unsigned short newFlags, short newCarnum)
 {
     flags = newFlags;
     carnum = newCarnum;
-    if(usesPalette())
-    data = new unsigned char[256*256];
-    else data = new unsigned char[256*256*2];
+    pixels = NULL;
+    allocateData();
 };
 
 DriverTexture::DriverTexture(const DriverTexture& other)
 {
     flags = other.flags;
     carnum = other.carnum;
+    pixels = other.pixels;
+    if(pixels)
+    pixels->acquire();
+};
 
-    if(usesPalette())
-    {
-        data = new unsigned char[256*256];
-        memcpy(data, other.getData(), 256*256*sizeof(unsigned char));
-    }
-    else
-    {
-        data = new unsigned char[256*256*2];
-        memcpy(data, other.getData(), 256*256*2*sizeof(unsigned char));
-    }
+DriverTexture::DriverTexture(DriverTexture&& other)
+{
+    flags = other.flags;
+    carnum = other.carnum;
+    pixels = other.pixels;
+    other.pixels = NULL;
+    other.cleanup();
 };
 
 DriverTexture::~DriverTexture()
@@ -388,35 +567,67 @@ DriverTexture::~DriverTexture()
 
 void DriverTexture::cleanup()
 {
-    if(data)
-    delete[] data;
-    data = NULL;
+    releaseData();
     flags = 0;
     carnum = -1;
 };
 
+void DriverTexture::allocateData()
+{
+    releaseData();
+    pixels = new TextureBuffer(usesPalette() ? 256*256 : 256*256*2);
+};
+
+void DriverTexture::releaseData()
+{
+    if(pixels)
+    pixels->release();
+    pixels = NULL;
+};
+
+unsigned char* DriverTexture::getWritableData()
+{
+    if(!pixels)
+    {
+        allocateData();
+    }
+    else if(pixels->isShared())
+    {
+        //Another texture still uses this buffer, so copy it before writing.
+        TextureBuffer* copy = new TextureBuffer(pixels->size);
+        memcpy(copy->data, pixels->data, pixels->size);
+        pixels->release();
+        pixels = copy;
+    }
+    return pixels->data;
+};
+
 DriverTexture& DriverTexture::operator=(const DriverTexture& source)
 {
     if(this == &source)
         return *this;
 
+    if(source.pixels)
+    source.pixels->acquire();
+
     cleanup();
     flags = source.flags;
     carnum = source.carnum;
+    pixels = source.pixels;
+    return *this;
+};
 
-    if(source.data != NULL)
-    {
-        if(source.usesPalette())
-        {
-            data = new unsigned char[256*256];
-            memcpy(data, source.data, 256*256*sizeof(unsigned char));
-        }
-        else
-        {
-            data = new unsigned char[256*256*2];
-            memcpy(data, source.data, 256*256*2*sizeof(unsigned char));
-        }
-    }
+DriverTexture& DriverTexture::operator=(DriverTexture&& source)
+{
+    if(this == &source)
+        return *this;
+
+    cleanup();
+    flags = source.flags;
+    carnum = source.carnum;
+    pixels = source.pixels;
+    source.pixels = NULL;
+    source.cleanup();
     return *this;
 };
 
@@ -428,16 +639,27 @@ int DriverTexture::load(IOHandle handle, IOCallbacks* callbacks)
 
     callbacks->read(&flags,2,1,handle);
     callbacks->read(&carnum,2,1,handle);
-    if(usesPalette())
-    {
-        data = new unsigned char[256*256];
-        callbacks->read(data,1,256*256,handle);
-    }
-    else
+    allocateData();
+    callbacks->read(pixels->data,1,pixels->size,handle);
+    return getRequiredSize();
+};
+
+unsigned int DriverTexture::load(TextureBuffer* arena, unsigned int offset)
+{
+    cleanup();
+    if(!arena || offset+4 > arena->size)
+    return 0;
+
+    memcpy(&flags,arena->data+offset,2);
+    memcpy(&carnum,arena->data+offset+2,2);
+    if(offset+getRequiredSize() > arena->size)
     {
-        data = new unsigned char[256*256*2];
-        callbacks->read(data,1,2*256*256,handle);
+        cleanup();
+        return 0;
     }
+
+    //Pixels stay in the arena until this texture is modified.
+    pixels = new TextureBuffer(arena, offset+4, getRequiredSize()-4);
     return getRequiredSize();
 };
 
@@ -445,24 +667,16 @@ void DriverTexture::setTruecolor(bool isTruecolor)
 {
     if(isTruecolor && usesPalette())
     {
-        if(data)
-        delete[] data;
-        data = new unsigned char[256*256*2];
         flags &= ~16;
+        allocateData();
     }
     else if(!isTruecolor && !usesPalette())
     {
-        if(data)
-        delete[] data;
-        data = new unsigned char[256*256];
         flags |= 16;
+        allocateData();
     }
-    if(!data)
-    {
-        if(usesPalette())
-        data = new unsigned char[256*256];
-        else data = new unsigned char[256*256*2];
-    }
+    if(!pixels)
+    allocateData();
 };
 
 void DriverTexture::setCarNumber(short newCarnum)
@@ -474,20 +688,8 @@ void DriverTexture::setFlags(unsigned short newFlags)
 {
     bool usedPalette = usesPalette();
     flags = newFlags;
-    if(data)
-    {
-        if(usedPalette != usesPalette())
-        {
-            delete[] data;
-            data = NULL;
-        }
-    }
-    if(!data)
-    {
-        if(usesPalette())
-        data = new unsigned char[256*256];
-        else data = new unsigned char[256*256*2];
-    }
+    if(!pixels || usedPalette != usesPalette())
+    allocateData();
 };
 
 unsigned int DriverTexture::getRequiredSize()
@@ -505,35 +707,17 @@ int DriverTexture::save(IOHandle handle, IOCallbacks* callbacks)
     callbacks->write(&flags,2,1,handle);
     callbacks->write(&carnum,2,1,handle);
 
-    if(usesPalette())
+    unsigned int size = (usesPalette() ? 256*256 : 256*256*2);
+    if(pixels)
     {
-        if(data)
-        {
-            callbacks->write(data,256*256,1,handle);
-        }
-        else
-        {
-            data = new unsigned char[256*256];
-            memset(data,0,256*256);
-            callbacks->write(data,256*256,1,handle);
-            delete[] data;
-            data = NULL;
-        }
+        callbacks->write(pixels->data,size,1,handle);
     }
     else
     {
-        if(data)
-        {
-            callbacks->write(data,256*256*2,1,handle);
-        }
-        else
-        {
-            data = new unsigned char[256*256*2];
-            memset(data,0,256*256*2);
-            callbacks->write(data,256*256*2,1,handle);
-            delete[] data;
-            data = NULL;
-        }
+        unsigned char* empty = new unsigned char[size];
+        memset(empty,0,size);
+        callbacks->write(empty,size,1,handle);
+        delete[] empty;
     }
     return 0;
 };
@@ -575,17 +759,49 @@ unsigned short DriverTexture::getFlags() const
 
 const unsigned char* DriverTexture::getData() const
 {
-    return data;
+    if(pixels)
+    return pixels->data;
+    return NULL;
+};
+
+unsigned long long DriverTexture::getContentHash() const
+{
+    unsigned long long hash = FNV_OFFSET;
+    hash = (hash^(usesPalette() ? 1 : 2))*FNV_PRIME;
+    if(!pixels)
+    return hash;
+
+    //Eight bytes at a time, the data is always a multiple of eight long.
+    const unsigned char* data = pixels->data;
+    unsigned int size = (usesPalette() ? 256*256 : 256*256*2);
+    for(unsigned int i = 0; i < size; i += 8)
+    {
+        unsigned long long block;
+        memcpy(&block,data+i,8);
+        hash = (hash^block)*FNV_PRIME;
+    }
+    return hash;
+};
+
+bool DriverTexture::hasSameData(const DriverTexture* other) const
+{
+    if(usesPalette() != other->usesPalette())
+    return false;
+    if(pixels == other->pixels)
+    return true;
+    if(!pixels || !other->pixels)
+    return false;
+    return memcmp(pixels->data,other->pixels->data,(usesPalette() ? 256*256 : 256*256*2)) == 0;
 };
 
 const unsigned char* DriverTexture::getScanLine(int i) const
 {
-    if(i < 0 || i > 255)
+    if(i < 0 || i > 255 || !pixels)
     return NULL;
 
     if(usesPalette())
-    return data+256*i;
-    return data+512*i;
+    return pixels->data+256*i;
+    return pixels->data+512*i;
 };
 
 void DriverTexture::setData(const unsigned char* memory)
@@ -593,14 +809,11 @@ void DriverTexture::setData(const unsigned char* memory)
     if(!memory)
     return;
 
-    if(!data)
-    {
-        if(usesPalette())
-        data = new unsigned char[256*256];
-        else data = new unsigned char[256*256*2];
-    }
+    //Whole buffer is replaced, so a shared buffer does not need to be copied first.
+    if(!pixels || pixels->isShared())
+    allocateData();
 
-    memcpy(data,memory,(usesPalette() ? 256*256 : 256*256*2));
+    memcpy(pixels->data,memory,(usesPalette() ? 256*256 : 256*256*2));
 };
 
 void DriverTexture::setScanLine(int y, const unsigned char* scanLineData)
@@ -608,12 +821,7 @@ void DriverTexture::setScanLine(int y, const unsigned char* scanLineData)
     if(!scanLineData || y < 0 || y > 255)
     return;
 
-    if(!data)
-    {
-        if(usesPalette())
-        data = new unsigned char[256*256];
-        else data = new unsigned char[256*256*2];
-    }
+    unsigned char* data = getWritableData();
 
     if(usesPalette())
     memcpy(data+256*y,scanLineData,256);
@@ -623,11 +831,13 @@ void DriverTexture::setScanLine(int y, const unsigned char* scanLineData)
 DriverTextures::DriverTextures()
 {
     numTextures = 0;
+    textureCapacity = 0;
     textures = NULL;
     numPalettes = 0;
     palettes = NULL;
     paletteIndexSize = 0;
     paletteIndex = NULL;
+    batchDepth = 0;
 };
 
 DriverTextures::~DriverTextures()
@@ -662,6 +872,9 @@ void DriverTextures::cleanup()
     }
     textures = NULL;
     numTextures = 0;
+    textureCapacity = 0;
+    changedTextures.clear();
+    changedPalettes.clear();
 
     if(palettes)
     {
@@ -721,13 +934,8 @@ int DriverTextures::load(IOHandle handle, IOCallbacks* callbacks, int size, Debu
 
         log->Log(DEBUG_LEVEL_RIDICULOUS, "%d: slot: %hd", i, palettes[i]->paletteNumber);
 
-        for(int j = 0; j < 256; j++)
-        {
-            callbacks->read(&palettes[i]->colors[j].b,1,1,handle);
-            callbacks->read(&palettes[i]->colors[j].g,1,1,handle);
-            callbacks->read(&palettes[i]->colors[j].r,1,1,handle);
-            callbacks->read(&palettes[i]->colors[j].a,1,1,handle);
-        }
+        callbacks->read(palettes[i]->colors,sizeof(color_4ub),256,handle);
+        swizzlePalette(palettes[i]->colors);
     }
     log->decreaseIndent();
 
@@ -749,27 +957,42 @@ int DriverTextures::load(IOHandle handle, IOCallbacks* callbacks, int size, Debu
     callbacks->read(&numTextures,4,1,handle);
     log->Log(DEBUG_LEVEL_DEBUG, "Loading %d textures.", numTextures);
 
-    textures = new DriverTexture*[numTextures];
+    reserveTextures(numTextures);
     for(int i = 0; i < numTextures; i++)
     {
         textures[i] = new DriverTexture();
     }
 
+    //Read the rest of the block in one go, textures then reference their pixels in it.
+    long int textureStart = callbacks->tell(handle);
+    int arenaSize = size-4;
+    if(arenaSize < 0)
+    arenaSize = 0;
+    TextureBuffer* arena = new TextureBuffer(arenaSize, 4096);
+    arenaSize = callbacks->read(arena->data,1,arenaSize,handle);
+
+    unsigned int offset = 0;
     log->increaseIndent();
     for(int i = 0; i < numTextures; i++)
     {
-        size -= textures[i]->load(handle,callbacks);
+        unsigned int used = textures[i]->load(arena, offset);
 
-        if(size < 0)
+        if(used == 0 || offset+used > (unsigned int)arenaSize)
         {
+            arena->release();
             cleanup();
             log->decreaseIndent();
             log->Log("ERROR: Required size for textures/palettes exceeds block size.");
             return 2;
         }
+        offset += used;
         log->Log(DEBUG_LEVEL_RIDICULOUS, "%d: flags: %hx carNumber: %hd", i, textures[i]->getFlags(), textures[i]->getCarNumber());
     }
     log->decreaseIndent();
+    arena->release();
+
+    //Leave the handle just past the last texture, as if they were read one at a time.
+    callbacks->seek(handle,textureStart+offset,SEEK_SET);
 
     //Raise textures opened event.
     eventManager.Raise(EVENT(IDriverTextureEvents::texturesOpened)());
@@ -797,17 +1020,14 @@ int DriverTextures::save(IOHandle handle, IOCallbacks* callbacks)
 
     callbacks->write(&numPalettes,2,1,handle);
 
+    color_4ub colors[256];
     for(int i = 0; i < numPalettes; i++)
     {
         callbacks->write(&palettes[i]->paletteNumber,2,1,handle);
 
-        for(int j = 0; j < 256; j++)
-        {
-            callbacks->write(&palettes[i]->colors[j].b,1,1,handle);
-            callbacks->write(&palettes[i]->colors[j].g,1,1,handle);
-            callbacks->write(&palettes[i]->colors[j].r,1,1,handle);
-            callbacks->write(&palettes[i]->colors[j].a,1,1,handle);
-        }
+        memcpy(colors,palettes[i]->colors,sizeof(color_4ub)*256);
+        swizzlePalette(colors);
+        callbacks->write(colors,sizeof(color_4ub),256,handle);
     }
 
     callbacks->write(&numTextures,4,1,handle);
@@ -838,8 +1058,8 @@ void DriverTextures::setTexture(int idx, const DriverTexture* tex)
 {
     if(tex && idx >= 0 && idx < numTextures)
     {
-        *textures[idx] = *tex; //assignment operator does a deep copy.
-        eventManager.Raise(EVENT(IDriverTextureEvents::textureChanged)(idx));
+        *textures[idx] = *tex; //pixel data is shared until either texture is modified.
+        markTextureChanged(idx);
     }
 };
 
@@ -852,25 +1072,57 @@ void DriverTextures::moveTexture(int from, int to)
         memmove(&textures[from], &textures[from+1], (to-from)*sizeof(DriverTexture*));
         else memmove(&textures[to+1], &textures[to], (from-to)*sizeof(DriverTexture*));
         textures[to] = tex;
+
+        for(unsigned int i = 0; i < changedTextures.size(); i++)
+        {
+            if(changedTextures[i] == from)
+            changedTextures[i] = to;
+            else if(from < to && changedTextures[i] > from && changedTextures[i] <= to)
+            changedTextures[i]--;
+            else if(from > to && changedTextures[i] >= to && changedTextures[i] < from)
+            changedTextures[i]++;
+        }
         eventManager.Raise(EVENT(IDriverTextureEvents::textureMoved)(from,to));
     }
 };
 
+void DriverTextures::reserveTextures(int count)
+{
+    if(count <= textureCapacity)
+    return;
+
+    int newCapacity = (textureCapacity > 0 ? textureCapacity*2 : 256);
+    if(newCapacity < count)
+    newCapacity = count;
+
+    DriverTexture** temp = new DriverTexture*[newCapacity];
+    if(textures)
+    {
+        memcpy(temp,textures,sizeof(DriverTexture*)*numTextures);
+        delete[] textures;
+    }
+    textures = temp;
+    textureCapacity = newCapacity;
+};
+
 void DriverTextures::removeTexture(int idx)
 {
     if(idx >= 0 && idx < numTextures)
     {
         delete textures[idx];
-        DriverTexture** temp = NULL;
-        if(numTextures > 1)
+        memmove(&textures[idx],&textures[idx+1],sizeof(DriverTexture*)*(numTextures-(idx+1)));
+        numTextures--;
+
+        for(unsigned int i = 0; i < changedTextures.size(); i++)
         {
-            temp = new DriverTexture*[numTextures-1];
-            memcpy(temp,textures,sizeof(DriverTexture*)*idx);
-            memcpy(&temp[idx],&textures[idx+1],sizeof(DriverTexture*)*(numTextures-(idx+1)));
+            if(changedTextures[i] == idx)
+            {
+                changedTextures.erase(changedTextures.begin()+i);
+                i--;
+            }
+            else if(changedTextures[i] > idx)
+            changedTextures[i]--;
         }
-        delete[] textures;
-        numTextures--;
-        textures = temp;
         eventManager.Raise(EVENT(IDriverTextureEvents::textureRemoved)(idx));
     }
 };
@@ -879,16 +1131,16 @@ void DriverTextures::insertTexture(int idx, const DriverTexture* tex)
 {
     if(idx >= 0 && idx <= numTextures)
     {
-        DriverTexture** temp = new DriverTexture*[numTextures+1];
-        if(textures)
-        {
-            memcpy(temp,textures,sizeof(DriverTexture*)*idx);
-            memcpy(&temp[idx+1],&textures[idx],sizeof(DriverTexture*)*(numTextures-idx));
-            delete[] textures;
-        }
-        textures = temp;
+        reserveTextures(numTextures+1);
+        memmove(&textures[idx+1],&textures[idx],sizeof(DriverTexture*)*(numTextures-idx));
         textures[idx] = new DriverTexture(*tex);
         numTextures++;
+
+        for(unsigned int i = 0; i < changedTextures.size(); i++)
+        {
+            if(changedTextures[i] >= idx)
+            changedTextures[i]++;
+        }
         eventManager.Raise(EVENT(IDriverTextureEvents::textureInserted)(idx));
     }
 };
@@ -900,13 +1152,7 @@ void DriverTextures::addTexture(const DriverTexture* tex)
 
 void DriverTextures::addTexture(unsigned short flags, short carnum)
 {
-    DriverTexture** temp = new DriverTexture*[numTextures+1];
-    if(textures)
-    {
-        memcpy(temp,textures,sizeof(DriverTexture*)*numTextures);
-        delete[] textures;
-    }
-    textures = temp;
+    reserveTextures(numTextures+1);
     textures[numTextures] = new DriverTexture(flags,carnum);
     numTextures++;
 };
@@ -938,9 +1184,7 @@ void DriverTextures::setPalette(int idx, DriverPalette* palette)
     if(idx >= 0 && idx < numPalettes)
     {
         *palettes[idx] = *palette;
-
-        //Raise palette changed event.
-        eventManager.Raise(EVENT(IDriverTextureEvents::paletteChanged)(idx));
+        markPaletteChanged(idx);
     }
 };
 
@@ -961,6 +1205,7 @@ void DriverTextures::setPaletteIndexed(DriverPalette* palette)
         }
         memset(&temp[paletteIndexSize],0xFF,sizeof(int)*((slot+1)-paletteIndexSize));
         paletteIndex = temp;
+        paletteIndexSize = slot+1;
     }
     if(paletteIndex[slot] == -1)
     {
@@ -981,6 +1226,36 @@ void DriverTextures::setPaletteIndexed(DriverPalette* palette)
     //Raise palette inserted event.
     if(isNew)
     eventManager.Raise(EVENT(IDriverTextureEvents::paletteInserted)(numPalettes-1));
+    else markPaletteChanged(paletteIndex[slot]);
+};
+
+void DriverTextures::movePaletteSlot(int from, int to)
+{
+    if(from < 0 || from >= paletteIndexSize || paletteIndex[from] == -1 || to < 0 || to == from)
+    return;
+
+    if(to >= paletteIndexSize)
+    {
+        int* temp = new int[to+1];
+        memcpy(temp,paletteIndex,sizeof(int)*paletteIndexSize);
+        memset(&temp[paletteIndexSize],0xFF,sizeof(int)*((to+1)-paletteIndexSize));
+        delete[] paletteIndex;
+        paletteIndex = temp;
+        paletteIndexSize = to+1;
+    }
+    else if(paletteIndex[to] != -1)
+    return;
+
+    int idx = paletteIndex[from];
+    paletteIndex[from] = -1;
+    paletteIndex[to] = idx;
+    palettes[idx]->paletteNumber = to;
+
+    //Drop empty slots at the end so getNextOpenSlot does not skip past them.
+    while(paletteIndexSize > 0 && paletteIndex[paletteIndexSize-1] == -1)
+    paletteIndexSize--;
+
+    markPaletteChanged(idx);
 };
 
 int DriverTextures::getNextOpenSlot()
@@ -1002,19 +1277,98 @@ void DriverTextures::removePalette(int idx)
         {
             if(paletteIndex[i] == idx)
             paletteIndex[i] = -1;
+            else if(paletteIndex[i] > idx)
+            paletteIndex[i]--;
         }
+        delete palettes[idx];
         DriverPalette** temp = new DriverPalette*[numPalettes-1];
         memcpy(temp,palettes,sizeof(DriverPalette*)*idx);
-        memcpy(&temp[idx],&palettes[idx+1],sizeof(DriverPalette*)*(numPalettes-idx));
+        memcpy(&temp[idx],&palettes[idx+1],sizeof(DriverPalette*)*(numPalettes-idx-1));
         delete[] palettes;
         numPalettes--;
         palettes = temp;
 
+        for(unsigned int i = 0; i < changedPalettes.size(); i++)
+        {
+            if(changedPalettes[i] == idx)
+            {
+                changedPalettes.erase(changedPalettes.begin()+i);
+                i--;
+            }
+            else if(changedPalettes[i] > idx)
+            changedPalettes[i]--;
+        }
+
         //Raise palette removed event.
         eventManager.Raise(EVENT(IDriverTextureEvents::paletteRemoved)(idx));
     }
 };
 
+void DriverTextures::beginChanges()
+{
+    batchDepth++;
+};
+
+void DriverTextures::commitChanges()
+{
+    if(batchDepth <= 0)
+    return;
+
+    batchDepth--;
+    if(batchDepth > 0)
+    return;
+
+    //Copy pending changes first in case a handler starts another batch.
+    vector<int> textureList = changedTextures;
+    vector<int> paletteList = changedPalettes;
+    changedTextures.clear();
+    changedPalettes.clear();
+
+    sort(paletteList.begin(), paletteList.end());
+    paletteList.erase(unique(paletteList.begin(), paletteList.end()), paletteList.end());
+    for(unsigned int i = 0; i < paletteList.size(); i++)
+    {
+        eventManager.Raise(EVENT(IDriverTextureEvents::paletteChanged)(paletteList[i]));
+    }
+
+    sort(textureList.begin(), textureList.end());
+    textureList.erase(unique(textureList.begin(), textureList.end()), textureList.end());
+    if(textureList.size() > 0)
+    eventManager.Raise(EVENT(IDriverTextureEvents::textureBatchChanged)(&textureList[0], (int)textureList.size()));
+};
+
+bool DriverTextures::isBatchingChanges() const
+{
+    return batchDepth > 0;
+};
+
+TextureChangeBatch::TextureChangeBatch(DriverTextures* textures)
+{
+    owner = textures;
+    if(owner)
+    owner->beginChanges();
+};
+
+TextureChangeBatch::~TextureChangeBatch()
+{
+    if(owner)
+    owner->commitChanges();
+};
+
+void DriverTextures::markTextureChanged(int idx)
+{
+    if(batchDepth > 0)
+    changedTextures.push_back(idx);
+    else eventManager.Raise(EVENT(IDriverTextureEvents::textureChanged)(idx));
+};
+
+void DriverTextures::markPaletteChanged(int idx)
+{
+    if(batchDepth > 0)
+    changedPalettes.push_back(idx);
+    else eventManager.Raise(EVENT(IDriverTextureEvents::paletteChanged)(idx));
+};
+
 void DriverTextures::removeIndexedPalette(int idx)
 {
     if(idx >= 0 && idx < paletteIndexSize)
@@ -1,6 +1,8 @@
 #ifndef TEXTURES_HPP
 #define TEXTURES_HPP
 
+#include <atomic>
+#include <vector>
 #include "../ioFuncs.hpp"
 #include "../../EventMgr.hpp"
 #include "../../Log_Routines/debug_logger.hpp"
@@ -63,9 +65,14 @@ class TextureDefinitions
         int save(IOHandle handle, IOCallbacks* callbacks);
 
         int getNumTextureDefinitions();
+        //The name and texture are indexed, so change those through setTextureDefinition rather than this pointer.
         TextureDefinition* getTextureDefinition(int idx);
         bool getTextureDefinition(int idx,TextureDefinition* in);
         int findTextureDefByName(const char* name);
+        //First definition on a texture, with the number of definitions on it in count. Only available while the
+        //list is sorted by texture, otherwise -1 is returned.
+        int getTextureDefinitionRange(int texture, int* count);
+        bool isSortedByTexture();
         int getSortedPosition(int idx);
         int resortTextureDefinition(int idx);
         void setTextureDefinition(int idx,TextureDefinition def);
@@ -73,9 +80,22 @@ class TextureDefinitions
         void insertTextureDefinitions(int idx,int count,TextureDefinition def = TextureDefinition());
         void removeTextureDefinition(int idx);
     protected:
+        void rebuildIndex();
+        void addToIndex(int idx);
+        void removeFromIndex(int idx);
+        int countUnsorted(int first, int last);
+        static unsigned int hashName(const char* name);
+
         CEventMgr<IDriverTexDefEvents> eventManager;
         int numTextureDefinitions;
         TextureDefinition* definitions;
+
+        //Definitions are bucketed by name hash, each bucket sorted so the first match is the lowest index.
+        vector<vector<int> > nameBuckets;
+        int textureCounts[256];
+        int textureStarts[256];
+        bool textureStartsValid;
+        int numUnsorted; //Neighbouring pairs that are out of texture order.
 };
 
 struct color_4ub
@@ -88,6 +108,11 @@ class DriverPalette
     public:
         DriverPalette();
 
+        //Hash of the rgb values only, the slot and alpha are ignored.
+        unsigned long long getContentHash() const;
+        //Largest difference of any channel between matching entries.
+        int getMaxDifference(const DriverPalette* other) const;
+
         short paletteNumber;
         color_4ub colors[256];
 };
@@ -100,16 +125,41 @@ const unsigned int TEX_USES_PALETTE = 16;
 //There is also a flag at 64 which alternates between paletted textures (sometimes set on the first, sometimes on the second)
 //which does not appear to be used.
 
+//Reference counted pixel storage, shared between copies of a texture until one of them is modified.
+//A buffer can also be a view into a larger arena buffer, keeping the arena alive while it is used.
+class TextureBuffer
+{
+    public:
+        TextureBuffer(unsigned int bufferSize, unsigned int alignment = 0);
+        TextureBuffer(TextureBuffer* arena, unsigned int offset, unsigned int bufferSize);
+
+        void acquire();
+        void release();
+        bool isShared() const;
+
+        unsigned char* data;
+        unsigned int size;
+
+    protected:
+        ~TextureBuffer();
+
+        std::atomic<int> refCount;
+        unsigned char* allocation;
+        TextureBuffer* owner;
+};
+
 class DriverTexture
 {
     public:
         DriverTexture();
         DriverTexture(unsigned short newFlags, short newCarnum);
         DriverTexture(const DriverTexture& other);
+        DriverTexture(DriverTexture&& other);
         ~DriverTexture();
         void cleanup();
 
         int load(IOHandle handle, IOCallbacks* callbacks);
+        unsigned int load(TextureBuffer* arena, unsigned int offset);
 
         unsigned int getRequiredSize();
         int save(IOHandle handle, IOCallbacks* callbacks);
@@ -128,16 +178,23 @@ class DriverTexture
 
         const unsigned char* getData() const;
         const unsigned char* getScanLine(int line) const;
+        unsigned long long getContentHash() const;
+        bool hasSameData(const DriverTexture* other) const;
 
         void setData(const unsigned char* memory);
         void setScanLine(int y, const unsigned char* scanLineData);
 
         DriverTexture& operator=(const DriverTexture& source);
+        DriverTexture& operator=(DriverTexture&& source);
 
     protected:
+        void allocateData();
+        void releaseData();
+        unsigned char* getWritableData();
+
         unsigned short flags;
         short carnum;
-        unsigned char* data;
+        TextureBuffer* pixels;
 };
 
 class IDriverTextureEvents
@@ -153,6 +210,7 @@ class IDriverTextureEvents
         DEFINE_EVENT1(IDriverTextureEvents, textureRemoved, int /*idx*/);
         DEFINE_EVENT2(IDriverTextureEvents, textureMoved, int /*from*/, int /*to*/);
         DEFINE_EVENT1(IDriverTextureEvents, textureChanged, int /*idx*/);
+        DEFINE_EVENT2(IDriverTextureEvents, textureBatchChanged, const int* /*indices*/, int /*count*/); //Sorted, raised once when a batch of changes is committed
 
         DEFINE_EVENT1(IDriverTextureEvents, paletteInserted, int /*idx*/);
         DEFINE_EVENT1(IDriverTextureEvents, paletteRemoved, int /*idx*/);
@@ -191,17 +249,49 @@ class DriverTextures
         void removeIndexedPalette(int idx);
         void setPalette(int idx, DriverPalette* palette);
         void setPaletteIndexed(DriverPalette* palette);
+        //Moves a palette to an empty slot. D3D entries still refer to the old slot and must be updated by the caller.
+        void movePaletteSlot(int from, int to);
 
         int getNextOpenSlot();
 
+        //Texture and palette changes made between these are raised as one textureBatchChanged event on commit.
+        //Inserting, removing and moving are still raised immediately. TextureChangeBatch pairs them for a scope.
+        void beginChanges();
+        void commitChanges();
+        bool isBatchingChanges() const;
+
     protected:
+        void reserveTextures(int count);
+        void markTextureChanged(int idx);
+        void markPaletteChanged(int idx);
+
         CEventMgr<IDriverTextureEvents> eventManager;
         DriverTexture** textures;
+        int textureCapacity;
         DriverPalette** palettes;
         int* paletteIndex;
         int paletteIndexSize;
         int numTextures;
         short numPalettes;
+
+        int batchDepth;
+        std::vector<int> changedTextures;
+        std::vector<int> changedPalettes;
+};
+
+//Begins a batch of changes on construction and commits it when it goes out of scope.
+class TextureChangeBatch
+{
+    public:
+        TextureChangeBatch(DriverTextures* textures);
+        ~TextureChangeBatch();
+
+    protected:
+        DriverTextures* owner;
+
+    private:
+        TextureChangeBatch(const TextureChangeBatch&);
+        TextureChangeBatch& operator=(const TextureChangeBatch&);
 };
 
 #endif
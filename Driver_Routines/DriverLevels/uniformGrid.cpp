@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cmath>
+#include "uniformGrid.hpp"
+
+UniformGrid::UniformGrid()
+{
+    clear();
+};
+
+void UniformGrid::clear()
+{
+    cellSize = 1.0f;
+    originX = originZ = 0.0f;
+    cellsX = cellsZ = 0;
+};
+
+void UniformGrid::setup(float minX, float minZ, float maxX, float maxZ, int count, float size, int maxCells)
+{
+    float width = max(maxX-minX, 1.0f);
+    float height = max(maxZ-minZ, 1.0f);
+    cellSize = size;
+    if(cellSize <= 0.0f)
+    cellSize = max((float)sqrt(width*height/max(count/4.0f, 1.0f)), 1.0f);
+    cellSize = max(cellSize, max(width, height)/(maxCells-1));
+
+    originX = minX;
+    originZ = minZ;
+    cellsX = (int)(width/cellSize)+1;
+    cellsZ = (int)(height/cellSize)+1;
+};
+
+float UniformGrid::getCellSize() const
+{
+    return cellSize;
+};
+
+int UniformGrid::getNumCellsX() const
+{
+    return cellsX;
+};
+
+int UniformGrid::getNumCellsZ() const
+{
+    return cellsZ;
+};
+
+int UniformGrid::getNumCells() const
+{
+    return cellsX*cellsZ;
+};
+
+int UniformGrid::getCell(float x, float z) const
+{
+    float fx = floor((x-originX)/cellSize);
+    float fz = floor((z-originZ)/cellSize);
+    int cx = (int)max(0.0f, min(fx, (float)(cellsX-1)));
+    int cz = (int)max(0.0f, min(fz, (float)(cellsZ-1)));
+    return cz*cellsX+cx;
+};
+
+void UniformGrid::getCellRange(float fromX, float fromZ, float toX, float toZ, int* x1, int* z1, int* x2, int* z2) const
+{
+    int cell = getCell(fromX, fromZ);
+    *x1 = cell%cellsX;
+    *z1 = cell/cellsX;
+    cell = getCell(toX, toZ);
+    *x2 = cell%cellsX;
+    *z2 = cell/cellsX;
+};
+
+int UniformGrid::getRing(int centre, int r, vector<int>& out) const
+{
+    out.clear();
+    if(cellsX <= 0 || cellsZ <= 0)
+        return 0;
+
+    int centreX = centre%cellsX;
+    int centreZ = centre/cellsX;
+    for(int cz = centreZ-r; cz <= centreZ+r; cz++)
+    {
+        if(cz < 0 || cz >= cellsZ)
+            continue;
+        //Only the edge of the ring, the inside belongs to the smaller rings.
+        int step = (cz == centreZ-r || cz == centreZ+r ? 1 : 2*r);
+        for(int cx = centreX-r; cx <= centreX+r; cx += max(step,1))
+        {
+            if(cx >= 0 && cx < cellsX)
+            out.push_back(cz*cellsX+cx);
+        }
+    }
+    return out.size();
+};
+
+int UniformGrid::getMaxRing() const
+{
+    return max(cellsX, cellsZ);
+};
+
+//Clamping to the grid never increases a distance, so only the r-1 whole cells between are certain.
+float UniformGrid::getRingDistance(int r) const
+{
+    return (r > 1 ? (r-1)*cellSize : 0.0f);
+};
@@ -0,0 +1,40 @@
+#ifndef UNIFORM_GRID_HPP
+#define UNIFORM_GRID_HPP
+
+#include <vector>
+
+using namespace std;
+
+//Cell layout of a top down grid of square cells, shared by the world and road grids which keep their own cell contents.
+//Cells are numbered z*getNumCellsX()+x, positions outside the grid are clamped into the edge cells.
+class UniformGrid
+{
+    public:
+        UniformGrid();
+        void clear();
+
+        //Fits cells over the bounds. A cell size of 0 picks one holding about four of count entries per cell.
+        //No more than maxCells cells are used per side.
+        void setup(float minX, float minZ, float maxX, float maxZ, int count, float cellSize, int maxCells);
+
+        float getCellSize() const;
+        int getNumCellsX() const;
+        int getNumCellsZ() const;
+        int getNumCells() const;
+
+        int getCell(float x, float z) const;
+        void getCellRange(float fromX, float fromZ, float toX, float toZ, int* x1, int* z1, int* x2, int* z2) const;
+
+        //Cells on the edge of the square r cells out from centre, for searching outwards from a point. Nothing in
+        //ring r can be closer to a point in the centre cell than getRingDistance(r). Returns the number of cells.
+        int getRing(int centre, int r, vector<int>& out) const;
+        int getMaxRing() const;
+        float getRingDistance(int r) const;
+
+    protected:
+        float cellSize;
+        float originX,originZ;
+        int cellsX,cellsZ;
+};
+
+#endif
@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include "visibilityBuilder.hpp"
+
+#define VISIBILITY_MAX_CELLS 1024 //Per side.
+
+VisibilityBuilder::VisibilityBuilder()
+{
+    samplesPerSide = 3;
+    eyeHeight = 0.0f;
+    maxDistance = 0.0f;
+    minOccluderSize = 0.0f;
+    clear();
+};
+
+void VisibilityBuilder::setSamplesPerSide(int n)
+{
+    samplesPerSide = (n > 0 ? n : 1);
+};
+
+int VisibilityBuilder::getSamplesPerSide() const
+{
+    return samplesPerSide;
+};
+
+void VisibilityBuilder::setEyeHeight(float height)
+{
+    eyeHeight = height;
+};
+
+float VisibilityBuilder::getEyeHeight() const
+{
+    return eyeHeight;
+};
+
+void VisibilityBuilder::setMaxDistance(float distance)
+{
+    maxDistance = (distance > 0.0f ? distance : 0.0f);
+};
+
+float VisibilityBuilder::getMaxDistance() const
+{
+    return maxDistance;
+};
+
+void VisibilityBuilder::setMinOccluderSize(float size)
+{
+    minOccluderSize = (size > 0.0f ? size : 0.0f);
+};
+
+float VisibilityBuilder::getMinOccluderSize() const
+{
+    return minOccluderSize;
+};
+
+void VisibilityBuilder::clear()
+{
+    numSectors = 0;
+    bounds.clear();
+    samples.clear();
+    occluders.clear();
+    cells.clear();
+    cellSize = 1.0f;
+    originX = originZ = 0.0f;
+    cellsX = cellsZ = 0;
+};
+
+int VisibilityBuilder::getNumSectors() const
+{
+    return numSectors;
+};
+
+int VisibilityBuilder::getNumOccluders() const
+{
+    return occluders.size();
+};
+
+//The rotation format isn't known, so the cylinder is centred on the model origin and only as wide as still fits
+//inside the model's bounding box however the model is turned about y.
+void VisibilityBuilder::addOccluder(const WorldModelDef* def, ModelContainer* models)
+{
+    DriverModel* model = models->getModel(def->modelNum);
+    if(model)
+    model = models->getReferencedModel(model);
+    if(!model || model->getNumVertices() <= 0)
+        return;
+
+    Vector3f center = model->getCenter();
+    Vector3f size = model->getBounds();
+    float radius = min(size.x, size.z)/2.0f-sqrt(center.x*center.x+center.z*center.z);
+    if(radius <= 0.0f || radius*2.0f < minOccluderSize)
+        return;
+
+    VisibilityOccluder occluder;
+    occluder.x = def->position.x;
+    occluder.z = def->position.z;
+    occluder.radius = radius;
+    occluder.minY = def->position.y+center.y-size.y/2.0f;
+    occluder.maxY = def->position.y+center.y+size.y/2.0f;
+    occluders.push_back(occluder);
+};
+
+int VisibilityBuilder::prepare(DriverLevel* level)
+{
+    clear();
+    if(!level)
+    return 0;
+
+    //Sector i of the visibility table is assumed to be world sector i, which can only hold when the counts match.
+    if(level->visibility.getNumSectors() != level->world.getNumSectors())
+    return 0;
+
+    numSectors = level->visibility.getNumSectors();
+    bounds.resize(numSectors);
+    samples.resize(numSectors);
+
+    for(int i = 0; i < numSectors; i++)
+    {
+        VisibilitySectorBounds& sectorBounds = bounds[i];
+        sectorBounds.empty = true;
+        sectorBounds.minX = sectorBounds.minZ = FLT_MAX;
+        sectorBounds.maxX = sectorBounds.maxZ = -FLT_MAX;
+        sectorBounds.y = 0.0f;
+
+        WorldSector* sector = level->world.getSector(i);
+        if(!sector || sector->getNumModelDefs() == 0)
+            continue;
+
+        sectorBounds.empty = false;
+        for(int j = 0; j < sector->getNumModelDefs(); j++)
+        {
+            const WorldModelDef* def = sector->getModelDef(j);
+            sectorBounds.minX = min(sectorBounds.minX, def->position.x);
+            sectorBounds.minZ = min(sectorBounds.minZ, def->position.z);
+            sectorBounds.maxX = max(sectorBounds.maxX, def->position.x);
+            sectorBounds.maxZ = max(sectorBounds.maxZ, def->position.z);
+            sectorBounds.y += def->position.y;
+        }
+        sectorBounds.y = sectorBounds.y/sector->getNumModelDefs()+eyeHeight;
+        createSamples(i);
+    }
+
+    for(int i = 0; i < level->world.getNumBridgedDefs(); i++)
+    addOccluder(level->world.getBridgedDef(i), &level->models);
+    for(int i = 0; i < level->world.getNumSectors(); i++)
+    {
+        WorldSector* sector = level->world.getSector(i);
+        for(int j = 0; j < sector->getNumModelDefs(); j++)
+        addOccluder(sector->getModelDef(j), &level->models);
+    }
+    buildGrid();
+
+    return numSectors;
+};
+
+void VisibilityBuilder::createSamples(int sector)
+{
+    const VisibilitySectorBounds& sectorBounds = bounds[sector];
+    vector<Vector3f>& points = samples[sector];
+    points.clear();
+    for(int z = 0; z < samplesPerSide; z++)
+    {
+        for(int x = 0; x < samplesPerSide; x++)
+        {
+            float fx = (x+0.5f)/samplesPerSide;
+            float fz = (z+0.5f)/samplesPerSide;
+            points.push_back(Vector3f(sectorBounds.minX+(sectorBounds.maxX-sectorBounds.minX)*fx, sectorBounds.y,
+                                      sectorBounds.minZ+(sectorBounds.maxZ-sectorBounds.minZ)*fz));
+        }
+    }
+};
+
+void VisibilityBuilder::buildGrid()
+{
+    if(occluders.empty())
+        return;
+
+    float minX = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxZ = -FLT_MAX;
+    float totalRadius = 0.0f;
+    for(unsigned int i = 0; i < occluders.size(); i++)
+    {
+        minX = min(minX, occluders[i].x-occluders[i].radius);
+        minZ = min(minZ, occluders[i].z-occluders[i].radius);
+        maxX = max(maxX, occluders[i].x+occluders[i].radius);
+        maxZ = max(maxZ, occluders[i].z+occluders[i].radius);
+        totalRadius += occluders[i].radius;
+    }
+
+    //Cells about four occluders wide keep the number of cells each one is added to small.
+    float width = max(maxX-minX, 1.0f);
+    float height = max(maxZ-minZ, 1.0f);
+    cellSize = max(totalRadius/occluders.size()*8.0f, 1.0f);
+    cellSize = max(cellSize, max(width, height)/VISIBILITY_MAX_CELLS);
+    originX = minX;
+    originZ = minZ;
+    cellsX = (int)(width/cellSize)+1;
+    cellsZ = (int)(height/cellSize)+1;
+    cells.assign(cellsX*cellsZ, vector<int>());
+
+    for(unsigned int i = 0; i < occluders.size(); i++)
+    {
+        const VisibilityOccluder& occluder = occluders[i];
+        int x1 = max(0, (int)((occluder.x-occluder.radius-originX)/cellSize));
+        int z1 = max(0, (int)((occluder.z-occluder.radius-originZ)/cellSize));
+        int x2 = min(cellsX-1, (int)((occluder.x+occluder.radius-originX)/cellSize));
+        int z2 = min(cellsZ-1, (int)((occluder.z+occluder.radius-originZ)/cellSize));
+        for(int z = z1; z <= z2; z++)
+        {
+            for(int x = x1; x <= x2; x++)
+            cells[z*cellsX+x].push_back(i);
+        }
+    }
+};
+
+//Steps through the cells under the line, testing the occluders in each one.
+bool VisibilityBuilder::isBlocked(const Vector3f& from, const Vector3f& to) const
+{
+    if(cells.empty())
+    return false;
+
+    float dx = to.x-from.x;
+    float dz = to.z-from.z;
+    float dy = to.y-from.y;
+    float gx = (from.x-originX)/cellSize;
+    float gz = (from.z-originZ)/cellSize;
+    int cx = (int)floor(gx);
+    int cz = (int)floor(gz);
+    int endX = (int)floor((to.x-originX)/cellSize);
+    int endZ = (int)floor((to.z-originZ)/cellSize);
+    int stepX = (dx > 0.0f ? 1 : -1);
+    int stepZ = (dz > 0.0f ? 1 : -1);
+    float tDeltaX = (dx != 0.0f ? fabs(cellSize/dx) : FLT_MAX);
+    float tDeltaZ = (dz != 0.0f ? fabs(cellSize/dz) : FLT_MAX);
+    float tMaxX = (dx != 0.0f ? ((stepX > 0 ? cx+1-gx : gx-cx)*tDeltaX) : FLT_MAX);
+    float tMaxZ = (dz != 0.0f ? ((stepZ > 0 ? cz+1-gz : gz-cz)*tDeltaZ) : FLT_MAX);
+    int steps = abs(endX-cx)+abs(endZ-cz);
+
+    float a = dx*dx+dz*dz;
+    for(int i = 0; i <= steps; i++)
+    {
+        if(cx >= 0 && cx < cellsX && cz >= 0 && cz < cellsZ)
+        {
+            const vector<int>& cell = cells[cz*cellsX+cx];
+            for(unsigned int j = 0; j < cell.size(); j++)
+            {
+                const VisibilityOccluder& occluder = occluders[cell[j]];
+                float ox = from.x-occluder.x;
+                float oz = from.z-occluder.z;
+                float c = ox*ox+oz*oz-occluder.radius*occluder.radius;
+
+                //A sample inside a model isn't a real viewpoint, so that model doesn't hide anything from it.
+                if(c <= 0.0f && from.y >= occluder.minY && from.y <= occluder.maxY)
+                    continue;
+                float ex = to.x-occluder.x;
+                float ez = to.z-occluder.z;
+                if(ex*ex+ez*ez <= occluder.radius*occluder.radius && to.y >= occluder.minY && to.y <= occluder.maxY)
+                    continue;
+
+                if(a <= 0.0f)
+                {
+                    if(c <= 0.0f)
+                    return true;
+                    continue;
+                }
+                float b = ox*dx+oz*dz;
+                float disc = b*b-a*c;
+                if(disc < 0.0f)
+                    continue;
+                float root = sqrt(disc);
+                float t1 = max(0.0f, (-b-root)/a);
+                float t2 = min(1.0f, (-b+root)/a);
+                if(t1 > t2)
+                    continue;
+                float y1 = from.y+dy*t1;
+                float y2 = from.y+dy*t2;
+                if(max(y1,y2) >= occluder.minY && min(y1,y2) <= occluder.maxY)
+                return true;
+            }
+        }
+
+        if(tMaxX < tMaxZ)
+        {
+            cx += stepX;
+            tMaxX += tDeltaX;
+        }
+        else
+        {
+            cz += stepZ;
+            tMaxZ += tDeltaZ;
+        }
+    }
+    return false;
+};
+
+long long VisibilityBuilder::getMaxRayCount() const
+{
+    long long numPairs = 0;
+    for(int i = 0; i < numSectors; i++)
+    {
+        if(bounds[i].empty)
+            continue;
+        for(int j = 0; j < numSectors; j++)
+        {
+            if(j != i && !bounds[j].empty && isInRange(bounds[i], bounds[j]))
+            numPairs++;
+        }
+    }
+    long long perSide = samplesPerSide;
+    return numPairs*perSide*perSide*perSide*perSide;
+};
+
+bool VisibilityBuilder::isInRange(const VisibilitySectorBounds& from, const VisibilitySectorBounds& to) const
+{
+    if(maxDistance <= 0.0f)
+    return true;
+
+    float gapX = max(0.0f, max(to.minX-from.maxX, from.minX-to.maxX));
+    float gapZ = max(0.0f, max(to.minZ-from.maxZ, from.minZ-to.maxZ));
+    return gapX*gapX+gapZ*gapZ <= maxDistance*maxDistance;
+};
+
+void VisibilityBuilder::buildSector(int sector, SectorBitset* out) const
+{
+    if(!out)
+    return;
+
+    out->resize(numSectors);
+    out->clear();
+    if(sector < 0 || sector >= numSectors)
+    return;
+
+    if(bounds[sector].empty)
+    {
+        out->fill();
+        return;
+    }
+
+    const VisibilitySectorBounds& from = bounds[sector];
+    const vector<Vector3f>& fromSamples = samples[sector];
+    for(int i = 0; i < numSectors; i++)
+    {
+        const VisibilitySectorBounds& to = bounds[i];
+        if(i == sector || to.empty)
+        {
+            out->set(i);
+            continue;
+        }
+
+        if(!isInRange(from, to))
+            continue;
+
+        const vector<Vector3f>& toSamples = samples[i];
+        bool visible = false;
+        for(unsigned int j = 0; j < fromSamples.size() && !visible; j++)
+        {
+            for(unsigned int k = 0; k < toSamples.size() && !visible; k++)
+            visible = !isBlocked(fromSamples[j], toSamples[k]);
+        }
+        out->set(i, visible);
+    }
+};
+
+void VisibilityBuilder::buildAll(vector<SectorBitset>& out) const
+{
+    out.assign(numSectors, SectorBitset());
+    for(int i = 0; i < numSectors; i++)
+    buildSector(i, &out[i]);
+};
@@ -0,0 +1,85 @@
+#ifndef VISIBILITY_BUILDER_HPP
+#define VISIBILITY_BUILDER_HPP
+
+#include "../driver_levels.hpp"
+#include "sectorBitset.hpp"
+
+//Vertical cylinder that fits inside a placed model whatever its rotation.
+struct VisibilityOccluder
+{
+    float x,z;
+    float radius;
+    float minY,maxY;
+};
+
+//Area covered by the model placements of a world sector.
+struct VisibilitySectorBounds
+{
+    bool empty;
+    float minX,minZ,maxX,maxZ;
+    float y;
+};
+
+//Estimates which sectors can be seen from each other by casting rays between sample points spread over each
+//sector. Rays are blocked only by cylinders that lie inside the placed models, so models never hide more than
+//they really cover, but only n*n points between the placement origins of each sector are tried and a sector
+//seen only from elsewhere is missed. Sectors without any placements are treated as seeing and being seen by
+//everything.
+//The level's visibility table format is not verified, so results are never written back into the level.
+//prepare refuses levels whose visibility and world sector counts differ. Otherwise it collects everything needed
+//from the level, after which buildSector only reads the builder and can be run for different sectors on several
+//threads at once.
+class VisibilityBuilder
+{
+    public:
+        VisibilityBuilder();
+
+        //Sample points along each side of a sector, so n*n points per sector.
+        void setSamplesPerSide(int n);
+        int getSamplesPerSide() const;
+        //Height of the sample points above the average height of a sector's placements.
+        void setEyeHeight(float height);
+        float getEyeHeight() const;
+        //Sectors further apart than this are never visible, 0 for no limit.
+        void setMaxDistance(float distance);
+        float getMaxDistance() const;
+        //Models thinner than this are ignored as occluders.
+        void setMinOccluderSize(float size);
+        float getMinOccluderSize() const;
+
+        int prepare(DriverLevel* level);
+        void clear();
+        int getNumSectors() const;
+        int getNumOccluders() const;
+        //Upper bound on the rays buildSector casts for every prepared sector, samplesPerSide^4 for each pair of
+        //sectors within the maximum distance.
+        long long getMaxRayCount() const;
+
+        void buildSector(int sector, SectorBitset* out) const;
+        //Builds every prepared sector on the calling thread.
+        void buildAll(vector<SectorBitset>& out) const;
+
+    protected:
+        void addOccluder(const WorldModelDef* def, ModelContainer* models);
+        void buildGrid();
+        bool isBlocked(const Vector3f& from, const Vector3f& to) const;
+        bool isInRange(const VisibilitySectorBounds& from, const VisibilitySectorBounds& to) const;
+        void createSamples(int sector);
+
+        int samplesPerSide;
+        float eyeHeight;
+        float maxDistance;
+        float minOccluderSize;
+
+        int numSectors;
+        vector<VisibilitySectorBounds> bounds;
+        vector<vector<Vector3f> > samples;
+        vector<VisibilityOccluder> occluders;
+
+        float cellSize;
+        float originX,originZ;
+        int cellsX,cellsZ;
+        vector<vector<int> > cells;
+};
+
+#endif
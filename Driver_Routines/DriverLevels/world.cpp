@@ -45,7 +45,7 @@ void SectorTextureList::removeTexture(int idx)
 
 void SectorTextureList::addTexture(int tex)
 {
-    if(numTexturesUsed < 64)
+    if(numTexturesUsed < SECTOR_TEXTURE_LIMIT)
     {
         textures[numTexturesUsed] = tex;
         numTexturesUsed++;
@@ -187,6 +187,34 @@ void WorldModelDef::setModelIndex(int idx)
     else modelNum = 0;
 };
 
+//Only the first 2 bytes of rot are stored on disk, the rest of the float is left as it was.
+void WorldModelDef::decode(const unsigned char* data, WorldModelDef* defs, int count, bool bridged)
+{
+    int modelOffset = (bridged ? 2 : 0);
+    for(int i = 0; i < count; i++, data += WORLD_MODEL_DEF_SIZE)
+    {
+        memcpy(&defs[i].modelNum,data+modelOffset,2);
+        memcpy(&defs[i].position.x,data+4,4);
+        memcpy(&defs[i].position.y,data+8,4);
+        memcpy(&defs[i].position.z,data+12,4);
+        memcpy(&defs[i].rot,data+16,2);
+    }
+};
+
+void WorldModelDef::encode(unsigned char* data, const WorldModelDef* defs, int count, bool bridged)
+{
+    int modelOffset = (bridged ? 2 : 0);
+    memset(data,0,count*WORLD_MODEL_DEF_SIZE);
+    for(int i = 0; i < count; i++, data += WORLD_MODEL_DEF_SIZE)
+    {
+        memcpy(data+modelOffset,&defs[i].modelNum,2);
+        memcpy(data+4,&defs[i].position.x,4);
+        memcpy(data+8,&defs[i].position.y,4);
+        memcpy(data+12,&defs[i].position.z,4);
+        memcpy(data+16,&defs[i].rot,2);
+    }
+};
+
 WorldSector::WorldSector()
 {
     numModelDefs = 0;
@@ -272,21 +300,23 @@ int WorldSector::load(IOHandle handle, IOCallbacks* callbacks, int size, DebugLo
     size -= numModelDefs*20;
     modelDefs = new WorldModelDef[numModelDefs];
 
-    log->increaseIndent();
-    for(int i = 0; i < numModelDefs; i++)
+    unsigned char* buffer = new unsigned char[numModelDefs*WORLD_MODEL_DEF_SIZE];
+    callbacks->read(buffer,WORLD_MODEL_DEF_SIZE,numModelDefs,handle);
+    WorldModelDef::decode(buffer,modelDefs,numModelDefs,false);
+
+    if(log->getLogPriority() >= DEBUG_LEVEL_RIDICULOUS)
     {
-        unsigned short temp;
-        callbacks->read(&modelDefs[i].modelNum,2,1,handle);
-        callbacks->read(&temp,2,1,handle);
-        callbacks->read(&modelDefs[i].position.x,4,1,handle);
-        callbacks->read(&modelDefs[i].position.y,4,1,handle);
-        callbacks->read(&modelDefs[i].position.z,4,1,handle);
-        callbacks->read(&modelDefs[i].rot,2,1,handle);
-        callbacks->seek(handle,2,SEEK_CUR);//padding
-        log->Log(DEBUG_LEVEL_RIDICULOUS, "%d: modelNum: %hd padding?: %hu position: (%f, %f, %f) rotation: %hd",
-                 i, modelDefs[i].modelNum, temp, modelDefs[i].position.x, modelDefs[i].position.y, modelDefs[i].position.z, modelDefs[i].rot);
+        log->increaseIndent();
+        for(int i = 0; i < numModelDefs; i++)
+        {
+            unsigned short temp;
+            memcpy(&temp,buffer+i*WORLD_MODEL_DEF_SIZE+2,2);
+            log->Log(DEBUG_LEVEL_RIDICULOUS, "%d: modelNum: %hd padding?: %hu position: (%f, %f, %f) rotation: %hd",
+                     i, modelDefs[i].modelNum, temp, modelDefs[i].position.x, modelDefs[i].position.y, modelDefs[i].position.z, modelDefs[i].rot);
+        }
+        log->decreaseIndent();
     }
-    log->decreaseIndent();
+    delete[] buffer;
     return 12+4*numContentsEntries+contentsTableDataSize+numModelDefs*20;
 };
 
@@ -308,18 +338,10 @@ int WorldSector::save(IOHandle handle, IOCallbacks* callbacks)
 
     callbacks->write(&numModelDefs,4,1,handle);
 
-    short padding = 0;
-
-    for(int i = 0; i < numModelDefs; i++)
-    {
-        callbacks->write(&modelDefs[i].modelNum,2,1,handle);
-        callbacks->write(&padding,2,1,handle);
-        callbacks->write(&modelDefs[i].position.x,4,1,handle);
-        callbacks->write(&modelDefs[i].position.y,4,1,handle);
-        callbacks->write(&modelDefs[i].position.z,4,1,handle);
-        callbacks->write(&modelDefs[i].rot,2,1,handle);
-        callbacks->write(&padding,2,1,handle);
-    }
+    unsigned char* buffer = new unsigned char[numModelDefs*WORLD_MODEL_DEF_SIZE];
+    WorldModelDef::encode(buffer,modelDefs,numModelDefs,false);
+    callbacks->write(buffer,WORLD_MODEL_DEF_SIZE,numModelDefs,handle);
+    delete[] buffer;
     return 0;
 };
 
@@ -419,21 +441,23 @@ int DriverWorld::load(IOHandle handle, IOCallbacks* callbacks, int size, DebugLo
     bridgedDefs = new WorldModelDef[numBridgedDefs];
 
     log->Log(DEBUG_LEVEL_VERBOSE,"Loading bridged definitions...");
-    log->increaseIndent();
-    for(int i = 0; i < numBridgedDefs; i++)
+    unsigned char* buffer = new unsigned char[numBridgedDefs*WORLD_MODEL_DEF_SIZE];
+    callbacks->read(buffer,WORLD_MODEL_DEF_SIZE,numBridgedDefs,handle);
+    WorldModelDef::decode(buffer,bridgedDefs,numBridgedDefs,true);
+
+    if(log->getLogPriority() >= DEBUG_LEVEL_RIDICULOUS)
     {
-        unsigned short temp;
-        callbacks->read(&temp,2,1,handle);//messup?
-        callbacks->read(&bridgedDefs[i].modelNum,2,1,handle);
-        callbacks->read(&bridgedDefs[i].position.x,4,1,handle);
-        callbacks->read(&bridgedDefs[i].position.y,4,1,handle);
-        callbacks->read(&bridgedDefs[i].position.z,4,1,handle);
-        callbacks->read(&bridgedDefs[i].rot,2,1,handle);
-        callbacks->seek(handle,2,SEEK_CUR);//padding
-        log->Log(DEBUG_LEVEL_RIDICULOUS, "%d: messup?: %hu modelNum: %hd position: (%f, %f, %f) rotation: %hd",
-                 i, temp, bridgedDefs[i].modelNum, bridgedDefs[i].position.x, bridgedDefs[i].position.y, bridgedDefs[i].position.z, bridgedDefs[i].rot);
+        log->increaseIndent();
+        for(int i = 0; i < numBridgedDefs; i++)
+        {
+            unsigned short temp;
+            memcpy(&temp,buffer+i*WORLD_MODEL_DEF_SIZE,2); //messup?
+            log->Log(DEBUG_LEVEL_RIDICULOUS, "%d: messup?: %hu modelNum: %hd position: (%f, %f, %f) rotation: %hd",
+                     i, temp, bridgedDefs[i].modelNum, bridgedDefs[i].position.x, bridgedDefs[i].position.y, bridgedDefs[i].position.z, bridgedDefs[i].rot);
+        }
+        log->decreaseIndent();
     }
-    log->decreaseIndent();
+    delete[] buffer;
 
     log->Log(DEBUG_LEVEL_VERBOSE,"Loading world sectors...");
     log->increaseIndent();
@@ -491,18 +515,10 @@ int DriverWorld::save(IOHandle handle, IOCallbacks* callbacks)
 
     callbacks->write(&numBridgedDefs,4,1,handle);
 
-    short padding = 0;
-
-    for(int i = 0; i < numBridgedDefs; i++)
-    {
-        callbacks->write(&padding,2,1,handle);
-        callbacks->write(&bridgedDefs[i].modelNum,2,1,handle);
-        callbacks->write(&bridgedDefs[i].position.x,4,1,handle);
-        callbacks->write(&bridgedDefs[i].position.y,4,1,handle);
-        callbacks->write(&bridgedDefs[i].position.z,4,1,handle);
-        callbacks->write(&bridgedDefs[i].rot,2,1,handle);
-        callbacks->write(&padding,2,1,handle);
-    }
+    unsigned char* buffer = new unsigned char[numBridgedDefs*WORLD_MODEL_DEF_SIZE];
+    WorldModelDef::encode(buffer,bridgedDefs,numBridgedDefs,true);
+    callbacks->write(buffer,WORLD_MODEL_DEF_SIZE,numBridgedDefs,handle);
+    delete[] buffer;
 
     for(int i = 0; i < header.numSectors; i++)
     {
@@ -572,6 +588,34 @@ void SectorVisibility::createEmptyData()
 
     visibilityDataSize = 14400;
     visibilityData = new unsigned char[14400];
+    memset(visibilityData,0,14400);
+};
+
+void SectorVisibility::decode(SectorBitset* out, int numSectors) const
+{
+    if(!out)
+    return;
+
+    out->resize(numSectors);
+    out->clear();
+    int n = (numSectors < visibilityDataSize ? numSectors : visibilityDataSize);
+    for(int i = 0; i < n; i++)
+    {
+        if(visibilityData[i])
+        out->set(i);
+    }
+};
+
+void SectorVisibility::encode(const SectorBitset& bits)
+{
+    int n = (bits.getSize() < visibilityDataSize ? bits.getSize() : visibilityDataSize);
+    for(int i = 0; i < n; i++)
+    {
+        if(!bits.test(i))
+        visibilityData[i] = 0;
+        else if(!visibilityData[i])
+        visibilityData[i] = 1;
+    }
 };
 
 unsigned int SectorVisibility::getRequiredSize()
@@ -611,6 +655,74 @@ void LevelVisibility::cleanup()
     delete[] sectors;
     sectors = NULL;
     numSectors = 0;
+    decoded.clear();
+};
+
+void LevelVisibility::decodeSectors()
+{
+    decoded.assign(numSectors, SectorBitset());
+    for(int i = 0; i < numSectors; i++)
+    sectors[i].decode(&decoded[i],numSectors);
+};
+
+void LevelVisibility::createEmptyData(int sectorIdx)
+{
+    if(sectorIdx >= 0 && sectorIdx < numSectors)
+    {
+        sectors[sectorIdx].createEmptyData();
+        sectors[sectorIdx].decode(&decoded[sectorIdx],numSectors);
+    }
+};
+
+int LevelVisibility::getNumSectors()
+{
+    return numSectors;
+};
+
+int LevelVisibility::getNumSectorsX()
+{
+    return numSectorsX;
+};
+
+int LevelVisibility::getNumSectorsZ()
+{
+    return numSectorsZ;
+};
+
+bool LevelVisibility::isVisible(int fromSector, int toSector)
+{
+    if(fromSector >= 0 && fromSector < (int)decoded.size())
+    return decoded[fromSector].test(toSector);
+    return false;
+};
+
+int LevelVisibility::getVisibleSectors(int fromSector, vector<int>& out)
+{
+    if(fromSector >= 0 && fromSector < (int)decoded.size())
+    return decoded[fromSector].list(out);
+    return 0;
+};
+
+const SectorBitset* LevelVisibility::getVisibility(int fromSector)
+{
+    if(fromSector >= 0 && fromSector < (int)decoded.size())
+    return &decoded[fromSector];
+    return NULL;
+};
+
+void LevelVisibility::setVisible(int fromSector, int toSector, bool visible)
+{
+    if(fromSector >= 0 && fromSector < (int)decoded.size() && toSector >= 0 && toSector < numSectors)
+    decoded[fromSector].set(toSector,visible);
+};
+
+void LevelVisibility::setVisibility(int fromSector, const SectorBitset& bits)
+{
+    if(fromSector >= 0 && fromSector < (int)decoded.size())
+    {
+        decoded[fromSector] = bits;
+        decoded[fromSector].resize(numSectors);
+    }
 };
 
 int LevelVisibility::load(IOHandle handle, IOCallbacks* callbacks, int size, DebugLogger* log)
@@ -667,6 +779,7 @@ int LevelVisibility::load(IOHandle handle, IOCallbacks* callbacks, int size, Deb
         }
     }
     delete[] offsetTable;
+    decodeSectors();
     if(log)
     log->Log(DEBUG_LEVEL_DEBUG,"All sector visibility tables loaded successfully.");
     return 0;
@@ -704,6 +817,7 @@ int LevelVisibility::save(IOHandle handle, IOCallbacks* callbacks)
 
     for(int i = 0; i < numSectors; i++)
     {
+        sectors[i].encode(decoded[i]);
         sectors[i].save(handle,callbacks);
     }
     return 0;
@@ -4,6 +4,10 @@
 #include "../ioFuncs.hpp"
 #include "../../vector.hpp"
 #include "../../Log_Routines/debug_logger.hpp"
+#include "sectorBitset.hpp"
+
+//The list holds 70 bytes ending with 0xff, but only this many textures are ever added.
+const int SECTOR_TEXTURE_LIMIT = 64;
 
 class SectorTextureList
 {
@@ -43,6 +47,8 @@ class SectorTextureUsage
         SectorTextureList textureLists[1024];
 };
 
+#define WORLD_MODEL_DEF_SIZE 20
+
 class WorldModelDef
 {
     public:
@@ -50,6 +56,11 @@ class WorldModelDef
         int getModelIndex();
         void setModelIndex(int idx);
 
+        //Convert count 20 byte records to and from a buffer in one pass. Bridged records have their
+        //padding before the model number rather than after it.
+        static void decode(const unsigned char* data, WorldModelDef* defs, int count, bool bridged);
+        static void encode(unsigned char* data, const WorldModelDef* defs, int count, bool bridged);
+
         short modelNum;
         Vector3f position;
         float rot;
@@ -132,6 +143,12 @@ class SectorVisibility
 
         void createEmptyData(); //needed to repair broken level part
 
+        //UNVERIFIED: byte i of the table is read as whether sector i can be seen, any non zero value meaning visible.
+        //The layout is a guess that fits the 14400 byte tables, it has not been checked against the game.
+        void decode(SectorBitset* out, int numSectors) const;
+        //Only bytes whose visibility changed are rewritten, visible ones as 1, so an unedited table saves unchanged.
+        void encode(const SectorBitset& bits);
+
     protected:
         int visibilityDataSize;
         unsigned char* visibilityData;
@@ -149,7 +166,22 @@ class LevelVisibility
         unsigned int getRequiredSize();
         int save(IOHandle handle, IOCallbacks* callbacks);
 
+        int getNumSectors();
+        int getNumSectorsX();
+        int getNumSectorsZ();
+
+        //UNVERIFIED: built on SectorVisibility::decode's guessed layout, see there before relying on it.
+        //Tables are decoded on load and whenever a raw table is replaced, edits are encoded back on save.
+        bool isVisible(int fromSector, int toSector);
+        int getVisibleSectors(int fromSector, vector<int>& out);
+        const SectorBitset* getVisibility(int fromSector);
+        void setVisible(int fromSector, int toSector, bool visible);
+        void setVisibility(int fromSector, const SectorBitset& bits);
+        void createEmptyData(int sectorIdx); //Repairs a sector's table, leaving nothing visible from it.
+
     protected:
+        void decodeSectors();
+
         int unk1;
         short numSectorsX;
         short numSectorsZ;
@@ -159,6 +191,7 @@ class LevelVisibility
 
         int numSectors;
         SectorVisibility* sectors;
+        vector<SectorBitset> decoded;
 };
 
 #endif
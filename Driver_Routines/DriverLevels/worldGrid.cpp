@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include "worldGrid.hpp"
+#include "models.hpp"
+
+#define WORLD_GRID_MAX_CELLS 4096 //Per side.
+
+WorldModelGrid::WorldModelGrid()
+{
+    world = NULL;
+    requestedCellSize = 0.0f;
+    clear();
+};
+
+void WorldModelGrid::setCellSize(float size)
+{
+    requestedCellSize = (size > 0.0f ? size : 0.0f);
+};
+
+float WorldModelGrid::getCellSize() const
+{
+    return grid.getCellSize();
+};
+
+void WorldModelGrid::clear()
+{
+    grid.clear();
+    minX = minZ = FLT_MAX;
+    maxX = maxZ = -FLT_MAX;
+    cells.clear();
+    instances.clear();
+    sectorStart.clear();
+};
+
+void WorldModelGrid::addSector(int sectorIdx, WorldModelDef* defs, int numDefs)
+{
+    for(int i = 0; i < numDefs; i++)
+    {
+        WorldInstance instance;
+        instance.sector = sectorIdx;
+        instance.def = i;
+        instance.modelNum = defs[i].modelNum;
+        instance.position = defs[i].position;
+        instance.cell = -1;
+        instances.push_back(instance);
+    }
+    sectorStart.push_back(instances.size());
+};
+
+void WorldModelGrid::build(DriverWorld* newWorld)
+{
+    clear();
+    world = newWorld;
+    if(!world)
+        return;
+
+    sectorStart.push_back(0);
+    addSector(-1, world->getBridgedDef(0), world->getNumBridgedDefs());
+    for(int i = 0; i < world->getNumSectors(); i++)
+    {
+        WorldSector* sector = world->getSector(i);
+        addSector(i, sector->getModelDef(0), sector->getNumModelDefs());
+    }
+
+    for(unsigned int i = 0; i < instances.size(); i++)
+    {
+        minX = min(minX, instances[i].position.x);
+        minZ = min(minZ, instances[i].position.z);
+        maxX = max(maxX, instances[i].position.x);
+        maxZ = max(maxZ, instances[i].position.z);
+    }
+    if(instances.empty())
+        minX = minZ = maxX = maxZ = 0.0f;
+
+    grid.setup(minX, minZ, maxX, maxZ, instances.size(), requestedCellSize, WORLD_GRID_MAX_CELLS);
+
+    //Count first so every cell is allocated once.
+    vector<int> counts(grid.getNumCells(), 0);
+    for(unsigned int i = 0; i < instances.size(); i++)
+    {
+        instances[i].cell = grid.getCell(instances[i].position.x, instances[i].position.z);
+        counts[instances[i].cell]++;
+    }
+    cells.assign(grid.getNumCells(), vector<int>());
+    for(int i = 0; i < grid.getNumCells(); i++)
+    cells[i].reserve(counts[i]);
+    for(unsigned int i = 0; i < instances.size(); i++)
+    cells[instances[i].cell].push_back(i);
+};
+
+void WorldModelGrid::updateSector(int sectorIdx)
+{
+    if(!world || sectorIdx < -1 || sectorIdx+2 >= (int)sectorStart.size())
+        return;
+
+    WorldModelDef* defs;
+    int numDefs;
+    if(sectorIdx == -1)
+    {
+        defs = world->getBridgedDef(0);
+        numDefs = world->getNumBridgedDefs();
+    }
+    else
+    {
+        defs = world->getSector(sectorIdx)->getModelDef(0);
+        numDefs = world->getSector(sectorIdx)->getNumModelDefs();
+    }
+
+    //Adding or removing definitions shifts every instance after them.
+    int first = sectorStart[sectorIdx+1];
+    if(numDefs != sectorStart[sectorIdx+2]-first)
+    {
+        build(world);
+        return;
+    }
+
+    for(int i = 0; i < numDefs; i++)
+    {
+        WorldInstance& instance = instances[first+i];
+        instance.modelNum = defs[i].modelNum;
+        instance.position = defs[i].position;
+        minX = min(minX, instance.position.x);
+        minZ = min(minZ, instance.position.z);
+        maxX = max(maxX, instance.position.x);
+        maxZ = max(maxZ, instance.position.z);
+
+        int cell = grid.getCell(instance.position.x, instance.position.z);
+        if(cell != instance.cell)
+        {
+            removeFromCell(first+i);
+            instance.cell = cell;
+            insertIntoCell(first+i);
+        }
+    }
+};
+
+int WorldModelGrid::getNumInstances() const
+{
+    return instances.size();
+};
+
+const WorldInstance* WorldModelGrid::getInstance(int idx) const
+{
+    if(idx >= 0 && idx < (int)instances.size())
+    return &instances[idx];
+    return NULL;
+};
+
+int WorldModelGrid::findInstance(int sectorIdx, int defIdx) const
+{
+    if(sectorIdx < -1 || sectorIdx+2 >= (int)sectorStart.size())
+        return -1;
+    if(defIdx < 0 || defIdx >= sectorStart[sectorIdx+2]-sectorStart[sectorIdx+1])
+        return -1;
+    return sectorStart[sectorIdx+1]+defIdx;
+};
+
+void WorldModelGrid::insertIntoCell(int idx)
+{
+    vector<int>& cell = cells[instances[idx].cell];
+    cell.insert(lower_bound(cell.begin(), cell.end(), idx), idx);
+};
+
+void WorldModelGrid::removeFromCell(int idx)
+{
+    vector<int>& cell = cells[instances[idx].cell];
+    vector<int>::iterator it = lower_bound(cell.begin(), cell.end(), idx);
+    if(it != cell.end() && *it == idx)
+    cell.erase(it);
+};
+
+int WorldModelGrid::findInRect(float fromX, float fromZ, float toX, float toZ, vector<int>& out) const
+{
+    if(instances.empty())
+        return 0;
+
+    int x1,z1,x2,z2;
+    int found = 0;
+    grid.getCellRange(fromX, fromZ, toX, toZ, &x1, &z1, &x2, &z2);
+    for(int z = z1; z <= z2; z++)
+    {
+        for(int x = x1; x <= x2; x++)
+        {
+            const vector<int>& cell = cells[z*grid.getNumCellsX()+x];
+            for(unsigned int i = 0; i < cell.size(); i++)
+            {
+                const Vector3f& pos = instances[cell[i]].position;
+                if(pos.x >= fromX && pos.x <= toX && pos.z >= fromZ && pos.z <= toZ)
+                {
+                    out.push_back(cell[i]);
+                    found++;
+                }
+            }
+        }
+    }
+    return found;
+};
+
+int WorldModelGrid::findInRadius(float x, float z, float radius, vector<int>& out) const
+{
+    if(instances.empty())
+        return 0;
+
+    int x1,z1,x2,z2;
+    int found = 0;
+    grid.getCellRange(x-radius, z-radius, x+radius, z+radius, &x1, &z1, &x2, &z2);
+    for(int cz = z1; cz <= z2; cz++)
+    {
+        for(int cx = x1; cx <= x2; cx++)
+        {
+            const vector<int>& cell = cells[cz*grid.getNumCellsX()+cx];
+            for(unsigned int i = 0; i < cell.size(); i++)
+            {
+                const Vector3f& pos = instances[cell[i]].position;
+                float dx = pos.x-x;
+                float dz = pos.z-z;
+                if(dx*dx+dz*dz <= radius*radius)
+                {
+                    out.push_back(cell[i]);
+                    found++;
+                }
+            }
+        }
+    }
+    return found;
+};
+
+//Searches rings of cells outwards from the point until the next ring can't hold anything closer.
+int WorldModelGrid::findNearest(float x, float z, float maxDistance) const
+{
+    if(instances.empty())
+        return -1;
+
+    int best = -1;
+    float bestDist = (maxDistance >= 0.0f ? maxDistance*maxDistance : FLT_MAX);
+    int centre = grid.getCell(x, z);
+    vector<int> ring;
+
+    for(int r = 0; r <= grid.getMaxRing(); r++)
+    {
+        float ringDist = grid.getRingDistance(r);
+        if(ringDist*ringDist > bestDist)
+            break;
+
+        grid.getRing(centre, r, ring);
+        for(unsigned int j = 0; j < ring.size(); j++)
+        {
+            const vector<int>& cell = cells[ring[j]];
+            for(unsigned int i = 0; i < cell.size(); i++)
+            {
+                const Vector3f& pos = instances[cell[i]].position;
+                float dist = (pos.x-x)*(pos.x-x)+(pos.z-z)*(pos.z-z);
+                if(dist < bestDist || (dist == bestDist && best == -1))
+                {
+                    bestDist = dist;
+                    best = cell[i];
+                }
+            }
+        }
+    }
+    return best;
+};
+
+float WorldModelGrid::getRadius(int modelNum, ModelContainer* models, float defaultRadius) const
+{
+    if(!models)
+    return defaultRadius;
+
+    const DriverModel* model = models->getModel(modelNum);
+    if(model)
+    model = models->getReferencedModel(model);
+    if(!model || model->getBoundingSphereRadius() <= 0.0f)
+    return defaultRadius;
+    return model->getBoundingSphereRadius();
+};
+
+//Walks the ray across the grid one cell length at a time, testing every cell within the largest radius of each step.
+int WorldModelGrid::raycast(const Vector3f& origin, const Vector3f& direction, float maxDistance, ModelContainer* models,
+                            float defaultRadius, float* hitDistance) const
+{
+    if(instances.empty() || direction.magnitude() <= 0.0f)
+        return -1;
+
+    Vector3f dir = direction/direction.magnitude();
+    float largestRadius = defaultRadius;
+    if(models)
+    {
+        for(int i = 0; i < models->getNumModels(); i++)
+        largestRadius = max(largestRadius, getRadius(i, models, defaultRadius));
+    }
+
+    //Clip to the part of the ray over the instances.
+    float tMin = 0.0f;
+    float tMax = (maxDistance >= 0.0f ? maxDistance : FLT_MAX);
+    float lower[2] = {minX-largestRadius, minZ-largestRadius};
+    float upper[2] = {maxX+largestRadius, maxZ+largestRadius};
+    float start[2] = {origin.x, origin.z};
+    float delta[2] = {dir.x, dir.z};
+    for(int i = 0; i < 2; i++)
+    {
+        if(fabs(delta[i]) < 1e-12f)
+        {
+            if(start[i] < lower[i] || start[i] > upper[i])
+                return -1;
+            continue;
+        }
+        float t1 = (lower[i]-start[i])/delta[i];
+        float t2 = (upper[i]-start[i])/delta[i];
+        tMin = max(tMin, min(t1,t2));
+        tMax = min(tMax, max(t1,t2));
+    }
+    if(tMin > tMax)
+        return -1;
+
+    //A vertical ray stays over one spot, so one step covers it.
+    float flat = sqrt(dir.x*dir.x+dir.z*dir.z);
+    float step = (flat > 0.0f ? grid.getCellSize()/flat : tMax-tMin);
+
+    int best = -1;
+    float bestT = tMax;
+    for(float t = tMin; t <= tMax && t-largestRadius <= bestT; t += step)
+    {
+        float tEnd = min(t+step, tMax);
+        float ax = origin.x+dir.x*t, az = origin.z+dir.z*t;
+        float bx = origin.x+dir.x*tEnd, bz = origin.z+dir.z*tEnd;
+
+        int x1,z1,x2,z2;
+        grid.getCellRange(min(ax,bx)-largestRadius, min(az,bz)-largestRadius, max(ax,bx)+largestRadius, max(az,bz)+largestRadius, &x1, &z1, &x2, &z2);
+        for(int cz = z1; cz <= z2; cz++)
+        {
+            for(int cx = x1; cx <= x2; cx++)
+            {
+                const vector<int>& cell = cells[cz*grid.getNumCellsX()+cx];
+                for(unsigned int i = 0; i < cell.size(); i++)
+                {
+                    const WorldInstance& instance = instances[cell[i]];
+                    float radius = getRadius(instance.modelNum, models, defaultRadius);
+                    Vector3f offset = origin-instance.position;
+                    float b = offset.dot(dir);
+                    float c = offset.dot(offset)-radius*radius;
+                    float disc = b*b-c;
+                    if(disc < 0.0f)
+                        continue;
+                    float hit = -b-sqrt(disc);
+                    if(hit < 0.0f)
+                    hit = 0.0f; //Origin is inside the sphere.
+                    if(-b+sqrt(disc) >= 0.0f && (hit < bestT || (hit == bestT && best == -1)) && (maxDistance < 0.0f || hit <= maxDistance))
+                    {
+                        bestT = hit;
+                        best = cell[i];
+                    }
+                }
+            }
+        }
+        if(tEnd >= tMax)
+            break;
+    }
+
+    if(best != -1 && hitDistance)
+    *hitDistance = bestT;
+    return best;
+};
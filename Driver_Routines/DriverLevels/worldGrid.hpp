@@ -0,0 +1,68 @@
+#ifndef WORLD_GRID_HPP
+#define WORLD_GRID_HPP
+
+#include <vector>
+#include "world.hpp"
+#include "uniformGrid.hpp"
+
+using namespace std;
+
+class ModelContainer;
+
+//One placed model. Bridged definitions have a sector of -1.
+struct WorldInstance
+{
+    int sector;
+    int def;
+    int modelNum;
+    Vector3f position;
+    int cell;
+};
+
+//Uniform top down grid over every model placement in a DriverWorld, for range, nearest and ray queries.
+//The world raises no events, so after moving, adding or removing definitions call updateSector for the sector
+//that changed (-1 for the bridged definitions).
+class WorldModelGrid
+{
+    public:
+        WorldModelGrid();
+
+        //Width of a cell in world units, 0 picks one from the size of the world when building.
+        void setCellSize(float size);
+        float getCellSize() const;
+
+        void build(DriverWorld* newWorld);
+        void updateSector(int sectorIdx);
+        void clear();
+
+        int getNumInstances() const;
+        const WorldInstance* getInstance(int idx) const;
+        //Instance index of a definition, -1 if there isn't one.
+        int findInstance(int sectorIdx, int defIdx) const;
+
+        //Queries ignore y and append instance indices to out, returning how many were added.
+        int findInRect(float minX, float minZ, float maxX, float maxZ, vector<int>& out) const;
+        int findInRadius(float x, float z, float radius, vector<int>& out) const;
+        //Closest instance to a point, or -1 if there is none within maxDistance (a negative distance means no limit).
+        int findNearest(float x, float z, float maxDistance = -1.0f) const;
+        //Closest instance whose bounding sphere the ray hits. Sphere radii come from models when it is given,
+        //otherwise every instance uses defaultRadius. The distance along the ray is stored in hitDistance.
+        int raycast(const Vector3f& origin, const Vector3f& direction, float maxDistance, ModelContainer* models,
+                    float defaultRadius = 1.0f, float* hitDistance = NULL) const;
+
+    protected:
+        void addSector(int sectorIdx, WorldModelDef* defs, int numDefs);
+        void insertIntoCell(int idx);
+        void removeFromCell(int idx);
+        float getRadius(int modelNum, ModelContainer* models, float defaultRadius) const;
+
+        DriverWorld* world;
+        float requestedCellSize;
+        UniformGrid grid;
+        vector<vector<int> > cells;
+        vector<WorldInstance> instances;
+        vector<int> sectorStart; //Instances of sector i are sectorStart[i+1] to sectorStart[i+2]-1, the bridged ones come first.
+        float minX,minZ,maxX,maxZ; //Bounds of every instance, which can grow past the cells after an update.
+};
+
+#endif
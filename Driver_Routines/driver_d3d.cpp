@@ -1,7 +1,12 @@
+#include <algorithm>
 #include "driver_d3d.hpp"
 
+//Textures and palette indices above this are left out of the lookup tables, so a corrupt file can't make them huge.
+#define D3D_MAX_INDEXED 0x10000
+
 D3DEntry::D3DEntry()
 {
+    owner = NULL;
     eventManager = NULL;
     index = -1;
     texture = 0;
@@ -9,9 +14,10 @@ D3DEntry::D3DEntry()
     palettes = NULL;
 };
 
-D3DEntry::D3DEntry(CEventMgr<IDriverD3DEvents>* eventMgr, int idx)
+D3DEntry::D3DEntry(DriverD3D* d3d, int idx)
 {
-    eventManager = eventMgr;
+    owner = d3d;
+    eventManager = &d3d->eventManager;
     index = idx;
     texture = 0;
     numPalettes = 0;
@@ -25,6 +31,11 @@ D3DEntry::~D3DEntry()
 
 void D3DEntry::cleanup()
 {
+    if(owner)
+    {
+        for(int i = 0; i < numPalettes; i++)
+        owner->paletteChanged(index,palettes[i],-1);
+    }
     if(palettes)
     delete[] palettes;
     palettes = NULL;
@@ -52,6 +63,8 @@ void D3DEntry::setTexture(int tex)
 {
     int oldTex = texture;
     texture = tex;
+    if(owner)
+        owner->textureChanged(index,oldTex,tex);
     if(eventManager)
         eventManager->Raise(EVENT(IDriverD3DEvents::entryTextureChanged)(index,oldTex));
 };
@@ -60,7 +73,10 @@ void D3DEntry::setPaletteIndex(int idx, int pal)
 {
     if(idx >= 0 && idx < numPalettes)
     {
+        int oldPal = palettes[idx];
         palettes[idx] = pal;
+        if(owner)
+            owner->paletteChanged(index,oldPal,pal);
         if(eventManager)
             eventManager->Raise(EVENT(IDriverD3DEvents::entryIndexChanged)(index,idx));
     }
@@ -70,6 +86,8 @@ void D3DEntry::removePaletteIndex(int idx)
 {
     if(idx >= 0 && idx < numPalettes)
     {
+        if(owner)
+            owner->paletteChanged(index,palettes[idx],-1);
         int* temp = NULL;
         if(numPalettes > 0)
         {
@@ -103,6 +121,8 @@ void D3DEntry::insertPaletteIndex(int idx,int pal)
         temp[idx] = pal;
         palettes = temp;
         numPalettes++;
+        if(owner)
+            owner->paletteChanged(index,-1,pal);
         if(eventManager)
             eventManager->Raise(EVENT(IDriverD3DEvents::entryIndexInserted)(index, idx));
     }
@@ -124,8 +144,11 @@ int D3DEntry::load(IOHandle handle, IOCallbacks* callbacks, int size)
     if(!handle)
     return -1;
 
+    int oldTex = texture;
     callbacks->read(&texture,4,1,handle);
     callbacks->read(&numPalettes,4,1,handle);
+    if(owner)
+        owner->textureChanged(index,oldTex,texture);
 
     if(size >= 0 && size < 8+numPalettes*4)
     {
@@ -135,6 +158,11 @@ int D3DEntry::load(IOHandle handle, IOCallbacks* callbacks, int size)
 
     palettes = new int[numPalettes];
     callbacks->read(palettes,4,numPalettes,handle);
+    if(owner)
+    {
+        for(int i = 0; i < numPalettes; i++)
+        owner->paletteChanged(index,-1,palettes[i]);
+    }
 
     return 8+numPalettes*4;
 };
@@ -185,12 +213,16 @@ void DriverD3D::cleanup()
         for(int i = 0; i < numEntries; i++)
         {
             if(entries[i])
+            {
+                entries[i]->owner = NULL;
                 delete entries[i];
+            }
         }
         delete[] entries;
     }
     entries = NULL;
     numEntries = 0;
+    rebuildIndex();
 
     //Raise D3D has been reset event.
     eventManager.Raise(EVENT(IDriverD3DEvents::D3DReset)(false));
@@ -210,6 +242,13 @@ D3DEntry* DriverD3D::getEntry(int idx) const
 
 int DriverD3D::findTexture(int tex) const
 {
+    if(tex >= 0 && tex < D3D_MAX_INDEXED)
+    {
+        if(tex < (int)textureEntries.size())
+        return textureEntries[tex];
+        return -1;
+    }
+
     for(int i = 0; i < numEntries; i++)
     {
         if(entries[i]->getTexture() == tex)
@@ -223,6 +262,85 @@ D3DEntry* DriverD3D::getTextureEntry(int tex) const
     return getEntry(findTexture(tex));
 };
 
+int DriverD3D::getNumPaletteReferences(int pal) const
+{
+    if(pal >= 0 && pal < (int)paletteEntries.size())
+    return paletteEntries[pal].size();
+    return 0;
+};
+
+int DriverD3D::getPaletteReference(int pal, int idx) const
+{
+    if(idx >= 0 && idx < getNumPaletteReferences(pal))
+    return paletteEntries[pal][idx];
+    return -1;
+};
+
+void DriverD3D::rebuildIndex()
+{
+    textureEntries.clear();
+    textureCounts.clear();
+    paletteEntries.clear();
+    for(int i = 0; i < numEntries; i++)
+    {
+        textureChanged(i,-1,entries[i]->getTexture());
+        for(int j = 0; j < entries[i]->getNumPaletteIndicies(); j++)
+        paletteChanged(i,-1,entries[i]->getPaletteIndex(j));
+    }
+};
+
+void DriverD3D::textureChanged(int entryIdx, int oldTex, int newTex)
+{
+    if(oldTex >= 0 && oldTex < (int)textureEntries.size())
+    {
+        textureCounts[oldTex]--;
+        if(textureEntries[oldTex] == entryIdx)
+        {
+            textureEntries[oldTex] = -1;
+            //Only a texture listed twice needs a search for the next entry.
+            for(int i = entryIdx+1; i < numEntries && textureCounts[oldTex] > 0; i++)
+            {
+                if(entries[i]->getTexture() == oldTex)
+                {
+                    textureEntries[oldTex] = i;
+                    break;
+                }
+            }
+        }
+    }
+
+    if(newTex >= 0 && newTex < D3D_MAX_INDEXED)
+    {
+        if(newTex >= (int)textureEntries.size())
+        {
+            textureEntries.resize(newTex+1,-1);
+            textureCounts.resize(newTex+1,0);
+        }
+        textureCounts[newTex]++;
+        if(textureEntries[newTex] == -1 || textureEntries[newTex] > entryIdx)
+        textureEntries[newTex] = entryIdx;
+    }
+};
+
+void DriverD3D::paletteChanged(int entryIdx, int oldPal, int newPal)
+{
+    if(oldPal >= 0 && oldPal < (int)paletteEntries.size())
+    {
+        vector<int>& list = paletteEntries[oldPal];
+        vector<int>::iterator it = lower_bound(list.begin(),list.end(),entryIdx);
+        if(it != list.end() && *it == entryIdx)
+        list.erase(it);
+    }
+
+    if(newPal >= 0 && newPal < D3D_MAX_INDEXED)
+    {
+        if(newPal >= (int)paletteEntries.size())
+        paletteEntries.resize(newPal+1);
+        vector<int>& list = paletteEntries[newPal];
+        list.insert(upper_bound(list.begin(),list.end(),entryIdx),entryIdx);
+    }
+};
+
 void DriverD3D::removeEntry(int idx)
 {
     if(idx >= 0 && idx < numEntries)
@@ -237,10 +355,12 @@ void DriverD3D::removeEntry(int idx)
             for(int i = idx; i < numEntries-1; i++)
                 temp[i]->index--; //Update index passed back in events.
         }
+        entries[idx]->owner = NULL;
         delete entries[idx];
         delete[] entries;
         entries = temp;
         numEntries--;
+        rebuildIndex();
         //Raise entry removed event.
         eventManager.Raise(EVENT(IDriverD3DEvents::entryRemoved)(idx, texture));
     }
@@ -276,9 +396,10 @@ void DriverD3D::addEntry(int tex)
         delete[] entries;
     }
     entries = temp;
-    entries[index] = new D3DEntry(&eventManager,index);
-    entries[index]->setTexture(tex);
+    entries[index] = new D3DEntry(this,index);
     numEntries++;
+    rebuildIndex();
+    entries[index]->setTexture(tex);
 
     //Raise entry inserted event.
     eventManager.Raise(EVENT(IDriverD3DEvents::entryInserted)(index));
@@ -329,8 +450,12 @@ int DriverD3D::load(IOHandle handle, IOCallbacks* callbacks)
         memset(entries, 0, numEntries*sizeof(D3DEntry*));
         for(int i = 0; i < numEntries; i++)
         {
-            entries[i] = new D3DEntry(&eventManager,i);
+            //Entries are attached after loading, the index is rebuilt once they are all in.
+            entries[i] = new D3DEntry();
             int ret = entries[i]->load(handle,callbacks,end-current);
+            entries[i]->owner = this;
+            entries[i]->eventManager = &eventManager;
+            entries[i]->index = i;
             if(ret < 0)
             {
                 cleanup();
@@ -340,6 +465,7 @@ int DriverD3D::load(IOHandle handle, IOCallbacks* callbacks)
             totalRead += ret;
         }
     }
+    rebuildIndex();
 
     //Raise d3d opened event.
     eventManager.Raise(EVENT(IDriverD3DEvents::D3DOpened)());
@@ -1,9 +1,12 @@
 #ifndef DRIVER_D3D
 #define DRIVER_D3D
 
+#include <vector>
 #include "ioFuncs.hpp"
 #include "../EventMgr.hpp"
 
+using namespace std;
+
 /*! \file driver_d3d.hpp
  * API for loading D3D files for the game Driver: You are the Wheelman.
  * D3D files are used to specify which palettes are used by which textures. This api can be used to safely and easily load, manipulate, and save such files.
@@ -110,6 +113,7 @@ class D3DEntry
         /*! Loads entry from an IO handle.
          *
          * Although this function is safe to use, it generally should not be used except by DriverD3D class. If size is greater than 0 then corruption checking is preformed.
+         * The owning DriverD3D's texture and palette lookups are updated with the new values.
          * \param handle IO handle to be used.
          * \param callbacks Pointer to a callbacks structure for use with the handle.
          * \param size [optional] Amount of data left in the file.
@@ -140,7 +144,8 @@ class D3DEntry
         int getRequiredSize() const;
 
     protected:
-        D3DEntry(CEventMgr<IDriverD3DEvents>* eventMgr, int idx);
+        D3DEntry(DriverD3D* d3d, int idx);
+        DriverD3D* owner; //Kept up to date with texture and palette changes, NULL for entries not in a DriverD3D.
         CEventMgr<IDriverD3DEvents>* eventManager;
         int index;
 
@@ -158,6 +163,8 @@ class D3DEntry
 class DriverD3D
 {
     public:
+        friend class D3DEntry; //So entries can keep the texture and palette indexes up to date.
+
         DriverD3D();
         ~DriverD3D();
         /*! Frees memory for all allocated D3DEntries.
@@ -231,6 +238,19 @@ class DriverD3D
          */
         D3DEntry* getTextureEntry(int tex) const; //Convinience function
 
+        /*! Gets the number of times a palette index is used by the entries, counting every use within an entry.
+         * \param pal Palette index to look up.
+         * \return Returns number of references, 0 if the palette index is unused.
+         */
+        int getNumPaletteReferences(int pal) const;
+
+        /*! Gets an entry using the given palette index. Entries that use the palette index more than once are listed once for each use.
+         * \param pal Palette index to look up.
+         * \param idx Position in the list, which must be less than the value returned by getNumPaletteReferences(pal).
+         * \return Returns an entry index, lowest first; -1 if either index was invalid.
+         */
+        int getPaletteReference(int pal, int idx) const;
+
         /*! Removes the entry at the given index. Not to be confused with removing the entry for a texture index.
          * \param idx Index of entry to remove.
          */
@@ -257,9 +277,19 @@ class DriverD3D
         void unregisterEventHandler(IDriverD3DEvents* handler);
 
     protected:
+        void rebuildIndex();
+        void textureChanged(int entryIdx, int oldTex, int newTex);
+        void paletteChanged(int entryIdx, int oldPal, int newPal);
+
         CEventMgr<IDriverD3DEvents> eventManager;
         int numEntries;
         D3DEntry** entries; //Why pointer array? So we don't destroy objects when resizing!
+
+        //Lookup tables from texture index to its first entry and from palette index to the entries using it.
+        //Entry indices shift on every add and remove, which already copy the whole list, so both are rebuilt then.
+        vector<int> textureEntries;
+        vector<int> textureCounts;
+        vector<vector<int> > paletteEntries;
 };
 
 #endif
@@ -54,6 +54,7 @@ void DriverLevel::cleanup()
     visibility.cleanup();
     log->Log(DEBUG_LEVEL_NORMAL,"Cleaning up world...");
     world.cleanup();
+    worldGrid.clear();
 
     log->Log(DEBUG_LEVEL_NORMAL,"Cleaning up road tables...");
     roadTables.cleanup();
@@ -437,6 +438,8 @@ int DriverLevel::load(IOHandle handle, IOCallbacks* callbacks, unsigned int open
     }
     log->Log(DEBUG_LEVEL_NORMAL,"Level finished loading successfully!");
 
+    worldGrid.build(&world);
+
     //Send level opened event.
     eventManager.Raise(EVENT(IDriverLevelEvents::levelOpened)());
     return dataRead;
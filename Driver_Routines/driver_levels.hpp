@@ -12,6 +12,7 @@
 #include "DriverLevels/heightmaps.hpp"
 #include "DriverLevels/randomModelPlacement.hpp"
 #include "DriverLevels/World.hpp"
+#include "DriverLevels/worldGrid.hpp"
 
 const unsigned int LEV_TEXTURES               = 0x00000001;
 const unsigned int LEV_MODELS                 = 0x00000002;
@@ -110,6 +111,7 @@ class DriverLevel
         HeightmapTiles heightmapTiles;
 
         DriverWorld world;
+        WorldModelGrid worldGrid; //Built on load, call worldGrid.updateSector after editing a sector's definitions.
         LevelVisibility visibility;
         SectorTextureUsage sectorTextures;
 
@@ -106,6 +106,9 @@ MainWindow::MainWindow() : playerCosmetics(18), civilianCosmetics(12)
     levelLoader->setCivilianDenting(&civilianDenting);
     levelLoader->setLog(&mainLog);
 
+    visibilityDialog = new VisibilityCheckDialog(this);
+    visibilityDialog->setLevel(&level);
+
     saveDialog = new SaveAsDialog(this);
     connect(saveDialog, SIGNAL(saveLevel(QString,unsigned int)), this, SLOT(saveLevel(QString,unsigned int)));
     connect(saveDialog, SIGNAL(saveD3D(QString)), this, SLOT(saveD3D(QString)));
@@ -118,6 +121,8 @@ MainWindow::MainWindow() : playerCosmetics(18), civilianCosmetics(12)
     createActions();
     createMenus();
     textureBrowser->setupEditMenu(editMenu);
+    editMenu->addSeparator();
+    editMenu->addAction(checkVisibilityAction);
     setConvenienceActionsEnabled(false);
 
     centralWindow->addWidget(startPage);
@@ -270,6 +275,7 @@ void MainWindow::loadSettings()
 
     textureBrowser->loadSettings();
     modelViewPanel->loadSettings();
+    visibilityDialog->loadSettings();
     mainLog.Log("Finished loading settings.");
 };
 
@@ -286,6 +292,7 @@ void MainWindow::saveSettings()
 
     textureBrowser->saveSettings();
     modelViewPanel->saveSettings();
+    visibilityDialog->saveSettings();
 };
 
 void MainWindow::createActions()
@@ -342,6 +349,9 @@ void MainWindow::createActions()
 
     viewDefinitionEditorAction = new QAction(tr("Texture &Definitions"),this);
     connect(viewDefinitionEditorAction, SIGNAL(triggered()), this, SLOT(viewDefinitionEditor()));
+
+    checkVisibilityAction = new QAction(tr("Check &Visibility Tables..."),this);
+    connect(checkVisibilityAction, SIGNAL(triggered()), visibilityDialog, SLOT(exec()));
 };
 
 void MainWindow::createMenus()
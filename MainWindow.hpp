@@ -17,6 +17,7 @@
 #include "QtGUI/Textures/TextureDefinitionEditor.hpp"
 #include "QtGUI/Textures/TextureBrowser.hpp"
 #include "QtGUI/StartScreen.hpp"
+#include "QtGUI/World/VisibilityCheckDialog.hpp"
 
 #include "Log_Routines/debug_logger.hpp"
 #include "Log_Routines/default_loggers.hpp"
@@ -113,6 +114,7 @@ class MainWindow : public QMainWindow
         QAction* saveAs;
 
         QMenu* editMenu;
+        QAction* checkVisibilityAction;
 
         QMenu* viewMenu;
         QAction* viewModelsAction;
@@ -139,6 +141,7 @@ class MainWindow : public QMainWindow
         SaveAsDialog* saveDialog;
         TextureDefinitionEditor* definitionEditor;
         TextureBrowser* textureBrowser;
+        VisibilityCheckDialog* visibilityDialog;
 };
 
 #endif
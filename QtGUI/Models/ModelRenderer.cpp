@@ -15,6 +15,9 @@ ModelShaders::ModelShaders(QOpenGLContext* context, DebugLogger* logger)
     shaders[1] = &colored_normal;
     shaders[2] = &colored_textured;
     shaders[3] = &colored_normal_textured;
+    shaders[4] = &colored_textured_indexed;
+    shaders[5] = &colored_normal_textured_indexed;
+    numShaders = 4;
 };
 
 int ModelShaders::initializeShaders()
@@ -58,13 +61,40 @@ int ModelShaders::initializeShaders()
     colored_textured.setUniformValue("colorTexture",0);
     colored_normal_textured.setUniformValue("colorTexture",0);
 
+    //Indexed shaders are optional, models fall back to the RGBA textures if they fail.
+    //The palette lookup doesn't depend on normals, so both programs share one fragment shader.
+    QString indexedFragmentShaderFilename = QString("data/shaders/PCTI.frag");
+    numShaders = 6;
+
+    for(int i = 4; i < 6; i++)
+    {
+        bool success = shaders[i]->addShaderFromSourceFile(QOpenGLShader::Vertex, vertexShaderFilenames[i-2]);
+        success = success && shaders[i]->addShaderFromSourceFile(QOpenGLShader::Fragment, indexedFragmentShaderFilename);
+        success = success && shaders[i]->link();
+        success = success && shaders[i]->bind();
+        if(!success)
+        {
+            log->Log("WARNING: Could not create indexed shader program %d: %s", i, shaders[i]->log().toLocal8Bit().data());
+            numShaders = 4;
+        }
+        else
+        {
+            shaders[i]->setUniformValue("colorTexture",0);
+            shaders[i]->setUniformValue("paletteTexture",1);
+        }
+    }
+
     log->Log("Finished creating shaders.");
     return ret;
 };
 
-void ModelShaders::bind(bool normal, bool textured)
+void ModelShaders::bind(bool normal, bool textured, bool indexed)
 {
-    bool success = shaders[normal+textured*2]->bind();
+    int idx = normal+textured*2;
+    if(indexed && textured && numShaders > 4)
+        idx = 4+normal;
+
+    bool success = shaders[idx]->bind();
     if(!success)
     {
         log->Log("WARNING: Could not bind shader program (%s, %s)!", (normal ? "has normal" : "no normal"), (textured ? "has texture" : "no texture"));
@@ -73,13 +103,27 @@ void ModelShaders::bind(bool normal, bool textured)
 
 void ModelShaders::release()
 {
-    for(int i = 0; i < 4; i++)
+    for(int i = 0; i < numShaders; i++)
     shaders[i]->release();
 };
 
+bool ModelShaders::hasIndexedShaders()
+{
+    return numShaders > 4;
+};
+
+void ModelShaders::setPaletteRow(float row)
+{
+    for(int i = 4; i < numShaders; i++)
+    {
+        shaders[i]->bind();
+        shaders[i]->setUniformValue("paletteRow", row);
+    }
+};
+
 void ModelShaders::setProjectionMatrix(QMatrix4x4 projection)
 {
-    for(int i = 0; i < 4; i++)
+    for(int i = 0; i < numShaders; i++)
     {
         shaders[i]->bind();
         shaders[i]->setUniformValue("ProjectionMatrix", projection);
@@ -88,7 +132,7 @@ void ModelShaders::setProjectionMatrix(QMatrix4x4 projection)
 
 void ModelShaders::setViewMatrix(QMatrix4x4 view)
 {
-    for(int i = 0; i < 4; i++)
+    for(int i = 0; i < numShaders; i++)
     {
         shaders[i]->bind();
         shaders[i]->setUniformValue("ViewMatrix", view);
@@ -97,7 +141,7 @@ void ModelShaders::setViewMatrix(QMatrix4x4 view)
 
 void ModelShaders::setModelMatrix(QMatrix4x4 model)
 {
-    for(int i = 0; i < 4; i++)
+    for(int i = 0; i < numShaders; i++)
     {
         shaders[i]->bind();
         shaders[i]->setUniformValue("ModelMatrix", model);
@@ -892,7 +936,7 @@ void ModelRenderer::buildRenderData(const DriverModel* model, const DriverModel*
     //If legacy rendering enabled, indicies and vertices must be kept around for drawing, and are ready for use.
 };
 
-void ModelRenderer::render(int group)
+void ModelRenderer::render(int group, bool indexed)
 {
     if(group >= 0 && group < numTextureGroups)
     {
@@ -905,7 +949,7 @@ void ModelRenderer::render(int group)
                     if(vaoIds[i] != 0)
                     {
                         if(shaders)
-                            shaders->bind(i&1, i&2);
+                            shaders->bind(i&1, i&2, indexed);
                         myGlBindVertexArray(vaoIds[i]);
                         glDrawElements(GL_TRIANGLES, 3*(groups[group].end[i]-groups[group].start[i]), GL_UNSIGNED_SHORT, (const void*)(3*2*groups[group].start[i]));
                     }
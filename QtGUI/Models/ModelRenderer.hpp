@@ -79,9 +79,12 @@ class ModelShaders
     public:
         ModelShaders(QOpenGLContext* context, DebugLogger* logger = NULL);
 
-        void bind(bool normal, bool textured);
+        void bind(bool normal, bool textured, bool indexed = false);
         void release();
 
+        bool hasIndexedShaders();
+        void setPaletteRow(float row);
+
         void setProjectionMatrix(QMatrix4x4 projection);
         void setViewMatrix(QMatrix4x4 view);
         void setModelMatrix(QMatrix4x4 model);
@@ -94,7 +97,10 @@ class ModelShaders
         QOpenGLShaderProgram colored_normal;
         QOpenGLShaderProgram colored_textured;
         QOpenGLShaderProgram colored_normal_textured;
-        QOpenGLShaderProgram* shaders[4];
+        QOpenGLShaderProgram colored_textured_indexed;
+        QOpenGLShaderProgram colored_normal_textured_indexed;
+        QOpenGLShaderProgram* shaders[6];
+        int numShaders;
 
         DebugLogger dummy;
         DebugLogger* log;
@@ -193,7 +199,7 @@ class ModelRenderer : public QOpenGLFunctions
 
         void useLegacyRendering(bool use);
         void buildRenderData(const DriverModel* model, const DriverModel* reference);
-        void render(int group = -1);
+        void render(int group = -1, bool indexed = false);
         int getNumGroups();
         int getTextureUsed(int idx);
         static bool hasMissingFunctions();
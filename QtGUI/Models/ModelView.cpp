@@ -182,9 +182,16 @@ void ModelView::initializeGL()
             if(log)
                 log->Log("Failed to meet minimum requirements for modern OpenGL, reverting to legacy rendering.");
         }
-        else if(log)
+        else
         {
-            log->Log("Passed compatibility test.");
+            if(log)
+                log->Log("Passed compatibility test.");
+            if(textures && shaders->hasIndexedShaders() && settings.value("indexedTextures", true).toBool())
+            {
+                if(log)
+                    log->Log("Using indexed textures with palette lookup.");
+                textures->setIndexedTextures(true);
+            }
         }
     }
     else if(log)
@@ -223,6 +230,7 @@ void ModelView::paintGL()
 
     for(int i = 0; i < render->getNumGroups(); i++)
     {
+        bool indexed = false;
         if(render->getTextureUsed(i) == -1)
         {
             glDisable(GL_TEXTURE_2D);
@@ -237,17 +245,34 @@ void ModelView::paintGL()
                 //TODO: disable alpha test
             }
             glEnable(GL_TEXTURE_2D);
-            glBindTexture(GL_TEXTURE_2D, textures->getTexture(render->getTextureUsed(i), textures->getCurrentPalette(render->getTextureUsed(i))));
+
+            int texnum = render->getTextureUsed(i);
+            if(!legacyRendering && textures->usesIndexedTextures() && textures->getIndexTexture(texnum) && textures->getPaletteTexture())
+            {
+                //Palette lookup is done in the shader, so only the palette row changes between palettes.
+                int height = textures->getPaletteTextureHeight();
+                int row = textures->getPaletteRow(texnum, textures->getCurrentPalette(texnum));
+                if(row < 0 || row >= height)
+                row = height-1;
+
+                indexed = true;
+                shaders->setPaletteRow((row+0.5f)/height);
+                context()->functions()->glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_2D, textures->getPaletteTexture());
+                context()->functions()->glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, textures->getIndexTexture(texnum));
+            }
+            else glBindTexture(GL_TEXTURE_2D, textures->getTexture(texnum, textures->getCurrentPalette(texnum)));
         }
 
         glCullFace(GL_BACK);
         glEnable(GL_POLYGON_OFFSET_FILL);
         glPolygonOffset(-1,-100);
-        render->render(i);
+        render->render(i, indexed);
         glPolygonMode(GL_BACK,GL_LINE);
         glCullFace(GL_FRONT);
         glDisable(GL_POLYGON_OFFSET_FILL);
-        render->render(i);
+        render->render(i, indexed);
         glCullFace(GL_BACK);
     }
 };
@@ -481,7 +481,10 @@ void ModelViewPanel::insertModel(int index)
             }
         }
         if(changed)
-        emit worldSectorChanged(-1);
+        {
+            level->worldGrid.updateSector(-1);
+            emit worldSectorChanged(-1);
+        }
         changed = false;
 
         for(int i = 0; i < level->world.getNumSectors(); i++)
@@ -499,7 +502,10 @@ void ModelViewPanel::insertModel(int index)
                 }
             }
             if(changed)
-            emit worldSectorChanged(i);
+            {
+                level->worldGrid.updateSector(i);
+                emit worldSectorChanged(i);
+            }
         }
         emit modelInserted(index);
     }
@@ -0,0 +1,129 @@
+#include "OptimizePalettesDialog.hpp"
+
+OptimizePalettesDialog::OptimizePalettesDialog(QWidget* parent) : QDialog(parent)
+{
+    textureBlock = NULL;
+    d3d = NULL;
+
+    setWindowTitle(tr("Optimize Palettes"));
+
+    toleranceLabel = new QLabel(tr("Color tolerance:"),this);
+    toleranceSelect = new QSpinBox(this);
+    toleranceSelect->setRange(0,255);
+    toleranceSelect->setToolTip(tr("Largest average color difference of a merge, only counting colors the textures use."));
+    reindexTextures = new QCheckBox(tr("Re-index textures to match merged palettes"),this);
+    reindexTextures->setToolTip(tr("Allows palettes with the same colors in a different order to merge. Textures with transparency or several palettes are never changed."));
+    compactSlots = new QCheckBox(tr("Compact palette slots"),this);
+
+    resultLabel = new QLabel(this);
+    resultList = new QListWidget(this);
+
+    analyzeButton = new QPushButton(tr("Analyze"),this);
+    analyzeButton->setMaximumWidth(100);
+    optimizeButton = new QPushButton(tr("Optimize"),this);
+    optimizeButton->setMaximumWidth(100);
+    closeButton = new QPushButton(tr("Close"),this);
+    closeButton->setMaximumWidth(100);
+
+    QHBoxLayout* toleranceLayout = new QHBoxLayout();
+    toleranceLayout->addWidget(toleranceLabel);
+    toleranceLayout->addWidget(toleranceSelect);
+
+    QHBoxLayout* buttonsLayout = new QHBoxLayout();
+    buttonsLayout->addWidget(analyzeButton);
+    buttonsLayout->addWidget(optimizeButton);
+    buttonsLayout->addWidget(closeButton);
+
+    QVBoxLayout* masterLayout = new QVBoxLayout();
+    masterLayout->addLayout(toleranceLayout);
+    masterLayout->addWidget(reindexTextures);
+    masterLayout->addWidget(compactSlots);
+    masterLayout->addWidget(resultLabel);
+    masterLayout->addWidget(resultList);
+    masterLayout->addLayout(buttonsLayout);
+    setLayout(masterLayout);
+
+    setMinimumWidth(400);
+    clearResults();
+
+    connect(toleranceSelect, SIGNAL(valueChanged(int)), this, SLOT(clearResults()));
+    connect(reindexTextures, SIGNAL(stateChanged(int)), this, SLOT(clearResults()));
+    connect(compactSlots, SIGNAL(stateChanged(int)), this, SLOT(clearResults()));
+    connect(analyzeButton, SIGNAL(clicked()), this, SLOT(analyze()));
+    connect(optimizeButton, SIGNAL(clicked()), this, SLOT(optimize()));
+    connect(closeButton, SIGNAL(clicked()), this, SLOT(accept()));
+};
+
+void OptimizePalettesDialog::setTextureData(DriverTextures* texs)
+{
+    textureBlock = texs;
+    clearResults();
+};
+
+void OptimizePalettesDialog::setD3D(DriverD3D* newD3D)
+{
+    d3d = newD3D;
+    clearResults();
+};
+
+void OptimizePalettesDialog::loadSettings()
+{
+    QSettings settings;
+    toleranceSelect->setValue(settings.value("OptimizePalettesDialog/tolerance",8).toInt());
+    reindexTextures->setCheckState((settings.value("OptimizePalettesDialog/reindexTextures",true).toBool() ? Qt::Checked : Qt::Unchecked));
+    compactSlots->setCheckState((settings.value("OptimizePalettesDialog/compactSlots",false).toBool() ? Qt::Checked : Qt::Unchecked));
+};
+
+void OptimizePalettesDialog::saveSettings()
+{
+    QSettings settings;
+    settings.setValue("OptimizePalettesDialog/tolerance",toleranceSelect->value());
+    settings.setValue("OptimizePalettesDialog/reindexTextures",(reindexTextures->checkState() == Qt::Checked ? true : false));
+    settings.setValue("OptimizePalettesDialog/compactSlots",(compactSlots->checkState() == Qt::Checked ? true : false));
+};
+
+void OptimizePalettesDialog::showEvent(QShowEvent* event)
+{
+    //The level may have changed since the last analysis.
+    clearResults();
+    QDialog::showEvent(event);
+};
+
+void OptimizePalettesDialog::clearResults()
+{
+    optimizer.clear();
+    resultList->clear();
+    resultLabel->setText(tr("Press Analyze to find palettes that can be merged."));
+    optimizeButton->setEnabled(false);
+    analyzeButton->setEnabled(textureBlock && d3d);
+};
+
+void OptimizePalettesDialog::analyze()
+{
+    resultList->clear();
+    optimizer.setTolerance(toleranceSelect->value());
+    optimizer.setReindexTextures(reindexTextures->checkState() == Qt::Checked);
+    optimizer.setCompactSlots(compactSlots->checkState() == Qt::Checked);
+    optimizer.analyze(textureBlock, d3d);
+
+    for(int i = 0; i < optimizer.getNumMerges(); i++)
+    {
+        const PaletteMerge* merge = optimizer.getMerge(i);
+        if(merge->reindex)
+        resultList->addItem(tr("Slot %1 into slot %2 (error %3, textures re-indexed)").arg(merge->slot).arg(merge->target).arg(merge->error));
+        else resultList->addItem(tr("Slot %1 into slot %2 (error %3)").arg(merge->slot).arg(merge->target).arg(merge->error));
+    }
+    resultLabel->setText(tr("%1 palettes can be merged, %2 slots will be moved.").arg(optimizer.getNumMerges()).arg(optimizer.getNumSlotMoves()));
+    optimizeButton->setEnabled(optimizer.getNumMerges() > 0 || optimizer.getNumSlotMoves() > 0);
+};
+
+void OptimizePalettesDialog::optimize()
+{
+    int numMerges = optimizer.getNumMerges();
+    int numMoves = optimizer.getNumSlotMoves();
+    optimizer.apply(textureBlock, d3d);
+
+    clearResults();
+    resultLabel->setText(tr("Merged %1 palettes and moved %2 slots.").arg(numMerges).arg(numMoves));
+    emit palettesOptimized();
+};
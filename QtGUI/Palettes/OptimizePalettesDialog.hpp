@@ -0,0 +1,49 @@
+#ifndef OPTIMIZE_PALETTES_DIALOG_HPP
+#define OPTIMIZE_PALETTES_DIALOG_HPP
+
+#include <QtWidgets>
+#include "../../Driver_Routines/driver_levels.hpp"
+#include "../../Driver_Routines/driver_d3d.hpp"
+#include "../../Driver_Routines/DriverLevels/paletteOptimizer.hpp"
+
+class OptimizePalettesDialog : public QDialog
+{
+    Q_OBJECT
+
+    public:
+        OptimizePalettesDialog(QWidget* parent = NULL);
+
+        void setTextureData(DriverTextures* texs);
+        void setD3D(DriverD3D* newD3D);
+
+    public slots:
+        void loadSettings();
+        void saveSettings();
+
+    signals:
+        void palettesOptimized();
+
+    protected slots:
+        void analyze();
+        void optimize();
+        void clearResults();
+
+    protected:
+        void showEvent(QShowEvent* event);
+
+        DriverTextures* textureBlock;
+        DriverD3D* d3d;
+        PaletteOptimizer optimizer;
+
+        QLabel* toleranceLabel;
+        QSpinBox* toleranceSelect;
+        QCheckBox* reindexTextures;
+        QCheckBox* compactSlots;
+        QLabel* resultLabel;
+        QListWidget* resultList;
+        QPushButton* analyzeButton;
+        QPushButton* optimizeButton;
+        QPushButton* closeButton;
+};
+
+#endif
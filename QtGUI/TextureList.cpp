@@ -1,11 +1,34 @@
 #include "TextureList.hpp"
 
+static void buildPaletteRow(unsigned char* row, const DriverPalette* palette)
+{
+    for(int i = 0; i < 256; i++)
+    {
+        if(palette)
+        {
+            row[i*4] = palette->colors[i].r;
+            row[i*4+1] = palette->colors[i].g;
+            row[i*4+2] = palette->colors[i].b;
+        }
+        else
+        {
+            row[i*4] = i;
+            row[i*4+1] = i;
+            row[i*4+2] = i;
+        }
+        row[i*4+3] = 255;
+    }
+};
+
 TexEntry::TexEntry()
 {
     memset(ids,0,sizeof(GLuint)*16);
     numPalettes = 0;
     currentPalette = 0;
     extendedIds = NULL;
+    indexId = 0;
+    paletteRows = NULL;
+    numPaletteRows = 0;
 };
 
 TexEntry::~TexEntry()
@@ -20,9 +43,16 @@ void TexEntry::cleanup()
         delete[] extendedIds;
         extendedIds = NULL;
     }
+    if(paletteRows)
+    {
+        delete[] paletteRows;
+        paletteRows = NULL;
+    }
     memset(ids,0,sizeof(GLuint)*16);
     numPalettes = 0;
     currentPalette = 0;
+    indexId = 0;
+    numPaletteRows = 0;
 };
 
 void TexEntry::set(GLuint texid)
@@ -52,6 +82,23 @@ void TexEntry::set(GLuint* texids,int num_ids)
     }
 };
 
+void TexEntry::setIndexed(GLuint texid,const int* rows,int num_rows)
+{
+    if(paletteRows)
+    {
+        delete[] paletteRows;
+        paletteRows = NULL;
+    }
+    indexId = texid;
+    numPaletteRows = 0;
+    if(rows != NULL && num_rows > 0)
+    {
+        numPaletteRows = num_rows;
+        paletteRows = new int[numPaletteRows];
+        memcpy(paletteRows,rows,sizeof(int)*numPaletteRows);
+    }
+};
+
 GLuint TexEntry::getTexture(int palette) const
 {
     if(numPalettes > 0)
@@ -65,6 +112,22 @@ GLuint TexEntry::getTexture(int palette) const
     return 0;
 };
 
+GLuint TexEntry::getIndexTexture() const
+{
+    return indexId;
+};
+
+int TexEntry::getPaletteRow(int palette) const
+{
+    if(numPaletteRows > 0)
+    {
+        if(palette < 0 || palette >= numPaletteRows)
+        palette = 0;
+        return paletteRows[palette];
+    }
+    return -1;
+};
+
 void TexEntry::setCurrentPalette(int palette)
 {
     if(palette >= 0 && palette < numPalettes)
@@ -86,6 +149,9 @@ int TexEntry::getNumPalettes() const
 TextureList::TextureList()
 {
     memset(list,0,sizeof(TexEntry*)*256);
+    indexedTextures = false;
+    paletteTexture = 0;
+    paletteTextureHeight = 0;
 };
 
 TextureList::~TextureList()
@@ -125,6 +191,18 @@ void TextureList::addTexture(int texnum,GLuint texid)
     }
 };
 
+void TextureList::addIndexTexture(int texnum,GLuint texid,const int* rows,int num_rows)
+{
+    if(texnum < 256 && texnum >= 0)
+    {
+        if(list[texnum] == NULL)
+        {
+            list[texnum] = new TexEntry();
+        }
+        list[texnum]->setIndexed(texid,rows,num_rows);
+    }
+};
+
 void TextureList::removeTexture(int texnum)
 {
     if(texnum < 256 && texnum >= 0)
@@ -188,6 +266,46 @@ int TextureList::getNumPalettes(int texnum) const
     return -1;
 };
 
+void TextureList::setIndexedTextures(bool use)
+{
+    indexedTextures = use;
+};
+
+bool TextureList::usesIndexedTextures() const
+{
+    return indexedTextures;
+};
+
+GLuint TextureList::getIndexTexture(int texnum) const
+{
+    if(texnum < 256 && texnum >= 0)
+    {
+        if(list[texnum] != NULL)
+        return list[texnum]->getIndexTexture();
+    }
+    return 0;
+};
+
+int TextureList::getPaletteRow(int texnum,int palette) const
+{
+    if(texnum < 256 && texnum >= 0)
+    {
+        if(list[texnum] != NULL)
+        return list[texnum]->getPaletteRow(palette);
+    }
+    return -1;
+};
+
+GLuint TextureList::getPaletteTexture() const
+{
+    return paletteTexture;
+};
+
+int TextureList::getPaletteTextureHeight() const
+{
+    return paletteTextureHeight;
+};
+
 LevelTextures::LevelTextures() : TextureList()
 {
     textures = NULL;
@@ -228,6 +346,7 @@ void LevelTextures::cleanup()
         unallocateTextures(i);
         removeTexture(i);
     }
+    unallocatePaletteTexture();
 };
 
 void LevelTextures::unallocateTextures(int tex)
@@ -237,8 +356,133 @@ void LevelTextures::unallocateTextures(int tex)
         for(int i = 0; i < getNumPalettes(tex); i++)
         {
             GLuint temp = getTexture(tex,i);
+            if(temp)
+                glDeleteTextures(1,&temp);
+        }
+        GLuint temp = getIndexTexture(tex);
+        if(temp)
             glDeleteTextures(1,&temp);
+    }
+};
+
+void LevelTextures::unallocatePaletteTexture()
+{
+    if(paletteTexture)
+    {
+        glDeleteTextures(1,&paletteTexture);
+        paletteTexture = 0;
+    }
+    paletteTextureHeight = 0;
+};
+
+void LevelTextures::setIndexedTextures(bool use)
+{
+    if(use != indexedTextures)
+    {
+        indexedTextures = use;
+        unallocatePaletteTexture();
+        rebuildAllTextures();
+    }
+};
+
+DriverPalette* LevelTextures::getTexturePalette(int texture,int palette)
+{
+    if(d3d)
+    {
+        D3DEntry* entry = d3d->getTextureEntry(texture);
+        if(entry)
+        return textures->getIndexedPalette(entry->getPaletteIndex(palette));
+        return NULL;
+    }
+    if(textures->getNumPalettes() > 0)
+    return textures->getPalette(0);
+    return NULL;
+};
+
+GLuint LevelTextures::buildPaletteTexture(int texture,int paletteIdx,unsigned char* data)
+{
+    DriverPalette* palette = getTexturePalette(texture,paletteIdx);
+    DriverPalette temppal;
+    if(!palette)
+    {
+        for(int i = 0; i < 256; i++)
+        {
+            temppal.colors[i].r = i;
+            temppal.colors[i].g = i;
+            temppal.colors[i].b = i;
+            temppal.colors[i].a = 255;
         }
+        palette = &temppal;
+    }
+
+    const DriverTexture* tex = textures->getTexture(texture);
+    for(int k = 0; k < 0x10000; k++)
+    {
+        unsigned int index = (int)*(unsigned char*)(tex->getData()+k);
+        *(unsigned int*)(data+4*k) = palette->colors[index].r+(palette->colors[index].g<<8)+(palette->colors[index].b<<16);
+        //if(tex->hasTransparency())
+        //*(unsigned int*)(data+4*k)+=(palette->colors[index].a<<24);
+        *(unsigned int*)(data+4*k)+=(0xFF<<24);
+    }
+
+    GLuint texid;
+    glGenTextures(1, &texid);
+    glBindTexture(GL_TEXTURE_2D, texid);
+    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,256,256,0,GL_RGBA,GL_UNSIGNED_BYTE,data);
+    glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,GL_REPEAT);
+    glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    return texid;
+};
+
+void LevelTextures::rebuildPaletteTexture()
+{
+    unallocatePaletteTexture();
+    if(textures && indexedTextures)
+    {
+        int highestSlot = -1;
+        for(int i = 0; i < textures->getNumPalettes(); i++)
+        {
+            if(textures->getPalette(i)->paletteNumber > highestSlot)
+            highestSlot = textures->getPalette(i)->paletteNumber;
+        }
+
+        //One row per palette slot, the last row is a greyscale palette for textures without one.
+        paletteTextureHeight = highestSlot+2;
+        unsigned char* data = new unsigned char[256*4*paletteTextureHeight];
+        for(int i = 0; i < paletteTextureHeight; i++)
+        {
+            buildPaletteRow(data+i*256*4, (i <= highestSlot ? textures->getIndexedPalette(i) : NULL));
+        }
+
+        glGenTextures(1, &paletteTexture);
+        glBindTexture(GL_TEXTURE_2D, paletteTexture);
+        glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,256,paletteTextureHeight,0,GL_RGBA,GL_UNSIGNED_BYTE,data);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+        delete[] data;
+    }
+    emit listAltered();
+};
+
+void LevelTextures::updatePaletteRow(int slot)
+{
+    if(!textures || !indexedTextures || slot < 0)
+        return;
+
+    if(!paletteTexture || slot >= paletteTextureHeight-1)
+    {
+        rebuildPaletteTexture();
+    }
+    else
+    {
+        unsigned char row[256*4];
+        buildPaletteRow(row, textures->getIndexedPalette(slot));
+        glBindTexture(GL_TEXTURE_2D, paletteTexture);
+        glTexSubImage2D(GL_TEXTURE_2D,0,0,slot,256,1,GL_RGBA,GL_UNSIGNED_BYTE,row);
     }
 };
 
@@ -249,6 +493,9 @@ void LevelTextures::rebuildAllTextures()
         bool origState = signalsBlocked();
         blockSignals(true);
 
+        if(indexedTextures)
+        rebuildPaletteTexture();
+
         unsigned char* buffer = new unsigned char[256*256*4];
         for(int i = 0; i < textures->getNumTextures(); i++)
         {
@@ -279,15 +526,6 @@ void LevelTextures::rebuildTexture(int texture,unsigned char* buffer)
             if(textures->getTexture(texture)->usesPalette())
             {
                 int numPalettes = 1;
-                DriverPalette* palette;
-                DriverPalette temppal;
-                for(int i = 0; i < 256; i++)
-                {
-                    temppal.colors[i].r = i;
-                    temppal.colors[i].g = i;
-                    temppal.colors[i].b = i;
-                    temppal.colors[i].a = 255;
-                }
                 if(d3d)
                 {
                     D3DEntry* entry = d3d->getTextureEntry(texture);
@@ -299,51 +537,37 @@ void LevelTextures::rebuildTexture(int texture,unsigned char* buffer)
                     numPalettes = 1;
                 }
 
+                //The 2D views still sample the RGBA textures, so they are built even when the model view uses the index texture.
                 GLuint* texlist = new GLuint[numPalettes];
-                glGenTextures(numPalettes, texlist);
-
+                int* rows = new int[numPalettes];
                 for(int i = 0; i < numPalettes; i++)
                 {
-                    if(d3d)
-                    {
-                        D3DEntry* entry = d3d->getTextureEntry(texture);
-                        if(entry)
-                        palette = textures->getIndexedPalette(entry->getPaletteIndex(i));
-                        else palette = NULL;
-
-                        if(!palette)
-                        {
-                            palette = &temppal;
-                        }
-                    }
-                    else
-                    {
-                        if(textures->getNumPalettes() > 0)
-                        {
-                            palette = textures->getPalette(0);
-                        }
-                        else palette = &temppal;
-                    }
+                    DriverPalette* palette = getTexturePalette(texture,i);
+                    rows[i] = (palette ? palette->paletteNumber : -1);
+                    texlist[i] = buildPaletteTexture(texture,i,data);
+                }
+                addTexture(texture,texlist,numPalettes);
+                delete[] texlist;
 
-                    const DriverTexture* tex = textures->getTexture(texture);
-                    for(int k = 0; k < 0x10000; k++)
+                if(indexedTextures)
+                {
+                    for(int i = 0; i < numPalettes; i++)
                     {
-                        unsigned int index = (int)*(unsigned char*)(tex->getData()+k);
-                        *(unsigned int*)(data+4*k) = palette->colors[index].r+(palette->colors[index].g<<8)+(palette->colors[index].b<<16);
-                        //if(tex->hasTransparency())
-                        //*(unsigned int*)(data+4*k)+=(palette->colors[index].a<<24);
-                        *(unsigned int*)(data+4*k)+=(0xFF<<24);
+                        updatePaletteRow(rows[i]);
                     }
 
-                    glBindTexture(GL_TEXTURE_2D, texlist[i]);
-                    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,256,256,0,GL_RGBA,GL_UNSIGNED_BYTE,data);
-                    glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,GL_REPEAT);
-                    glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,GL_REPEAT);
-                    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+                    GLuint indexTexture;
+                    glGenTextures(1, &indexTexture);
+                    glBindTexture(GL_TEXTURE_2D, indexTexture);
+                    glTexImage2D(GL_TEXTURE_2D,0,GL_R8,256,256,0,GL_RED,GL_UNSIGNED_BYTE,textures->getTexture(texture)->getData());
+                    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
+                    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
+                    //Indices cannot be interpolated, the shader filters the looked up colours itself.
+                    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+                    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+                    addIndexTexture(texture,indexTexture,rows,numPalettes);
                 }
-                addTexture(texture,texlist,numPalettes);
-                delete[] texlist;
+                delete[] rows;
             }
             else
             {
@@ -439,6 +663,24 @@ void LevelTextures::texturesDestroyed()
     emit listAltered();
 };
 
+void LevelTextures::paletteInserted(int /*idx*/)
+{
+    if(indexedTextures)
+        rebuildPaletteTexture();
+};
+
+void LevelTextures::paletteRemoved(int /*idx*/)
+{
+    if(indexedTextures)
+        rebuildPaletteTexture();
+};
+
+void LevelTextures::paletteChanged(int idx)
+{
+    if(textures && idx >= 0 && idx < textures->getNumPalettes())
+        updatePaletteRow(textures->getPalette(idx)->paletteNumber);
+};
+
 void LevelTextures::textureRemoved(int idx)
 {
     unallocateTextures(idx);
@@ -488,3 +730,19 @@ void LevelTextures::textureChanged(int idx)
 {
     rebuildTexture(idx);
 };
+
+void LevelTextures::textureBatchChanged(const int* indices, int count)
+{
+    bool origState = signalsBlocked();
+    blockSignals(true);
+
+    unsigned char* buffer = new unsigned char[256*256*4];
+    for(int i = 0; i < count; i++)
+    {
+        rebuildTexture(indices[i],buffer);
+    }
+    delete[] buffer;
+
+    blockSignals(origState);
+    emit listAltered();
+};
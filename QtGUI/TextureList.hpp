@@ -15,7 +15,10 @@ class TexEntry
         ~TexEntry();
         void set(GLuint texid);
         void set(GLuint* texids,int num_ids);
+        void setIndexed(GLuint texid,const int* rows,int num_rows);
         GLuint getTexture(int palette = -1) const;
+        GLuint getIndexTexture() const;
+        int getPaletteRow(int palette = -1) const;
         void setCurrentPalette(int palette);
         int getCurrentPalette() const;
         int getNumPalettes() const;
@@ -26,6 +29,11 @@ class TexEntry
         int currentPalette;
         GLuint ids[16];
         GLuint* extendedIds;
+
+        //Single channel index texture and palette texture rows, only set when using indexed textures.
+        GLuint indexId;
+        int* paletteRows;
+        int numPaletteRows;
 };
 
 class TextureList : public QObject
@@ -38,6 +46,7 @@ class TextureList : public QObject
         void clearList();
         void addTexture(int texnum,GLuint* texids,int num_palettes);
         void addTexture(int texnum,GLuint texid);
+        void addIndexTexture(int texnum,GLuint texid,const int* rows,int num_rows);
         void removeTexture(int texnum);
         bool textureIsSet(int texnum) const;
         GLuint getTexture(int texnum,int palette = -1) const;
@@ -45,11 +54,22 @@ class TextureList : public QObject
         int getCurrentPalette(int texnum) const;
         int getNumPalettes(int texnum) const;
 
+        virtual void setIndexedTextures(bool use);
+        bool usesIndexedTextures() const;
+        GLuint getIndexTexture(int texnum) const;
+        int getPaletteRow(int texnum,int palette = -1) const;
+        GLuint getPaletteTexture() const;
+        int getPaletteTextureHeight() const;
+
     signals:
         void listAltered();
 
     protected:
         TexEntry* list[256];
+
+        bool indexedTextures;
+        GLuint paletteTexture;
+        int paletteTextureHeight;
 };
 
 class LevelTextures : public TextureList, IDriverD3DEvents, IDriverTextureEvents
@@ -64,14 +84,20 @@ class LevelTextures : public TextureList, IDriverD3DEvents, IDriverTextureEvents
         void setD3D(DriverD3D* d);
         void rebuildTexture(int texture,unsigned char* buffer = NULL);
         void rebuildAllTextures();
+        void rebuildPaletteTexture();
         void unallocateTextures(int texture);
+        void setIndexedTextures(bool use);
 
         //Event handlers
         void textureRemoved(int idx);
         void textureChanged(int idx);
+        void textureBatchChanged(const int* indices, int count);
         void textureInserted(int idx);
         void textureMoved(int from, int to);
         void texturesDestroyed();
+        void paletteInserted(int idx);
+        void paletteRemoved(int idx);
+        void paletteChanged(int idx);
         void D3DReset(bool aboutToBe);
         void D3DOpened();
         void D3DDestroyed();
@@ -83,6 +109,11 @@ class LevelTextures : public TextureList, IDriverD3DEvents, IDriverTextureEvents
         void entryIndexRemoved(int entryIdx, int idx);
 
     protected:
+        void updatePaletteRow(int slot);
+        DriverPalette* getTexturePalette(int texture,int palette);
+        GLuint buildPaletteTexture(int texture,int palette,unsigned char* buffer);
+        void unallocatePaletteTexture();
+
         DriverTextures* textures;
         DriverD3D* d3d;
 };
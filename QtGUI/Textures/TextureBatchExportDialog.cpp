@@ -0,0 +1,372 @@
+#include "TextureBatchExportDialog.hpp"
+
+TextureExportTask::TextureExportTask(QObject* resultReceiver, const DriverTexture& tex, const DriverPalette* pal, int outputFormat, bool useMagicPink, const QString& outputFile, int exportRun, std::atomic<bool>* cancelFlag)
+    : texture(tex)
+{
+    receiver = resultReceiver;
+    hasPalette = (pal != NULL);
+    if(pal)
+    palette = *pal;
+    format = outputFormat;
+    magicPink = useMagicPink;
+    filename = outputFile;
+    run = exportRun;
+    cancelled = cancelFlag;
+};
+
+FIBITMAP* TextureExportTask::createBitmap(const DriverTexture* tex, const DriverPalette* pal)
+{
+    FIBITMAP* bitmap = NULL;
+    if(tex->usesPalette())
+    {
+        bitmap = FreeImage_Allocate(256,256,8);
+        if(!bitmap)
+        return NULL;
+
+        for(int i = 0; i < 256; i++)
+        {
+            memcpy(FreeImage_GetScanLine(bitmap,255-i),tex->getScanLine(i),256);
+        }
+
+        RGBQUAD* fiPal = FreeImage_GetPalette(bitmap);
+        for(int i = 0; i < 256; i++)
+        {
+            fiPal[i].rgbRed = (pal ? pal->colors[i].r : i);
+            fiPal[i].rgbGreen = (pal ? pal->colors[i].g : i);
+            fiPal[i].rgbBlue = (pal ? pal->colors[i].b : i);
+        }
+    }
+    else
+    {
+        bitmap = FreeImage_Allocate(256,256,16,0x7C00,0x03E0,0x001F);
+        if(!bitmap)
+        return NULL;
+
+        for(int i = 0; i < 256; i++)
+        {
+            memcpy(FreeImage_GetScanLine(bitmap,255-i),tex->getScanLine(i),256*2);
+        }
+    }
+    return bitmap;
+};
+
+void TextureExportTask::run()
+{
+    bool success = false;
+
+    if(!cancelled->load())
+    {
+        FIBITMAP* bitmap = createBitmap(&texture, (hasPalette ? &palette : NULL));
+        if(bitmap)
+        {
+            //Paletted textures keep their palette unless the format cannot store one.
+            if(!texture.usesPalette() || format == BATCH_FORMAT_JPEG)
+            {
+                FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(bitmap);
+                FreeImage_Unload(bitmap);
+                bitmap = temp24;
+            }
+
+            if(magicPink && texture.hasTransparency())
+            TextureExportDialog::applyMagicPink(bitmap);
+        }
+
+        if(bitmap)
+        {
+            QByteArray file = filename.toLocal8Bit();
+            switch(format)
+            {
+                case BATCH_FORMAT_BMP:
+                    success = FreeImage_Save(FIF_BMP, bitmap, file.data(), 0);
+                    break;
+                case BATCH_FORMAT_PNG:
+                    success = FreeImage_Save(FIF_PNG, bitmap, file.data(), PNG_DEFAULT);
+                    break;
+                case BATCH_FORMAT_TGA:
+                    success = FreeImage_Save(FIF_TARGA, bitmap, file.data(), 0);
+                    break;
+                case BATCH_FORMAT_TIFF:
+                    success = FreeImage_Save(FIF_TIFF, bitmap, file.data(), TIFF_LZW);
+                    break;
+                case BATCH_FORMAT_JPEG:
+                    success = FreeImage_Save(FIF_JPEG, bitmap, file.data(), JPEG_QUALITYSUPERB | JPEG_OPTIMIZE);
+                    break;
+            }
+            FreeImage_Unload(bitmap);
+        }
+    }
+
+    QMetaObject::invokeMethod(receiver, "exportFinished", Qt::QueuedConnection, Q_ARG(int, run), Q_ARG(QString, filename), Q_ARG(bool, success));
+};
+
+TextureBatchExportDialog::TextureBatchExportDialog(QWidget* parent) : QDialog(parent)
+{
+    level = NULL;
+    d3d = NULL;
+    cancelled = false;
+    exportRun = 0;
+    numQueued = 0;
+    numFinished = 0;
+
+    setWindowTitle(tr("Export All Textures"));
+
+    directoryLabel = new QLabel(tr("Output directory:"),this);
+    directoryEdit = new QLineEdit(this);
+    browseButton = new QPushButton(tr("Browse..."),this);
+
+    formatLabel = new QLabel(tr("Format:"),this);
+    formatSelect = new QComboBox(this);
+    formatSelect->addItem(tr("Bitmap (*.bmp)"));
+    formatSelect->addItem(tr("Portable Network Graphics (*.png)"));
+    formatSelect->addItem(tr("TARGA (*.tga)"));
+    formatSelect->addItem(tr("TIFF (*.tiff)"));
+    formatSelect->addItem(tr("JPEG (*.jpeg)"));
+
+    filterLabel = new QLabel(tr("Textures:"),this);
+    filterSelect = new QComboBox(this);
+    filterSelect->addItem(tr("All Textures"));
+    filterSelect->addItem(tr("Car Textures"));
+    filterSelect->addItem(tr("Paletted"));
+    filterSelect->addItem(tr("15-Bit"));
+    filterSelect->addItem(tr("Has Transparency"));
+
+    namingLabel = new QLabel(tr("File names (%t texture, %p palette, %s palette slot, %c car):"),this);
+    namingEdit = new QLineEdit(this);
+
+    allPalettes = new QCheckBox(tr("Export every palette of paletted textures"),this);
+    magicPink = new QCheckBox(tr("Use magic pink for transparency"),this);
+
+    progress = new QProgressBar(this);
+    progress->setMinimum(0);
+    progress->setMaximum(1);
+    progress->setValue(0);
+
+    exportButton = new QPushButton(tr("Export"),this);
+    exportButton->setMaximumWidth(100);
+    closeButton = new QPushButton(tr("Close"),this);
+    closeButton->setMaximumWidth(100);
+
+    QHBoxLayout* directoryLayout = new QHBoxLayout();
+    directoryLayout->addWidget(directoryEdit);
+    directoryLayout->addWidget(browseButton);
+
+    QHBoxLayout* buttonsLayout = new QHBoxLayout();
+    buttonsLayout->addWidget(exportButton);
+    buttonsLayout->addWidget(closeButton);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout();
+    mainLayout->addWidget(directoryLabel);
+    mainLayout->addLayout(directoryLayout);
+    mainLayout->addWidget(formatLabel);
+    mainLayout->addWidget(formatSelect);
+    mainLayout->addWidget(filterLabel);
+    mainLayout->addWidget(filterSelect);
+    mainLayout->addWidget(namingLabel);
+    mainLayout->addWidget(namingEdit);
+    mainLayout->addWidget(allPalettes);
+    mainLayout->addWidget(magicPink);
+    mainLayout->addWidget(progress);
+    mainLayout->addLayout(buttonsLayout);
+    setLayout(mainLayout);
+    hide();
+
+    connect(browseButton, SIGNAL(clicked()), this, SLOT(browseDirectory()));
+    connect(exportButton, SIGNAL(clicked()), this, SLOT(startExport()));
+    connect(closeButton, SIGNAL(clicked()), this, SLOT(reject()));
+};
+
+TextureBatchExportDialog::~TextureBatchExportDialog()
+{
+    cancelled = true;
+    pool.waitForDone();
+};
+
+void TextureBatchExportDialog::setLevel(DriverLevel* lev)
+{
+    level = lev;
+};
+
+void TextureBatchExportDialog::setD3D(DriverD3D* newD3D)
+{
+    d3d = newD3D;
+};
+
+void TextureBatchExportDialog::setFilter(int filter)
+{
+    filterSelect->setCurrentIndex(filter);
+};
+
+void TextureBatchExportDialog::loadSettings()
+{
+    QSettings settings;
+    directoryEdit->setText(settings.value("TextureBatchExportDialog/directory", settings.value("directories/lastImageExportDir").toString()).toString());
+    formatSelect->setCurrentIndex(settings.value("TextureBatchExportDialog/format",BATCH_FORMAT_PNG).toInt());
+    namingEdit->setText(settings.value("TextureBatchExportDialog/naming","texture_%t_%p").toString());
+    allPalettes->setCheckState((settings.value("TextureBatchExportDialog/allPalettes",true).toBool() ? Qt::Checked : Qt::Unchecked));
+    magicPink->setCheckState((settings.value("TextureBatchExportDialog/magicPink",false).toBool() ? Qt::Checked : Qt::Unchecked));
+};
+
+void TextureBatchExportDialog::saveSettings()
+{
+    QSettings settings;
+    settings.setValue("TextureBatchExportDialog/directory",directoryEdit->text());
+    settings.setValue("TextureBatchExportDialog/format",formatSelect->currentIndex());
+    settings.setValue("TextureBatchExportDialog/naming",namingEdit->text());
+    settings.setValue("TextureBatchExportDialog/allPalettes",(allPalettes->checkState() == Qt::Checked ? true : false));
+    settings.setValue("TextureBatchExportDialog/magicPink",(magicPink->checkState() == Qt::Checked ? true : false));
+};
+
+void TextureBatchExportDialog::reject()
+{
+    //Tasks already running finish their file in the background, queued ones are skipped.
+    cancelled = true;
+    pool.clear();
+    setRunning(false);
+    QDialog::reject();
+};
+
+void TextureBatchExportDialog::browseDirectory()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, tr("Export textures to..."), directoryEdit->text());
+    if(!dir.isEmpty())
+    directoryEdit->setText(dir);
+};
+
+QString TextureBatchExportDialog::buildFilename(int texture, int palette, int slot, short carnum)
+{
+    const char* extensions[5] = {".bmp", ".png", ".tga", ".tiff", ".jpeg"};
+
+    QString name = namingEdit->text();
+    if(name.isEmpty())
+    name = "texture_%t_%p";
+
+    name.replace("%t", QString("%1").arg(texture, 3, 10, QChar('0')));
+    name.replace("%p", QString::number(palette));
+    name.replace("%s", QString::number(slot));
+    name.replace("%c", QString::number(carnum));
+    return QDir(directoryEdit->text()).absoluteFilePath(name + extensions[formatSelect->currentIndex()]);
+};
+
+void TextureBatchExportDialog::setRunning(bool running)
+{
+    exportButton->setEnabled(!running);
+    formatSelect->setEnabled(!running);
+    filterSelect->setEnabled(!running);
+    namingEdit->setEnabled(!running);
+    directoryEdit->setEnabled(!running);
+    browseButton->setEnabled(!running);
+    allPalettes->setEnabled(!running);
+    magicPink->setEnabled(!running);
+};
+
+void TextureBatchExportDialog::startExport()
+{
+    if(!level)
+        return;
+
+    QDir dir(directoryEdit->text());
+    if(directoryEdit->text().isEmpty() || !dir.mkpath("."))
+    {
+        QMessageBox msgBox(this);
+        msgBox.setText(tr("Please select a valid output directory."));
+        msgBox.setIcon(QMessageBox::Warning);
+        msgBox.exec();
+        return;
+    }
+
+    //Without these every texture, or every palette of one, would be written to the same file.
+    QString naming = namingEdit->text();
+    if(!naming.isEmpty() && (!naming.contains("%t") || (allPalettes->checkState() == Qt::Checked && !naming.contains("%p"))))
+    {
+        QMessageBox msgBox(this);
+        if(allPalettes->checkState() == Qt::Checked)
+        msgBox.setText(tr("File names must contain %t and %p when exporting every palette."));
+        else msgBox.setText(tr("File names must contain %t."));
+        msgBox.setIcon(QMessageBox::Warning);
+        msgBox.exec();
+        return;
+    }
+
+    cancelled = false;
+    exportRun++;
+    numQueued = 0;
+    numFinished = 0;
+    failedFiles.clear();
+
+    int filter = filterSelect->currentIndex();
+    int format = formatSelect->currentIndex();
+    bool usePink = (magicPink->checkState() == Qt::Checked);
+
+    //Jobs are built on the GUI thread so workers never touch the level or D3D.
+    for(int i = 0; i < level->textures.getNumTextures(); i++)
+    {
+        const DriverTexture* tex = level->textures.getTexture(i);
+        if(!textureMatchesFilter(tex, filter))
+            continue;
+
+        if(tex->usesPalette())
+        {
+            D3DEntry* entry = NULL;
+            if(d3d)
+            entry = d3d->getTextureEntry(i);
+
+            int numPalettes = (entry ? entry->getNumPaletteIndicies() : 0);
+            if(numPalettes > 1 && allPalettes->checkState() != Qt::Checked)
+            numPalettes = 1;
+
+            if(numPalettes <= 0)
+            {
+                pool.start(new TextureExportTask(this, *tex, (level->textures.getNumPalettes() > 0 ? level->textures.getPalette(0) : NULL), format, usePink, buildFilename(i, 0, -1, tex->getCarNumber()), exportRun, &cancelled));
+                numQueued++;
+            }
+            for(int j = 0; j < numPalettes; j++)
+            {
+                int slot = entry->getPaletteIndex(j);
+                pool.start(new TextureExportTask(this, *tex, level->textures.getIndexedPalette(slot), format, usePink, buildFilename(i, j, slot, tex->getCarNumber()), exportRun, &cancelled));
+                numQueued++;
+            }
+        }
+        else
+        {
+            pool.start(new TextureExportTask(this, *tex, NULL, format, usePink, buildFilename(i, 0, -1, tex->getCarNumber()), exportRun, &cancelled));
+            numQueued++;
+        }
+    }
+
+    progress->setMaximum(numQueued > 0 ? numQueued : 1);
+    progress->setValue(0);
+    if(numQueued > 0)
+    setRunning(true);
+};
+
+void TextureBatchExportDialog::exportFinished(int run, QString file, bool success)
+{
+    if(cancelled || run != exportRun)
+        return;
+
+    numFinished++;
+    if(!success)
+    failedFiles.append(file);
+    progress->setValue(numFinished);
+
+    if(numFinished == numQueued)
+    {
+        setRunning(false);
+        {
+            QMessageBox msgBox(this);
+            if(failedFiles.isEmpty())
+            {
+                msgBox.setText(tr("Finished exporting textures."));
+                msgBox.setInformativeText(tr("Exported %1 images.").arg(numFinished));
+                msgBox.setIcon(QMessageBox::Information);
+            }
+            else
+            {
+                msgBox.setText(tr("Failed to export %1 of %2 images!").arg(failedFiles.size()).arg(numFinished));
+                msgBox.setDetailedText(failedFiles.join("\n"));
+                msgBox.setIcon(QMessageBox::Warning);
+            }
+            msgBox.exec();
+        }
+    }
+};
@@ -0,0 +1,92 @@
+#ifndef TEXTURE_BATCH_EXPORT_DIALOG_HPP
+#define TEXTURE_BATCH_EXPORT_DIALOG_HPP
+
+#include <QtWidgets>
+#include <atomic>
+#include <FreeImage.h>
+#include "../../Driver_Routines/driver_levels.hpp"
+#include "../../Driver_Routines/driver_d3d.hpp"
+#include "TextureExportDialog.hpp"
+#include "TextureFilters.hpp"
+
+const int BATCH_FORMAT_BMP = 0;
+const int BATCH_FORMAT_PNG = 1;
+const int BATCH_FORMAT_TGA = 2;
+const int BATCH_FORMAT_TIFF = 3;
+const int BATCH_FORMAT_JPEG = 4;
+
+//Converts and saves a single texture/palette pair, run on a worker thread.
+//The texture copy shares pixel data with the level, so queuing a task is cheap.
+class TextureExportTask : public QRunnable
+{
+    public:
+        TextureExportTask(QObject* resultReceiver, const DriverTexture& tex, const DriverPalette* pal, int outputFormat, bool useMagicPink, const QString& outputFile, int exportRun, std::atomic<bool>* cancelFlag);
+        void run();
+
+        static FIBITMAP* createBitmap(const DriverTexture* tex, const DriverPalette* pal);
+
+    protected:
+        QObject* receiver;
+        DriverTexture texture;
+        DriverPalette palette;
+        bool hasPalette;
+        int format;
+        bool magicPink;
+        QString filename;
+        int run;
+        std::atomic<bool>* cancelled;
+};
+
+class TextureBatchExportDialog : public QDialog
+{
+    Q_OBJECT
+
+    public:
+        TextureBatchExportDialog(QWidget* parent = NULL);
+        ~TextureBatchExportDialog();
+
+        void setLevel(DriverLevel* lev);
+        void setD3D(DriverD3D* newD3D);
+        void setFilter(int filter);
+
+    public slots:
+        void loadSettings();
+        void saveSettings();
+        void reject();
+
+    protected slots:
+        void browseDirectory();
+        void startExport();
+        void exportFinished(int run, QString file, bool success);
+
+    protected:
+        QString buildFilename(int texture, int palette, int slot, short carnum);
+        void setRunning(bool running);
+
+        DriverLevel* level;
+        DriverD3D* d3d;
+
+        QThreadPool pool;
+        std::atomic<bool> cancelled;
+        int exportRun; //Results from tasks of an earlier, cancelled export are ignored.
+        int numQueued;
+        int numFinished;
+        QStringList failedFiles;
+
+        QLabel* directoryLabel;
+        QLineEdit* directoryEdit;
+        QPushButton* browseButton;
+        QLabel* formatLabel;
+        QComboBox* formatSelect;
+        QLabel* filterLabel;
+        QComboBox* filterSelect;
+        QLabel* namingLabel;
+        QLineEdit* namingEdit;
+        QCheckBox* allPalettes;
+        QCheckBox* magicPink;
+        QProgressBar* progress;
+        QPushButton* exportButton;
+        QPushButton* closeButton;
+};
+
+#endif
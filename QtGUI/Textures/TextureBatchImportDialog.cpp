@@ -0,0 +1,589 @@
+#include "TextureBatchImportDialog.hpp"
+
+TextureImportTask::TextureImportTask(QObject* resultReceiver, TextureImportJob* importJob, int jobIndex, int transparencyMode, std::atomic<bool>* cancelFlag)
+{
+    receiver = resultReceiver;
+    job = importJob;
+    index = jobIndex;
+    transparency = transparencyMode;
+    cancelled = cancelFlag;
+};
+
+void TextureImportTask::run()
+{
+    if(!cancelled->load())
+    {
+        FIBITMAP* bitmap = TextureImportDialog::loadImage(job->filename);
+        if(!bitmap)
+        {
+            job->error = QCoreApplication::translate("TextureBatchImportDialog", "Failed to load image.");
+        }
+        else if(FreeImage_GetWidth(bitmap) != 256 || FreeImage_GetHeight(bitmap) != 256)
+        {
+            job->error = QCoreApplication::translate("TextureBatchImportDialog", "Images must be exactly 256x256 pixels.");
+        }
+        else if(job->usesPalette && (job->sharedPalette || job->variantOf != -1))
+        {
+            job->sharedSource = FreeImage_ConvertTo24Bits(bitmap);
+            job->success = (job->sharedSource != NULL);
+        }
+        else if(job->usesPalette)
+        {
+            FIBITMAP* temp8 = quantizeImage(bitmap, &job->palette);
+            if(temp8)
+            {
+                job->pixels = new unsigned char[256*256];
+                TextureImportDialog::copyIndices(temp8, job->pixels);
+                FreeImage_Unload(temp8);
+                job->success = true;
+            }
+        }
+        else
+        {
+            //Without an alpha channel every pixel reads as opaque.
+            if(job->hasTransparency && transparency == IMPORT_TRANSPARENCY_ALPHA && FreeImage_GetBPP(bitmap) != 32)
+            job->warning = QCoreApplication::translate("TextureBatchImportDialog", "Image has no alpha channel, so no pixels were made transparent.");
+
+            job->pixels = new unsigned char[256*256*2];
+            job->success = TextureImportDialog::convertTo15Bit(bitmap, job->hasTransparency, transparency, job->pixels);
+        }
+
+        if(!job->success && job->error.isEmpty())
+        job->error = QCoreApplication::translate("TextureBatchImportDialog", "Failed to convert image.");
+
+        if(bitmap)
+        FreeImage_Unload(bitmap);
+    }
+
+    QMetaObject::invokeMethod(receiver, "importDecoded", Qt::QueuedConnection, Q_ARG(int, index));
+};
+
+SharedPaletteTask::SharedPaletteTask(QObject* resultReceiver, const QVector<TextureImportJob*>& importJobs, std::atomic<bool>* cancelFlag)
+{
+    receiver = resultReceiver;
+    jobs = importJobs;
+    cancelled = cancelFlag;
+};
+
+void SharedPaletteTask::run()
+{
+    bool success = false;
+    int count = jobs.size();
+
+    if(!cancelled->load() && count > 0)
+    {
+        ColorQuantizer quantizer;
+        for(int i = 0; i < count; i++)
+        {
+            for(int y = 0; y < 256; y++)
+            {
+                quantizer.addPixels(FreeImage_GetScanLine(jobs[i]->sharedSource, y), 3, FI_RGBA_RED, FI_RGBA_GREEN, FI_RGBA_BLUE, 256);
+            }
+        }
+
+        DriverPalette palette;
+        quantizer.quantize(&palette);
+
+        PaletteRemapper remapper(&palette);
+        for(int i = 0; i < count && !cancelled->load(); i++)
+        {
+            jobs[i]->palette = palette;
+            jobs[i]->pixels = new unsigned char[256*256];
+            for(int y = 0; y < 256; y++)
+            {
+                remapper.remapScanLine(FreeImage_GetScanLine(jobs[i]->sharedSource, 255-y), 3, FI_RGBA_RED, FI_RGBA_GREEN, FI_RGBA_BLUE, 256, y, jobs[i]->pixels+y*256);
+            }
+        }
+        success = !cancelled->load();
+    }
+
+    QMetaObject::invokeMethod(receiver, "sharedPaletteFinished", Qt::QueuedConnection, Q_ARG(bool, success));
+};
+
+TextureBatchImportDialog::TextureBatchImportDialog(QWidget* parent) : QDialog(parent)
+{
+    textureBlock = NULL;
+    d3d = NULL;
+    firstTexture = 0;
+    cancelled = false;
+    numQueued = 0;
+    numFinished = 0;
+
+    setWindowTitle(tr("Import Textures"));
+
+    fileList = new QListWidget(this);
+    addButton = new QPushButton(tr("Add Files..."),this);
+    clearButton = new QPushButton(tr("Clear"),this);
+
+    mappingLabel = new QLabel(tr("Target textures:"),this);
+    mappingSelect = new QComboBox(this);
+    mappingSelect->addItem(tr("Texture number from file name"));
+    mappingSelect->addItem(tr("In order from selected texture"));
+
+    namingLabel = new QLabel(tr("File names (%t texture, %p palette, %s palette slot, %c car):"),this);
+    namingEdit = new QLineEdit(this);
+
+    transparencyLabel = new QLabel(tr("For transparency:"),this);
+    transparencySelect = new QComboBox(this);
+    transparencySelect->addItem(tr("Use default color"));
+    transparencySelect->addItem(tr("Use magic pink"));
+    transparencySelect->addItem(tr("Use alpha channel"));
+
+    sharedPalette = new QCheckBox(tr("Quantize paletted images to one shared palette"),this);
+    sharedPalette->setEnabled(false);
+
+    progress = new QProgressBar(this);
+    progress->setMinimum(0);
+    progress->setMaximum(1);
+    progress->setValue(0);
+
+    importButton = new QPushButton(tr("Import"),this);
+    importButton->setMaximumWidth(100);
+    closeButton = new QPushButton(tr("Close"),this);
+    closeButton->setMaximumWidth(100);
+
+    QHBoxLayout* fileButtonsLayout = new QHBoxLayout();
+    fileButtonsLayout->addWidget(addButton);
+    fileButtonsLayout->addWidget(clearButton);
+
+    QHBoxLayout* buttonsLayout = new QHBoxLayout();
+    buttonsLayout->addWidget(importButton);
+    buttonsLayout->addWidget(closeButton);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout();
+    mainLayout->addWidget(fileList);
+    mainLayout->addLayout(fileButtonsLayout);
+    mainLayout->addWidget(mappingLabel);
+    mainLayout->addWidget(mappingSelect);
+    mainLayout->addWidget(namingLabel);
+    mainLayout->addWidget(namingEdit);
+    mainLayout->addWidget(transparencyLabel);
+    mainLayout->addWidget(transparencySelect);
+    mainLayout->addWidget(sharedPalette);
+    mainLayout->addWidget(progress);
+    mainLayout->addLayout(buttonsLayout);
+    setLayout(mainLayout);
+    hide();
+
+    connect(addButton, SIGNAL(clicked()), this, SLOT(addFiles()));
+    connect(clearButton, SIGNAL(clicked()), this, SLOT(clearFiles()));
+    connect(importButton, SIGNAL(clicked()), this, SLOT(startImport()));
+    connect(closeButton, SIGNAL(clicked()), this, SLOT(reject()));
+};
+
+TextureBatchImportDialog::~TextureBatchImportDialog()
+{
+    cancelled = true;
+    pool.clear();
+    pool.waitForDone();
+    clearJobs();
+};
+
+void TextureBatchImportDialog::setTextureData(DriverTextures* texs)
+{
+    if(texs != textureBlock)
+    {
+        cancelled = true;
+        pool.clear();
+        pool.waitForDone();
+        clearJobs();
+        setRunning(false);
+    }
+    textureBlock = texs;
+};
+
+void TextureBatchImportDialog::setD3D(DriverD3D* newD3D)
+{
+    d3d = newD3D;
+    //Textures can only be pointed at the shared palette through their D3D entries.
+    sharedPalette->setEnabled(d3d != NULL);
+};
+
+void TextureBatchImportDialog::setFirstTexture(int idx)
+{
+    firstTexture = (idx < 0 ? 0 : idx);
+};
+
+void TextureBatchImportDialog::loadSettings()
+{
+    QSettings settings;
+    lastDirectory = settings.value("TextureBatchImportDialog/directory", settings.value("directories/lastImageImportDir").toString()).toString();
+    mappingSelect->setCurrentIndex(settings.value("TextureBatchImportDialog/mapping",BATCH_MAP_BY_NAME).toInt());
+    namingEdit->setText(settings.value("TextureBatchImportDialog/naming","texture_%t_%p").toString());
+    transparencySelect->setCurrentIndex(settings.value("TextureBatchImportDialog/transparency",IMPORT_TRANSPARENCY_ALPHA).toInt());
+    sharedPalette->setCheckState((settings.value("TextureBatchImportDialog/sharedPalette",false).toBool() ? Qt::Checked : Qt::Unchecked));
+};
+
+void TextureBatchImportDialog::saveSettings()
+{
+    QSettings settings;
+    settings.setValue("TextureBatchImportDialog/directory",lastDirectory);
+    settings.setValue("TextureBatchImportDialog/mapping",mappingSelect->currentIndex());
+    settings.setValue("TextureBatchImportDialog/naming",namingEdit->text());
+    settings.setValue("TextureBatchImportDialog/transparency",transparencySelect->currentIndex());
+    settings.setValue("TextureBatchImportDialog/sharedPalette",(sharedPalette->checkState() == Qt::Checked ? true : false));
+};
+
+void TextureBatchImportDialog::reject()
+{
+    //Nothing is written to the level until every image is decoded, so cancelling leaves it untouched.
+    cancelled = true;
+    pool.clear();
+    pool.waitForDone();
+    clearJobs();
+    setRunning(false);
+    QDialog::reject();
+};
+
+void TextureBatchImportDialog::addFiles()
+{
+    QString imageFilter = "Images (*.bmp *.png *.gif *.jpeg *.jpg *.tiff *.tif *.tga *.dds)";
+    QString allFilesFilter = "All Files (*.*)";
+
+    QStringList files = QFileDialog::getOpenFileNames(this, tr("Import textures..."), lastDirectory, imageFilter+";;"+allFilesFilter);
+    if(files.isEmpty())
+        return;
+
+    lastDirectory = QFileInfo(files[0]).absolutePath();
+    files.sort();
+    fileList->addItems(files);
+};
+
+void TextureBatchImportDialog::clearFiles()
+{
+    fileList->clear();
+};
+
+bool TextureBatchImportDialog::matchFile(const QString& file, int order, int* texture, int* palette)
+{
+    *texture = -1;
+    *palette = 0;
+
+    if(mappingSelect->currentIndex() == BATCH_MAP_IN_ORDER)
+    {
+        *texture = firstTexture+order;
+        return true;
+    }
+
+    QString naming = namingEdit->text();
+    if(naming.isEmpty())
+    naming = "texture_%t_%p";
+
+    QString pattern = "^";
+    int literalStart = 0;
+    for(int i = 0; i < naming.size()-1; i++)
+    {
+        if(naming[i] != '%')
+            continue;
+
+        QString field;
+        switch(naming[i+1].toLatin1())
+        {
+            case 't':
+                field = "(?<texture>\\d+)";
+                break;
+            case 'p':
+                field = "(?<palette>\\d+)";
+                break;
+            case 's':
+            case 'c':
+                field = "-?\\d+";
+                break;
+            default:
+                continue;
+        }
+        pattern += QRegularExpression::escape(naming.mid(literalStart, i-literalStart)) + field;
+        literalStart = i+2;
+        i++;
+    }
+    pattern += QRegularExpression::escape(naming.mid(literalStart)) + "$";
+
+    QRegularExpressionMatch match = QRegularExpression(pattern).match(QFileInfo(file).completeBaseName());
+    if(!match.hasMatch() || match.captured("texture").isEmpty())
+    return false;
+
+    *texture = match.captured("texture").toInt();
+    if(!match.captured("palette").isEmpty())
+    *palette = match.captured("palette").toInt();
+    return true;
+};
+
+void TextureBatchImportDialog::clearJobs()
+{
+    for(int i = 0; i < jobs.size(); i++)
+    {
+        if(jobs[i]->pixels)
+        delete[] jobs[i]->pixels;
+        if(jobs[i]->sharedSource)
+        FreeImage_Unload(jobs[i]->sharedSource);
+        delete jobs[i];
+    }
+    jobs.clear();
+    numQueued = 0;
+    numFinished = 0;
+};
+
+void TextureBatchImportDialog::setRunning(bool running)
+{
+    importButton->setEnabled(!running);
+    addButton->setEnabled(!running);
+    clearButton->setEnabled(!running);
+    fileList->setEnabled(!running);
+    mappingSelect->setEnabled(!running);
+    namingEdit->setEnabled(!running);
+    transparencySelect->setEnabled(!running);
+    sharedPalette->setEnabled(!running && d3d);
+};
+
+void TextureBatchImportDialog::startImport()
+{
+    if(!textureBlock || fileList->count() == 0)
+        return;
+
+    clearJobs();
+    cancelled = false;
+
+    bool shared = (d3d && sharedPalette->checkState() == Qt::Checked);
+    int transparency = transparencySelect->currentIndex();
+    QMap<int,int> firstJobs; //Texture index to the first job importing it.
+
+    //Texture flags are read here so workers never touch the level.
+    for(int i = 0; i < fileList->count(); i++)
+    {
+        TextureImportJob* job = new TextureImportJob;
+        job->filename = fileList->item(i)->text();
+        job->usesPalette = false;
+        job->hasTransparency = false;
+        job->sharedPalette = false;
+        job->variantOf = -1;
+        job->success = false;
+        job->pixels = NULL;
+        job->sharedSource = NULL;
+        jobs.append(job);
+
+        const DriverTexture* tex = NULL;
+        if(matchFile(job->filename, i, &job->textureIndex, &job->paletteIndex))
+        tex = textureBlock->getTexture(job->textureIndex);
+
+        if(!tex)
+        {
+            job->error = tr("No matching texture in this level.");
+            continue;
+        }
+
+        job->usesPalette = tex->usesPalette();
+        job->hasTransparency = tex->hasTransparency();
+
+        //Files for other palettes of a texture all share its pixels, so only the first is quantized and the rest
+        //get palettes built against its indices.
+        if(firstJobs.contains(job->textureIndex))
+        {
+            int first = firstJobs[job->textureIndex];
+            bool samePalette = !job->usesPalette;
+            for(int j = first; j < i && !samePalette; j++)
+            {
+                if((j == first || jobs[j]->variantOf == first) && jobs[j]->paletteIndex == job->paletteIndex)
+                samePalette = true;
+            }
+            if(samePalette)
+            {
+                job->error = tr("Another file is already imported to this texture and palette.");
+                continue;
+            }
+            job->variantOf = first;
+        }
+        else firstJobs.insert(job->textureIndex, i);
+
+        job->sharedPalette = (shared && job->usesPalette && job->variantOf == -1);
+        numQueued++;
+    }
+
+    progress->setMaximum(numQueued > 0 ? numQueued : 1);
+    progress->setValue(0);
+
+    if(numQueued == 0)
+    {
+        commitJobs();
+        return;
+    }
+
+    setRunning(true);
+    for(int i = 0; i < jobs.size(); i++)
+    {
+        if(jobs[i]->error.isEmpty())
+        pool.start(new TextureImportTask(this, jobs[i], i, transparency, &cancelled));
+    }
+};
+
+void TextureBatchImportDialog::importDecoded(int job)
+{
+    if(cancelled || job < 0 || job >= jobs.size())
+        return;
+
+    numFinished++;
+    progress->setValue(numFinished);
+
+    if(numFinished < numQueued)
+        return;
+
+    QVector<TextureImportJob*> sharedJobs;
+    for(int i = 0; i < jobs.size(); i++)
+    {
+        if(jobs[i]->success && jobs[i]->sharedPalette)
+        sharedJobs.append(jobs[i]);
+    }
+
+    if(sharedJobs.isEmpty())
+    {
+        commitJobs();
+    }
+    else
+    {
+        progress->setMaximum(0);
+        pool.start(new SharedPaletteTask(this, sharedJobs, &cancelled));
+    }
+};
+
+void TextureBatchImportDialog::sharedPaletteFinished(bool success)
+{
+    if(cancelled)
+        return;
+
+    if(!success)
+    {
+        for(int i = 0; i < jobs.size(); i++)
+        {
+            if(jobs[i]->success && jobs[i]->sharedPalette)
+            {
+                jobs[i]->success = false;
+                jobs[i]->error = tr("Failed to build the shared palette.");
+            }
+        }
+    }
+    commitJobs();
+};
+
+//Each palette entry becomes the average colour of the pixels that use it in this file, so files exported from
+//the same texture with different palettes come back exactly.
+bool TextureBatchImportDialog::buildVariantPalette(TextureImportJob* job, const TextureImportJob* source)
+{
+    if(!job->sharedSource || !source->pixels)
+    return false;
+
+    int sums[256][4];
+    memset(sums,0,sizeof(sums));
+    for(int y = 0; y < 256; y++)
+    {
+        const unsigned char* scanLine = FreeImage_GetScanLine(job->sharedSource, 255-y);
+        const unsigned char* indices = source->pixels+y*256;
+        for(int x = 0; x < 256; x++, scanLine += 3)
+        {
+            int* sum = sums[indices[x]];
+            sum[0] += scanLine[FI_RGBA_RED];
+            sum[1] += scanLine[FI_RGBA_GREEN];
+            sum[2] += scanLine[FI_RGBA_BLUE];
+            sum[3]++;
+        }
+    }
+
+    job->palette = source->palette;
+    for(int i = 0; i < 256; i++)
+    {
+        if(sums[i][3] == 0)
+            continue;
+        job->palette.colors[i].r = (sums[i][0]+sums[i][3]/2)/sums[i][3];
+        job->palette.colors[i].g = (sums[i][1]+sums[i][3]/2)/sums[i][3];
+        job->palette.colors[i].b = (sums[i][2]+sums[i][3]/2)/sums[i][3];
+    }
+    return true;
+};
+
+void TextureBatchImportDialog::commitJobs()
+{
+    int numImported = 0;
+    int sharedSlot = -1;
+    QStringList failed;
+    QStringList warnings;
+
+    //Everything is applied in one batch so each texture is rebuilt once, however many files touch it.
+    textureBlock->beginChanges();
+    for(int i = 0; i < jobs.size(); i++)
+    {
+        TextureImportJob* job = jobs[i];
+        const DriverTexture* origTex = (job->success ? textureBlock->getTexture(job->textureIndex) : NULL);
+
+        if(origTex && origTex->usesPalette() != job->usesPalette)
+        job->error = tr("Texture format changed during import.");
+
+        if(origTex && job->error.isEmpty() && job->variantOf != -1)
+        {
+            if(!jobs[job->variantOf]->success)
+            job->error = tr("The first file for this texture failed to import.");
+            else if(!buildVariantPalette(job, jobs[job->variantOf]))
+            job->error = tr("Failed to convert image.");
+        }
+
+        if(!origTex || !job->error.isEmpty())
+        {
+            job->success = false;
+            failed.append(job->filename + ": " + (job->error.isEmpty() ? tr("Failed to convert image.") : job->error));
+            continue;
+        }
+
+        numImported++;
+        if(!job->warning.isEmpty())
+        warnings.append(job->filename + ": " + job->warning);
+
+        if(job->variantOf != -1)
+        {
+            job->palette.paletteNumber = TextureImportDialog::assignPaletteSlot(textureBlock, d3d, job->textureIndex, job->paletteIndex);
+            textureBlock->setPaletteIndexed(&job->palette);
+            continue;
+        }
+
+        DriverTexture tex = *origTex;
+        if(tex.usesPalette())
+        {
+            if(job->sharedPalette && sharedSlot != -1)
+            {
+                TextureImportDialog::setPaletteSlot(textureBlock, d3d, job->textureIndex, job->paletteIndex, sharedSlot);
+            }
+            else
+            {
+                job->palette.paletteNumber = TextureImportDialog::assignPaletteSlot(textureBlock, d3d, job->textureIndex, job->paletteIndex);
+                textureBlock->setPaletteIndexed(&job->palette);
+                if(job->sharedPalette)
+                sharedSlot = job->palette.paletteNumber;
+            }
+        }
+        tex.setData(job->pixels);
+        textureBlock->setTexture(job->textureIndex, &tex);
+    }
+    textureBlock->commitChanges();
+
+    clearJobs();
+    setRunning(false);
+    progress->setMaximum(1);
+    progress->setValue(1);
+
+    QMessageBox msgBox(this);
+    if(failed.isEmpty())
+    {
+        msgBox.setText(tr("Finished importing textures."));
+        msgBox.setInformativeText(tr("Imported %1 images.").arg(numImported));
+        msgBox.setIcon(QMessageBox::Information);
+        if(!warnings.isEmpty())
+        {
+            msgBox.setInformativeText(tr("Imported %1 images, %2 with warnings.").arg(numImported).arg(warnings.size()));
+            msgBox.setDetailedText(warnings.join("\n"));
+            msgBox.setIcon(QMessageBox::Warning);
+        }
+    }
+    else
+    {
+        msgBox.setText(tr("Failed to import %1 of %2 images!").arg(failed.size()).arg(failed.size()+numImported));
+        msgBox.setDetailedText((failed+warnings).join("\n"));
+        msgBox.setIcon(QMessageBox::Warning);
+    }
+    msgBox.exec();
+};
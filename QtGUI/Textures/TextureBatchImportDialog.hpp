@@ -0,0 +1,118 @@
+#ifndef TEXTURE_BATCH_IMPORT_DIALOG_HPP
+#define TEXTURE_BATCH_IMPORT_DIALOG_HPP
+
+#include <QtWidgets>
+#include <atomic>
+#include <FreeImage.h>
+#include "../../Driver_Routines/driver_levels.hpp"
+#include "../../Driver_Routines/driver_d3d.hpp"
+#include "TextureImportDialog.hpp"
+
+const int BATCH_MAP_BY_NAME = 0;
+const int BATCH_MAP_IN_ORDER = 1;
+
+//One image of a batch. Workers only write to their own job, the GUI thread reads it once they report back.
+struct TextureImportJob
+{
+    QString filename;
+    int textureIndex;
+    int paletteIndex;
+    bool usesPalette;
+    bool hasTransparency;
+    bool sharedPalette;
+    int variantOf; //Earlier job for the same texture whose pixel indices this one reuses, or -1.
+
+    bool success;
+    QString error;
+    QString warning;
+    unsigned char* pixels;
+    DriverPalette palette;
+    FIBITMAP* sharedSource; //24 bit copy kept until the shared or variant palette is built
+};
+
+//Loads, converts and quantizes a single image on a worker thread.
+class TextureImportTask : public QRunnable
+{
+    public:
+        TextureImportTask(QObject* resultReceiver, TextureImportJob* importJob, int jobIndex, int transparencyMode, std::atomic<bool>* cancelFlag);
+        void run();
+
+    protected:
+        QObject* receiver;
+        TextureImportJob* job;
+        int index;
+        int transparency;
+        std::atomic<bool>* cancelled;
+};
+
+//Builds one palette from the pixels of every image flagged for the shared palette and maps them all onto it.
+class SharedPaletteTask : public QRunnable
+{
+    public:
+        SharedPaletteTask(QObject* resultReceiver, const QVector<TextureImportJob*>& importJobs, std::atomic<bool>* cancelFlag);
+        void run();
+
+    protected:
+        QObject* receiver;
+        QVector<TextureImportJob*> jobs;
+        std::atomic<bool>* cancelled;
+};
+
+class TextureBatchImportDialog : public QDialog
+{
+    Q_OBJECT
+
+    public:
+        TextureBatchImportDialog(QWidget* parent = NULL);
+        ~TextureBatchImportDialog();
+
+        void setTextureData(DriverTextures* texs);
+        void setD3D(DriverD3D* newD3D);
+        void setFirstTexture(int idx);
+
+    public slots:
+        void loadSettings();
+        void saveSettings();
+        void reject();
+
+    protected slots:
+        void addFiles();
+        void clearFiles();
+        void startImport();
+        void importDecoded(int job);
+        void sharedPaletteFinished(bool success);
+
+    protected:
+        bool matchFile(const QString& file, int order, int* texture, int* palette);
+        bool buildVariantPalette(TextureImportJob* job, const TextureImportJob* source);
+        void commitJobs();
+        void clearJobs();
+        void setRunning(bool running);
+
+        DriverTextures* textureBlock;
+        DriverD3D* d3d;
+        int firstTexture;
+        QString lastDirectory;
+
+        QThreadPool pool;
+        std::atomic<bool> cancelled;
+        QVector<TextureImportJob*> jobs;
+        int numQueued;
+        int numFinished;
+
+        QListWidget* fileList;
+        QPushButton* addButton;
+        QPushButton* clearButton;
+        QLabel* mappingLabel;
+        QComboBox* mappingSelect;
+        QLabel* namingLabel;
+        QLineEdit* namingEdit;
+        QLabel* transparencyLabel;
+        QComboBox* transparencySelect;
+        QCheckBox* sharedPalette;
+        QProgressBar* progress;
+        QPushButton* importButton;
+        QPushButton* closeButton;
+};
+
+#endif
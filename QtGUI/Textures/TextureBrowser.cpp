@@ -64,6 +64,7 @@ void TextureBrowser::setup()
     pairAdvisoryWidget->setLayout(pairLayout);
 
     addPaletteDialog = new AddPaletteDialog(this);
+    optimizePalettesDialog = new OptimizePalettesDialog(this);
 
     informationFrame = new QFrame(this);
     informationFrame->setMinimumWidth(200);
@@ -119,7 +120,9 @@ void TextureBrowser::setup()
     paletteListContext->addAction(addPaletteToListAction);
 
     exportDialog = new TextureExportDialog(this);
+    batchExportDialog = new TextureBatchExportDialog(this);
     importDialog = new TextureImportDialog(this);
+    batchImportDialog = new TextureBatchImportDialog(this);
 
     QVBoxLayout* infoLayout = new QVBoxLayout();
     infoLayout->addWidget(textureSizeLabel);
@@ -159,9 +162,15 @@ void TextureBrowser::setup()
 
     editEditPalettesAction = new QAction(tr("Edit Palettes"),this);
     editDeleteUnusedAction = new QAction(tr("Delete Unused Palettes"),this);
+    editFindDuplicatesAction = new QAction(tr("Find Duplicates..."),this);
+    editOptimizePalettesAction = new QAction(tr("Optimize Palettes..."),this);
+    editRepackTexturesAction = new QAction(tr("Repack Texture Definitions..."),this);
+    editRegenerateSectorTexturesAction = new QAction(tr("Regenerate Sector Texture Lists..."),this);
     editSeparatorAction = new QAction(this);
     editSeparatorAction->setSeparator(true);
     editAddTextureAction = new QAction(tr("Add New Texture"),this);
+    editImportTexturesAction = new QAction(tr("Import Textures..."),this);
+    editExportAllAction = new QAction(tr("Export All Textures..."),this);
 
     textureDisplayContext->addAction(importAction);
     textureDisplayContext->addAction(exportAction);
@@ -184,7 +193,14 @@ void TextureBrowser::setup()
     connect(addPaletteToListAction, SIGNAL(triggered()), this, SLOT(doAddPaletteDialog()));
 
     connect(editDeleteUnusedAction, SIGNAL(triggered()), this, SLOT(deleteUnusedPalettes()));
+    connect(editFindDuplicatesAction, SIGNAL(triggered()), this, SLOT(findDuplicates()));
+    connect(editOptimizePalettesAction, SIGNAL(triggered()), this, SLOT(optimizePalettes()));
+    connect(editRepackTexturesAction, SIGNAL(triggered()), this, SLOT(repackTextures()));
+    connect(editRegenerateSectorTexturesAction, SIGNAL(triggered()), this, SLOT(regenerateSectorTextures()));
+    connect(optimizePalettesDialog, SIGNAL(palettesOptimized()), this, SLOT(rebuildPaletteList()));
     connect(editAddTextureAction, SIGNAL(triggered()), newTextureDialog, SLOT(exec()));
+    connect(editImportTexturesAction, SIGNAL(triggered()), this, SLOT(importTextures()));
+    connect(editExportAllAction, SIGNAL(triggered()), this, SLOT(exportAllTextures()));
     connect(newTextureDialog, SIGNAL(newTextureRequested(unsigned short, short)), this, SLOT(addNewTexture(unsigned short, short)));
 
     connect(textureSizeSelect, SIGNAL(currentIndexChanged(int)), this, SLOT( setTextureSize(int)));
@@ -209,8 +225,11 @@ TextureBrowser::~TextureBrowser()
         level->textures.unregisterEventHandler(this);
         display->setTextureData(NULL);
         exportDialog->setLevel(NULL);
+        batchExportDialog->setLevel(NULL);
         importDialog->setTextureData(NULL);
+        batchImportDialog->setTextureData(NULL);
         addPaletteDialog->setTextureData(NULL);
+        optimizePalettesDialog->setTextureData(NULL);
         texturesChanged();
     }
 };
@@ -251,69 +270,28 @@ void TextureBrowser::exportTexture()
     exportDialog->exec();
 };
 
+void TextureBrowser::importTextures()
+{
+    batchImportDialog->setFirstTexture(textureNumber->value());
+    batchImportDialog->exec();
+    display->viewer()->update();
+};
+
+void TextureBrowser::exportAllTextures()
+{
+    batchExportDialog->setFilter(filterSelect->currentIndex());
+    batchExportDialog->exec();
+};
+
 void TextureBrowser::applyFilter(int idx)
 {
     if(level)
     {
         for(int i = 0; i < level->textures.getNumTextures(); i++)
         {
-            switch(idx)
-            {
-                case FILTER_ALL_TEXTURES:
-                    indexList->setRowHidden(i,false);
-                    display->viewer()->setTextureHidden(i,false);
-                    break;
-                case FILTER_CAR_TEXTURES:
-                    if(level->textures.getTexture(i)->getCarNumber() != -1 && (level->textures.getTexture(i)->isCleanTexture() || level->textures.getTexture(i)->isDamageTexture()))
-                    {
-                        indexList->setRowHidden(i,false);
-                        display->viewer()->setTextureHidden(i,false);
-                    }
-                    else
-                    {
-                        indexList->setRowHidden(i,true);
-                        display->viewer()->setTextureHidden(i,true);
-                    }
-                    break;
-                case FILTER_PALETTED_TEXTURES:
-                    if(level->textures.getTexture(i)->usesPalette())
-                    {
-                        indexList->setRowHidden(i,false);
-                        display->viewer()->setTextureHidden(i,false);
-                    }
-                    else
-                    {
-                        indexList->setRowHidden(i,true);
-                        display->viewer()->setTextureHidden(i,true);
-                    }
-                    break;
-                case FILTER_15_BIT_TEXTURES:
-                    if(level->textures.getTexture(i)->usesPalette())
-                    {
-                        indexList->setRowHidden(i,true);
-                        display->viewer()->setTextureHidden(i,true);
-                    }
-                    else
-                    {
-                        indexList->setRowHidden(i,false);
-                        display->viewer()->setTextureHidden(i,false);
-                    }
-                    break;
-                case FILTER_TRANSPARENT_TEXTURES:
-                    if(level->textures.getTexture(i)->hasTransparency())
-                    {
-                        indexList->setRowHidden(i,false);
-                        display->viewer()->setTextureHidden(i,false);
-                    }
-                    else
-                    {
-                        indexList->setRowHidden(i,true);
-                        display->viewer()->setTextureHidden(i,true);
-                    }
-                    break;
-                default:
-                    break;
-            }
+            bool hidden = !textureMatchesFilter(level->textures.getTexture(i), idx);
+            indexList->setRowHidden(i,hidden);
+            display->viewer()->setTextureHidden(i,hidden);
         }
     }
 };
@@ -372,14 +350,20 @@ void TextureBrowser::setTextureList(LevelTextures* texs)
 void TextureBrowser::setD3D(DriverD3D* newd3d)
 {
     exportDialog->setD3D(newd3d);
+    batchExportDialog->setD3D(newd3d);
     importDialog->setD3D(newd3d);
+    batchImportDialog->setD3D(newd3d);
+    optimizePalettesDialog->setD3D(newd3d);
     d3d = newd3d;
 };
 
 void TextureBrowser::loadSettings()
 {
     exportDialog->loadSettings();
+    batchExportDialog->loadSettings();
     importDialog->loadSettings();
+    batchImportDialog->loadSettings();
+    optimizePalettesDialog->loadSettings();
 
     QSettings settings;
     setTextureSize(settings.value("TextureBrowser/textureSize",0).toInt());
@@ -388,7 +372,10 @@ void TextureBrowser::loadSettings()
 void TextureBrowser::saveSettings()
 {
     exportDialog->saveSettings();
+    batchExportDialog->saveSettings();
     importDialog->saveSettings();
+    batchImportDialog->saveSettings();
+    optimizePalettesDialog->saveSettings();
 
     QSettings settings;
     settings.setValue("TextureBrowser/textureSize",textureSizeSelect->currentIndex());
@@ -443,8 +430,12 @@ void TextureBrowser::setLevel(DriverLevel* lev)
 
     display->setTextureData(textures);
     exportDialog->setLevel(level);
+    batchExportDialog->setLevel(level);
     importDialog->setTextureData(textures);
+    batchImportDialog->setTextureData(textures);
     addPaletteDialog->setTextureData(textures);
+    optimizePalettesDialog->setTextureData(textures);
+    textureUsage.setLevel(level);
     texturesChanged();
     if(level)
     {
@@ -538,32 +529,50 @@ bool TextureBrowser::eventFilter(QObject* obj, QEvent* event)
 void TextureBrowser::hideMenuActions()
 {
     editDeleteUnusedAction->setVisible(false);
+    editFindDuplicatesAction->setVisible(false);
+    editOptimizePalettesAction->setVisible(false);
+    editRepackTexturesAction->setVisible(false);
+    editRegenerateSectorTexturesAction->setVisible(false);
     editEditPalettesAction->setVisible(false);
     editSeparatorAction->setVisible(false);
     editAddTextureAction->setVisible(false);
+    editImportTexturesAction->setVisible(false);
+    editExportAllAction->setVisible(false);
 };
 
 void TextureBrowser::showMenuActions()
 {
     editDeleteUnusedAction->setVisible(true);
+    editFindDuplicatesAction->setVisible(true);
+    editOptimizePalettesAction->setVisible(true);
+    editRepackTexturesAction->setVisible(true);
+    editRegenerateSectorTexturesAction->setVisible(true);
     editEditPalettesAction->setVisible(true);
     editSeparatorAction->setVisible(true);
     editAddTextureAction->setVisible(true);
+    editImportTexturesAction->setVisible(true);
+    editExportAllAction->setVisible(true);
 };
 
 void TextureBrowser::setupEditMenu(QMenu* editMenu)
 {
     editMenu->addAction(editEditPalettesAction);
     editMenu->addAction(editDeleteUnusedAction);
+    editMenu->addAction(editFindDuplicatesAction);
+    editMenu->addAction(editOptimizePalettesAction);
+    editMenu->addAction(editRepackTexturesAction);
+    editMenu->addAction(editRegenerateSectorTexturesAction);
     editMenu->addAction(editSeparatorAction);
     editMenu->addAction(editAddTextureAction);
+    editMenu->addAction(editImportTexturesAction);
+    editMenu->addAction(editExportAllAction);
 };
 
 void TextureBrowser::handleCarNumberChange(int car)
 {
     if(level)
     {
-        //I don't like how inefficient a deep copy is here.
+        //Copy shares pixel data with the original, only the car number changes.
         DriverTexture newTex = *level->textures.getTexture(indexList->currentRow());
         newTex.setCarNumber(car);
         level->textures.setTexture(indexList->currentRow(),&newTex);
@@ -578,6 +587,7 @@ void TextureBrowser::handlePropertiesChange(unsigned short properties)
         if(tex)
         {
             DriverTexture newTex = *tex;
+            TextureChangeBatch batch(&level->textures);
 
             if(((properties&TEX_USES_PALETTE) != 0) != tex->usesPalette())
             {
@@ -640,18 +650,9 @@ void TextureBrowser::handlePropertiesChange(unsigned short properties)
                                     bits += 3;
                                 }
                             }
-                            FIBITMAP* converted = FreeImage_ColorQuantize(dib,FIQ_NNQUANT);
-                            FreeImage_Unload(dib);
-
-                            RGBQUAD *fiPal = FreeImage_GetPalette(converted);
                             DriverPalette palette;
-
-                            for (int i = 0; i < 256; i++)
-                            {
-                                palette.colors[i].r = fiPal[i].rgbRed;
-                                palette.colors[i].g = fiPal[i].rgbGreen;
-                                palette.colors[i].b = fiPal[i].rgbBlue;
-                            }
+                            FIBITMAP* converted = quantizeImage(dib, &palette);
+                            FreeImage_Unload(dib);
 
                             for(int i = 0; i < 256; i++)
                             {
@@ -761,15 +762,10 @@ void TextureBrowser::deleteUnusedPalettes()
             {
                 isUsed[i] = false;
             }
-            for(int i = 0; i < d3d->getNumEntries(); i++)
+            for(int i = 0; i < highestIndex; i++)
             {
-                D3DEntry* entry = d3d->getEntry(i);
-                for(int j = 0; j < entry->getNumPaletteIndicies(); j++)
-                {
-                    int slot = entry->getPaletteIndex(j);
-                    if(slot >= 0 && slot < highestIndex)
-                        isUsed[slot] = true;
-                }
+                if(d3d->getNumPaletteReferences(i) > 0)
+                    isUsed[i] = true;
             }
             for(int i = 0; i < highestIndex; i++)
             {
@@ -874,73 +870,324 @@ void TextureBrowser::deleteCurrentTexture()
 
     QMessageBox msgBox(this);
     msgBox.setText(tr("Delete texture %1?").arg(idx));
+    if(level && textureUsage.isTextureUsed(idx))
+    msgBox.setInformativeText(tr("It is used by %1 models, %2 sectors and %3 texture definitions. Faces using it will lose their texture.").arg(textureUsage.getModels(idx).size()).arg(textureUsage.getSectors(idx).size()).arg(textureUsage.getDefinitions(idx).size()));
     msgBox.setIcon(QMessageBox::Warning);
     msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
     msgBox.setDefaultButton(QMessageBox::No);
     int ret = msgBox.exec();
     if(ret == QMessageBox::Yes)
     {
-        if(level)
+        removeTexture(idx);
+        rebuildPaletteList();
+    }
+};
+
+//Removes a texture and fixes every reference to it. References to the removed texture are moved to replacement,
+//which must be lower than idx, or dropped if there is no replacement.
+void TextureBrowser::removeTexture(int idx, int replacement)
+{
+    if(level)
+    {
+        level->textures.removeTexture(idx);
+        for(int i = 0; i < level->models.getNumModels(); i++)
         {
-            level->textures.removeTexture(idx);
-            for(int i = 0; i < level->models.getNumModels(); i++)
+            DriverModel* model = level->models.getModel(i);
+            bool changed = false;
+            for(int j = 0; j < model->getNumFaces(); j++)
+            {
+                ModelFace face = model->getFace(j);
+                if(face.getTexture() == idx)
+                face.setTexture(replacement);
+                else if(face.getTexture() > idx)
+                face.setTexture(face.getTexture()-1);
+                else continue;
+                model->setFace(j,face);
+                changed = true;
+            }
+            if(changed)
             {
-                DriverModel* model = level->models.getModel(i);
-                for(int j = 0; j < model->getNumFaces(); j++)
-                {
-                    ModelFace face = model->getFace(j);
-                    if(face.getTexture() == idx)
-                    face.setTexture(-1);
-                    else if(face.getTexture() > idx)
-                    face.setTexture(face.getTexture()-1);
-                    model->setFace(j,face);
-                }
                 model->recalculateTexturesUsed();
+                level->models.markModelChanged(i);
             }
-            for(int i = 0; i < level->world.getNumSectors(); i++)
+        }
+        for(int i = 0; i < level->world.getNumSectors(); i++)
+        {
+            SectorTextureList* list = level->sectorTextures.getTextureList(i);
+            int indexToRemove = -1;
+            bool hasReplacement = false;
+            for(int j = 0; j < list->getNumTexturesUsed(); j++)
+            {
+                if(list->getTexture(j) == replacement)
+                hasReplacement = true;
+            }
+            for(int j = 0; j < list->getNumTexturesUsed(); j++)
             {
-                SectorTextureList* list = level->sectorTextures.getTextureList(i);
-                int indexToRemove = -1;
-                for(int j = 0; j < list->getNumTexturesUsed(); j++)
-                {
 
-                    if(list->getTexture(j) == idx)
-                    indexToRemove = j;
-                    else if(list->getTexture(j) > idx)
-                    list->setTexture(j,list->getTexture(j)-1);
+                if(list->getTexture(j) == idx)
+                {
+                    if(replacement != -1 && !hasReplacement)
+                    list->setTexture(j,replacement);
+                    else indexToRemove = j;
                 }
-                if(indexToRemove != -1)
-                list->removeTexture(indexToRemove);
+                else if(list->getTexture(j) > idx)
+                list->setTexture(j,list->getTexture(j)-1);
             }
-            for(int i = 0; i < level->textureDefinitions.getNumTextureDefinitions(); i++)
+            if(indexToRemove != -1)
+            list->removeTexture(indexToRemove);
+        }
+        for(int i = 0; i < level->textureDefinitions.getNumTextureDefinitions(); i++)
+        {
+            TextureDefinition def = *level->textureDefinitions.getTextureDefinition(i);
+            if(def.getTexture() == idx)
             {
-                TextureDefinition* def = level->textureDefinitions.getTextureDefinition(i);
-                if(def->getTexture() == idx)
+                if(replacement != -1)
                 {
-                    level->textureDefinitions.removeTextureDefinition(i);
-                    i--; //Keep index at same location.
+                    def.setTexture(replacement);
+                    level->textureDefinitions.setTextureDefinition(i,def);
                 }
-                else if(def->getTexture() > idx)
+                else
                 {
-                    def->setTexture(def->getTexture()-1);
+                    level->textureDefinitions.removeTextureDefinition(i);
+                    i--; //Keep index at same location.
                 }
             }
+            else if(def.getTexture() > idx)
+            {
+                def.setTexture(def.getTexture()-1);
+                level->textureDefinitions.setTextureDefinition(i,def);
+            }
         }
-        if(d3d)
+        if(replacement != -1)
         {
-            D3DEntry* entry = d3d->getTextureEntry(idx);
-            if(entry)
-                d3d->removeTextureEntry(idx);
-            for(int i = 0; i < d3d->getNumEntries(); i++)
+            for(int i = 0; i < level->textureDefinitions.getNumTextureDefinitions(); i++)
+            {
+                if(level->textureDefinitions.resortTextureDefinition(i) > i)
+                i--;
+            }
+        }
+    }
+    if(d3d)
+    {
+        D3DEntry* entry = d3d->getTextureEntry(idx);
+        if(entry)
+            d3d->removeTextureEntry(idx);
+        for(int i = 0; i < d3d->getNumEntries(); i++)
+        {
+            if(d3d->getEntry(i)->getTexture() > idx)
             {
-                if(d3d->getEntry(i)->getTexture() > idx)
+                d3d->getEntry(i)->setTexture(d3d->getEntry(i)->getTexture()-1);
+            }
+        }
+    }
+};
+
+void TextureBrowser::findDuplicates()
+{
+    if(!level)
+        return;
+
+    bool ok = false;
+    int tolerance = QInputDialog::getInt(this, tr("Find Duplicates"), tr("Palette color tolerance (0 only finds exact matches):"), 0, 0, 255, 1, &ok);
+    if(!ok)
+        return;
+
+    TextureDuplicateFinder finder;
+    finder.find(&level->textures, d3d, tolerance);
+
+    //Paletted textures are stored in pairs, so removing one would break the pairing. They are reported but kept.
+    QStringList details;
+    int texturesToMerge = 0;
+    for(int i = 0; i < finder.getNumTextureDuplicates(); i++)
+    {
+        const TextureDuplicate* duplicate = finder.getTextureDuplicate(i);
+        if(duplicate->type == DUPLICATE_PALETTE_ONLY)
+        {
+            details.append(tr("Texture %1 has the same pixels as texture %2 with different palettes.").arg(duplicate->texture).arg(duplicate->original));
+        }
+        else if(level->textures.getTexture(duplicate->texture)->usesPalette())
+        {
+            details.append(tr("Texture %1 is a copy of texture %2 (paletted, kept).").arg(duplicate->texture).arg(duplicate->original));
+        }
+        else
+        {
+            details.append(tr("Texture %1 is a copy of texture %2.").arg(duplicate->texture).arg(duplicate->original));
+            texturesToMerge++;
+        }
+    }
+    for(int i = 0; i < finder.getNumPaletteDuplicates(); i++)
+    {
+        const PaletteDuplicate* duplicate = finder.getPaletteDuplicate(i);
+        details.append(tr("Palette slot %1 matches slot %2 (largest difference %3).").arg(duplicate->slot).arg(duplicate->original).arg(duplicate->difference));
+    }
+    int palettesToMerge = (d3d ? finder.getNumPaletteDuplicates() : 0);
+
+    QMessageBox msg(this);
+    msg.setText(tr("Found %1 duplicate textures and %2 duplicate palettes.").arg(finder.getNumTextureDuplicates()).arg(finder.getNumPaletteDuplicates()));
+    if(!details.isEmpty())
+    msg.setDetailedText(details.join("\n"));
+
+    if(texturesToMerge == 0 && palettesToMerge == 0)
+    {
+        msg.setIcon(QMessageBox::Information);
+        msg.setStandardButtons(QMessageBox::Ok);
+        msg.exec();
+        return;
+    }
+
+    msg.setInformativeText(tr("Merge %1 textures and %2 palettes? All references are moved to the first copy and the duplicates are deleted.").arg(texturesToMerge).arg(palettesToMerge));
+    msg.setIcon(QMessageBox::Question);
+    msg.setStandardButtons(QMessageBox::Yes|QMessageBox::No);
+    msg.setDefaultButton(QMessageBox::No);
+    if(msg.exec() != QMessageBox::Yes)
+        return;
+
+    if(d3d)
+    {
+        for(int i = 0; i < finder.getNumPaletteDuplicates(); i++)
+        {
+            const PaletteDuplicate* duplicate = finder.getPaletteDuplicate(i);
+            //Each change removes the entry from the slot's reference list.
+            while(d3d->getNumPaletteReferences(duplicate->slot) > 0)
+            {
+                D3DEntry* entry = d3d->getEntry(d3d->getPaletteReference(duplicate->slot, 0));
+                for(int k = 0; k < entry->getNumPaletteIndicies(); k++)
                 {
-                    d3d->getEntry(i)->setTexture(d3d->getEntry(i)->getTexture()-1);
+                    if(entry->getPaletteIndex(k) == duplicate->slot)
+                    entry->setPaletteIndex(k, duplicate->original);
                 }
             }
+            level->textures.removeIndexedPalette(duplicate->slot);
         }
-        rebuildPaletteList();
     }
+
+    //Highest first, so indices of the remaining duplicates and their originals stay valid.
+    for(int i = finder.getNumTextureDuplicates()-1; i >= 0; i--)
+    {
+        const TextureDuplicate* duplicate = finder.getTextureDuplicate(i);
+        if(duplicate->type == DUPLICATE_EXACT && !level->textures.getTexture(duplicate->texture)->usesPalette())
+        removeTexture(duplicate->texture, duplicate->original);
+    }
+    rebuildPaletteList();
+};
+
+void TextureBrowser::optimizePalettes()
+{
+    if(!level)
+        return;
+
+    optimizePalettesDialog->exec();
+    display->viewer()->update();
+};
+
+void TextureBrowser::repackTextures()
+{
+    if(!level)
+        return;
+
+    bool ok = false;
+    int padding = QInputDialog::getInt(this, tr("Repack Texture Definitions"), tr("Empty pixels between packed definitions:"), 0, 0, 16, 1, &ok);
+    if(!ok)
+        return;
+
+    TextureAtlasPacker packer;
+    packer.setPadding(padding);
+    packer.analyze(level);
+
+    QString skipped;
+    if(packer.getNumRejectedPages() > 0)
+    skipped = tr("%1 pages were skipped because model faces use pixels outside their texture definitions, or definitions run past the edge of the page.").arg(packer.getNumRejectedPages());
+
+    QMessageBox msg(this);
+    if(packer.getNumFreedTextures() == 0)
+    {
+        msg.setText(tr("No texture pages can be freed by repacking."));
+        msg.setInformativeText(skipped);
+        msg.setIcon(QMessageBox::Information);
+        msg.setStandardButtons(QMessageBox::Ok);
+        msg.exec();
+        return;
+    }
+
+    if(packer.getNumSectorOverflows() > 0)
+    {
+        QStringList sectors;
+        for(int i = 0; i < packer.getNumSectorOverflows() && i < 10; i++)
+        sectors << QString::number(packer.getSectorOverflow(i));
+        if(packer.getNumSectorOverflows() > 10)
+        sectors << tr("...");
+
+        msg.setText(tr("Repacking would give %1 sectors more than %2 textures.").arg(packer.getNumSectorOverflows()).arg(SECTOR_TEXTURE_LIMIT));
+        msg.setInformativeText(tr("Nothing was changed. Sectors: %1").arg(sectors.join(", ")));
+        msg.setIcon(QMessageBox::Warning);
+        msg.setStandardButtons(QMessageBox::Ok);
+        msg.exec();
+        return;
+    }
+
+    int numPacked = packer.getNumPackedPages();
+    int numFreed = packer.getNumFreedTextures();
+    msg.setText(tr("%1 texture pages can be packed into %2, freeing %3 texture slots.").arg(numPacked).arg(numPacked-numFreed).arg(numFreed));
+    msg.setInformativeText(tr("Pixels, texture definitions and model faces will be moved and the freed pages deleted. %1").arg(skipped));
+    msg.setIcon(QMessageBox::Question);
+    msg.setStandardButtons(QMessageBox::Yes|QMessageBox::No);
+    msg.setDefaultButton(QMessageBox::No);
+    if(msg.exec() != QMessageBox::Yes)
+        return;
+
+    if(packer.apply(level) < 0)
+        return;
+    textureUsage.invalidateSectors();
+
+    //Highest first, so the remaining indices stay valid.
+    for(int i = numFreed-1; i >= 0; i--)
+    removeTexture(packer.getFreedTexture(i));
+    display->viewer()->update();
+};
+
+void TextureBrowser::regenerateSectorTextures()
+{
+    if(!level)
+        return;
+
+    SectorTextureBuilder builder;
+    builder.analyze(level);
+
+    QString overflows;
+    if(builder.getNumOverflows() > 0)
+    {
+        QStringList sectors;
+        for(int i = 0; i < builder.getNumOverflows() && i < 10; i++)
+        {
+            int sector = builder.getOverflowSector(i);
+            sectors << tr("%1 (%2 textures)").arg(sector).arg(builder.getNumTexturesNeeded(sector));
+        }
+        if(builder.getNumOverflows() > 10)
+        sectors << tr("...");
+        overflows = tr("%1 sectors need more than %2 textures and will be left unchanged: %3").arg(builder.getNumOverflows()).arg(SECTOR_TEXTURE_LIMIT).arg(sectors.join(", "));
+    }
+
+    QMessageBox msg(this);
+    if(builder.getNumChangedSectors() == 0)
+    {
+        msg.setText(tr("Every sector texture list already matches the models placed in it."));
+        msg.setInformativeText(overflows);
+        msg.setIcon(QMessageBox::Information);
+        msg.setStandardButtons(QMessageBox::Ok);
+        msg.exec();
+        return;
+    }
+
+    msg.setText(tr("%1 of %2 sector texture lists differ from the textures used by their models.").arg(builder.getNumChangedSectors()).arg(builder.getNumSectors()));
+    msg.setInformativeText(tr("Replace them with the textures the models use? %1").arg(overflows));
+    msg.setIcon(builder.getNumOverflows() > 0 ? QMessageBox::Warning : QMessageBox::Question);
+    msg.setStandardButtons(QMessageBox::Yes|QMessageBox::No);
+    msg.setDefaultButton(QMessageBox::No);
+    if(msg.exec() != QMessageBox::Yes)
+        return;
+
+    builder.apply(level);
+    textureUsage.invalidateSectors();
 };
 
 void TextureBrowser::pairTextures()
@@ -1008,16 +1255,23 @@ void TextureBrowser::insertTexture(int idx, const DriverTexture* tex)
             for(int i = 0; i < level->models.getNumModels(); i++)
             {
                 DriverModel* model = level->models.getModel(i);
+                bool changed = false;
                 for(int j = 0; j < model->getNumFaces(); j++)
                 {
                     ModelFace face = model->getFace(j);
 
                     if(face.getTexture() >= idx)
-                    face.setTexture(face.getTexture()+1);
-
-                    model->setFace(j,face);
+                    {
+                        face.setTexture(face.getTexture()+1);
+                        model->setFace(j,face);
+                        changed = true;
+                    }
+                }
+                if(changed)
+                {
+                    model->recalculateTexturesUsed();
+                    level->models.markModelChanged(i);
                 }
-                model->recalculateTexturesUsed();
             }
             for(int i = 0; i < level->world.getNumSectors(); i++)
             {
@@ -1030,9 +1284,12 @@ void TextureBrowser::insertTexture(int idx, const DriverTexture* tex)
             }
             for(int i = 0; i < level->textureDefinitions.getNumTextureDefinitions(); i++)
             {
-                TextureDefinition* def = level->textureDefinitions.getTextureDefinition(i);
-                if(def->getTexture() >= idx)
-                def->setTexture(def->getTexture()+1);
+                TextureDefinition def = *level->textureDefinitions.getTextureDefinition(i);
+                if(def.getTexture() >= idx)
+                {
+                    def.setTexture(def.getTexture()+1);
+                    level->textureDefinitions.setTextureDefinition(i,def);
+                }
             }
         }
         if(d3d)
@@ -1091,6 +1348,7 @@ void TextureBrowser::moveTexture(int from, int to)
             for(int i = 0; i < level->models.getNumModels(); i++)
             {
                 DriverModel* model = level->models.getModel(i);
+                bool changed = false;
                 for(int j = 0; j < model->getNumFaces(); j++)
                 {
                     ModelFace face = model->getFace(j);
@@ -1099,10 +1357,16 @@ void TextureBrowser::moveTexture(int from, int to)
                     face.setTexture(to);
                     else if(face.getTexture() >= min && face.getTexture() <= max)
                     face.setTexture(face.getTexture()+dir);
+                    else continue;
 
                     model->setFace(j,face);
+                    changed = true;
+                }
+                if(changed)
+                {
+                    model->recalculateTexturesUsed();
+                    level->models.markModelChanged(i);
                 }
-                model->recalculateTexturesUsed();
             }
             for(int i = 0; i < level->world.getNumSectors(); i++)
             {
@@ -1117,11 +1381,13 @@ void TextureBrowser::moveTexture(int from, int to)
             }
             for(int i = 0; i < level->textureDefinitions.getNumTextureDefinitions(); i++)
             {
-                TextureDefinition* def = level->textureDefinitions.getTextureDefinition(i);
-                if(def->getTexture() == from)
-                def->setTexture(to);
-                else if(def->getTexture() >= min && def->getTexture() <= max)
-                def->setTexture(def->getTexture()+dir);
+                TextureDefinition def = *level->textureDefinitions.getTextureDefinition(i);
+                if(def.getTexture() == from)
+                def.setTexture(to);
+                else if(def.getTexture() >= min && def.getTexture() <= max)
+                def.setTexture(def.getTexture()+dir);
+                else continue;
+                level->textureDefinitions.setTextureDefinition(i,def);
             }
             for(int i = 0; i < level->textureDefinitions.getNumTextureDefinitions(); i++)
             {
@@ -1171,6 +1437,14 @@ void TextureBrowser::textureChanged(int idx)
     checkForPairs();
 };
 
+void TextureBrowser::textureBatchChanged(const int* indices, int count)
+{
+    //Only the selected texture's properties are shown, so refresh it once if it was part of the batch.
+    if(binary_search(indices, indices+count, indexList->currentRow()))
+        textureChanged(indexList->currentRow());
+    else checkForPairs();
+};
+
 void TextureBrowser::textureMoved(int /*from*/, int /*to*/)
 {
     checkForPairs();
@@ -1196,8 +1470,11 @@ void TextureBrowser::levelDestroyed()
     level = NULL;
     display->setTextureData(NULL);
     exportDialog->setLevel(NULL);
+    batchExportDialog->setLevel(NULL);
     importDialog->setTextureData(NULL);
+    batchImportDialog->setTextureData(NULL);
     addPaletteDialog->setTextureData(NULL);
+    optimizePalettesDialog->setTextureData(NULL);
     texturesChanged();
 };
 
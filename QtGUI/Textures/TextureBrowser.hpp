@@ -5,18 +5,20 @@
 #include <QtOpenGLWidgets>
 #include <FreeImage.h>
 #include "../../Driver_Routines/driver_levels.hpp"
+#include "../../Driver_Routines/DriverLevels/sectorTextureBuilder.hpp"
+#include "../../Driver_Routines/DriverLevels/textureAtlas.hpp"
+#include "../../Driver_Routines/DriverLevels/textureDuplicates.hpp"
+#include "../../Driver_Routines/DriverLevels/textureUsage.hpp"
 #include "../Palettes/AddPaletteDialog.hpp"
+#include "../Palettes/OptimizePalettesDialog.hpp"
 #include "../TextureList.hpp"
 #include "TextureView.hpp"
 #include "TexturePropertiesWidget.hpp"
 #include "TextureExportDialog.hpp"
 #include "TextureImportDialog.hpp"
-
-const int FILTER_ALL_TEXTURES = 0;
-const int FILTER_CAR_TEXTURES = 1;
-const int FILTER_PALETTED_TEXTURES = 2;
-const int FILTER_15_BIT_TEXTURES = 3;
-const int FILTER_TRANSPARENT_TEXTURES = 4;
+#include "TextureBatchExportDialog.hpp"
+#include "TextureBatchImportDialog.hpp"
+#include "TextureFilters.hpp"
 
 class NewTextureDialog : public QDialog
 {
@@ -55,6 +57,7 @@ class TextureBrowser : public QWidget, IDriverTextureEvents, IDriverLevelEvents
         //Event handlers
         void textureRemoved(int idx);
         void textureChanged(int idx);
+        void textureBatchChanged(const int* indices, int count);
         void textureInserted(int idx);
         void textureMoved(int from, int to);
         void levelSaved(bool aboutToBe);
@@ -77,9 +80,15 @@ class TextureBrowser : public QWidget, IDriverTextureEvents, IDriverLevelEvents
         void removePaletteFromList();
         void importTexture();
         void exportTexture();
+        void exportAllTextures();
+        void importTextures();
         void rebuildPaletteList();
         void deleteUnusedPalettes();
         void deleteCurrentTexture();
+        void findDuplicates();
+        void optimizePalettes();
+        void repackTextures();
+        void regenerateSectorTextures();
         void pairTextures();
         void handleCarNumberChange(int car);
         void handlePropertiesChange(unsigned short properties);
@@ -90,6 +99,7 @@ class TextureBrowser : public QWidget, IDriverTextureEvents, IDriverLevelEvents
         void refreshIndexList();
         void moveTexture(int from, int to);
         void insertTexture(int idx, const DriverTexture* tex);
+        void removeTexture(int idx, int replacement = -1);
         void hideEvent(QHideEvent* event);
         void showEvent(QShowEvent* event);
         bool eventFilter(QObject* obj, QEvent* event);
@@ -99,6 +109,7 @@ class TextureBrowser : public QWidget, IDriverTextureEvents, IDriverLevelEvents
 
         DriverLevel* level;
         DriverD3D* d3d;
+        TextureUsageIndex textureUsage;
         LevelTextures* textureList;
 
         int textureSelection, paletteSelection;
@@ -134,20 +145,29 @@ class TextureBrowser : public QWidget, IDriverTextureEvents, IDriverLevelEvents
         QLabel* palettesLabel;
 
         QAction* editAddTextureAction;
+        QAction* editImportTexturesAction;
+        QAction* editExportAllAction;
         QAction* editEditPalettesAction;
         QAction* editDeleteUnusedAction;
+        QAction* editFindDuplicatesAction;
+        QAction* editOptimizePalettesAction;
+        QAction* editRepackTexturesAction;
+        QAction* editRegenerateSectorTexturesAction;
         QAction* editSeparatorAction;
 
         QFrame* propertiesFrame;
         TexturePropertiesWidget* textureProperties;
         AddPaletteDialog* addPaletteDialog;
+        OptimizePalettesDialog* optimizePalettesDialog;
 
         QWidget* pairAdvisoryWidget;
         QLabel* pairAdvisoryText;
         QPushButton* pairAdvisoryButton;
 
         TextureExportDialog* exportDialog;
+        TextureBatchExportDialog* batchExportDialog;
         TextureImportDialog* importDialog;
+        TextureBatchImportDialog* batchImportDialog;
 };
 
 #endif
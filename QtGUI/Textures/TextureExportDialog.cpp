@@ -326,8 +326,11 @@ TextureExportDialog::TextureExportDialog(QWidget* parent) : QDialog(parent)
     mainLayout->addLayout(buttonLayout);
     setLayout(mainLayout);
     textureBitmap = NULL;
-    cachedBitmap = NULL;
+    cachedBpp = 0;
+    cachedMagicPink = false;
     transEnabled = true;
+    previewRequest = 0;
+    previewPool.setMaxThreadCount(2);
 
     connect(cancelButton, SIGNAL(clicked()), this, SLOT(reject()));
     connect(saveButton, SIGNAL(clicked()), this, SLOT(saveTexture()));
@@ -365,13 +368,12 @@ TextureExportDialog::TextureExportDialog(QWidget* parent) : QDialog(parent)
 
 TextureExportDialog::~TextureExportDialog()
 {
+    previewPool.clear();
+    previewPool.waitForDone();
+
     if(textureBitmap)
     FreeImage_Unload(textureBitmap);
     textureBitmap = NULL;
-
-    if(cachedBitmap)
-    FreeImage_Unload(cachedBitmap);
-    cachedBitmap = NULL;
 };
 
 void TextureExportDialog::disableTransparencyItems()
@@ -494,11 +496,10 @@ int TextureExportDialog::exec()
         QFileInfo fileInfo(filename);
         lastImageExportDir = fileInfo.absolutePath();
 
+        previewCache.clear();
+        previewCacheOrder.clear();
         prepareFreeImageBitmap();
-
-        if(cachedBitmap)
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
+        cachedBpp = 0;
 
         if(selectedFilter == bitmapFilter)
         {
@@ -531,10 +532,7 @@ int TextureExportDialog::exec()
         else if(selectedFilter == jpegFilter)
         {
             pages->setCurrentWidget(jpegPage);
-            cachedBitmap = FreeImage_ConvertTo24Bits(textureBitmap);
-            if(jpegMagicPink->checkState() == Qt::Checked && transEnabled)
-            updateJpegMagicPink(Qt::Checked);
-            else updateJpegPreview(); //updateJpegMagicPink updates the preview, so we only need to do it if not using magic pink.
+            updateJpegMagicPink((jpegMagicPink->checkState() == Qt::Checked && transEnabled) ? Qt::Checked : Qt::Unchecked);
         }
         else if(selectedFilter == gifFilter)
         {
@@ -599,12 +597,13 @@ void TextureExportDialog::saveTexture()
 
     bool success = false;
     QFileInfo file(filename);
+    FIBITMAP* saveBitmap = getConvertedTexture(textureBitmap, cachedBpp, cachedMagicPink);
 
     if(selectedFilter == bitmapFilter)
     {
         if(addExtension && file.suffix().isEmpty())
             filename += ".bmp";
-        success = FreeImage_Save(FIF_BMP, cachedBitmap, filename.toLocal8Bit().data(), (bmpCompress->checkState() == Qt::Checked ? BMP_SAVE_RLE : 0));
+        success = FreeImage_Save(FIF_BMP, saveBitmap, filename.toLocal8Bit().data(), (bmpCompress->checkState() == Qt::Checked ? BMP_SAVE_RLE : 0));
     }
     else if(selectedFilter == pngFilter)
     {
@@ -626,13 +625,13 @@ void TextureExportDialog::saveTexture()
                 compression = PNG_Z_NO_COMPRESSION;
                 break;
         }
-        success = FreeImage_Save(FIF_PNG, cachedBitmap, filename.toLocal8Bit().data(), (pngInterlaced->checkState() == Qt::Checked ? PNG_INTERLACED : 0)+compression);
+        success = FreeImage_Save(FIF_PNG, saveBitmap, filename.toLocal8Bit().data(), (pngInterlaced->checkState() == Qt::Checked ? PNG_INTERLACED : 0)+compression);
     }
     else if(selectedFilter == jpegFilter)
     {
         if(addExtension && file.suffix().isEmpty())
             filename += ".jpeg";
-        success = FreeImage_Save(FIF_JPEG, cachedBitmap, filename.toLocal8Bit().data(), jpegQuality->value() | JPEG_OPTIMIZE | (jpegProgressive->checkState() == Qt::Checked ? JPEG_PROGRESSIVE : 0));
+        success = FreeImage_Save(FIF_JPEG, saveBitmap, filename.toLocal8Bit().data(), jpegQuality->value() | JPEG_OPTIMIZE | (jpegProgressive->checkState() == Qt::Checked ? JPEG_PROGRESSIVE : 0));
     }
     else if(selectedFilter == gifFilter)
     {
@@ -664,15 +663,18 @@ void TextureExportDialog::saveTexture()
                 compression = TIFF_NONE;
                 break;
         }
-        success = FreeImage_Save(FIF_TIFF, cachedBitmap, filename.toLocal8Bit().data(), compression);
+        success = FreeImage_Save(FIF_TIFF, saveBitmap, filename.toLocal8Bit().data(), compression);
     }
     else if(selectedFilter == targaFilter)
     {
         if(addExtension && file.suffix().isEmpty())
             filename += ".tga";
-        success = FreeImage_Save(FIF_TARGA, cachedBitmap, filename.toLocal8Bit().data(), (tgaCompress->checkState() == Qt::Checked ? TARGA_SAVE_RLE : 0));
+        success = FreeImage_Save(FIF_TARGA, saveBitmap, filename.toLocal8Bit().data(), (tgaCompress->checkState() == Qt::Checked ? TARGA_SAVE_RLE : 0));
     }
 
+    if(saveBitmap)
+    FreeImage_Unload(saveBitmap);
+
     if(!success)
     {
         QMessageBox msgBox(this);
@@ -803,7 +805,21 @@ void TextureExportDialog::applyMagicPink(FIBITMAP* bitmap)
 {
     if(bitmap)
     {
-        if(FreeImage_GetBPP(bitmap) == 24)
+        if(FreeImage_GetBPP(bitmap) == 8)
+        {
+            //Paletted bitmaps keep their indices, so the transparent palette entries are changed instead.
+            RGBQUAD* pal = FreeImage_GetPalette(bitmap);
+            for(int i = 0; i < 256; i++)
+            {
+                if(pal[i].rgbRed == 8 && pal[i].rgbGreen == 8 && pal[i].rgbBlue == 8)
+                {
+                    pal[i].rgbRed = 255;
+                    pal[i].rgbGreen = 0;
+                    pal[i].rgbBlue = 255;
+                }
+            }
+        }
+        else if(FreeImage_GetBPP(bitmap) == 24)
         {
             for(int y = 0; y < 256; y++)
             {
@@ -823,71 +839,173 @@ void TextureExportDialog::applyMagicPink(FIBITMAP* bitmap)
     }
 };
 
-void TextureExportDialog::updatePreviewImage(FIBITMAP* bitmap)
+QImage PreviewEncodeTask::convertImage(FIBITMAP* bitmap)
 {
-    QImage* tempImage;
-    QPixmap tempPixmap;
+    QImage image;
     RGBQUAD *pal;
 
     switch(FreeImage_GetBPP(bitmap))
     {
         case 8:
-            tempImage = new QImage(FreeImage_GetBits(bitmap),FreeImage_GetWidth(bitmap),FreeImage_GetHeight(bitmap),FreeImage_GetPitch(bitmap),QImage::Format_Indexed8);
+        {
+            QImage tempImage(FreeImage_GetBits(bitmap),FreeImage_GetWidth(bitmap),FreeImage_GetHeight(bitmap),FreeImage_GetPitch(bitmap),QImage::Format_Indexed8);
             pal = FreeImage_GetPalette(bitmap);
             for (int i = 0; i < 256; i++)
             {
-                tempImage->setColor(i,qRgb(pal[i].rgbRed,pal[i].rgbGreen,pal[i].rgbBlue));
+                tempImage.setColor(i,qRgb(pal[i].rgbRed,pal[i].rgbGreen,pal[i].rgbBlue));
             }
-            tempPixmap.convertFromImage(tempImage->mirrored(false,true));
-            imagePreview->setPixmap(tempPixmap);
-            delete tempImage;
+            image = tempImage.mirrored(false,true);
             break;
+        }
         case 16:
-            tempImage = new QImage(FreeImage_GetBits(bitmap),FreeImage_GetWidth(bitmap),FreeImage_GetHeight(bitmap),FreeImage_GetPitch(bitmap),QImage::Format_RGB555);
-            tempPixmap.convertFromImage(tempImage->mirrored(false,true));
-            imagePreview->setPixmap(tempPixmap);
-            delete tempImage;
+            image = QImage(FreeImage_GetBits(bitmap),FreeImage_GetWidth(bitmap),FreeImage_GetHeight(bitmap),FreeImage_GetPitch(bitmap),QImage::Format_RGB555).mirrored(false,true);
             break;
         case 24:
-            tempImage = new QImage(FreeImage_GetBits(bitmap),FreeImage_GetWidth(bitmap),FreeImage_GetHeight(bitmap),FreeImage_GetPitch(bitmap),QImage::Format_RGB888);
-            tempPixmap.convertFromImage(tempImage->rgbSwapped().mirrored(false,true));
-            imagePreview->setPixmap(tempPixmap);
-            delete tempImage;
+            image = QImage(FreeImage_GetBits(bitmap),FreeImage_GetWidth(bitmap),FreeImage_GetHeight(bitmap),FreeImage_GetPitch(bitmap),QImage::Format_RGB888).rgbSwapped().mirrored(false,true);
             break;
         case 32:
-            tempImage = new QImage(FreeImage_GetBits(bitmap),FreeImage_GetWidth(bitmap),FreeImage_GetHeight(bitmap),FreeImage_GetPitch(bitmap),QImage::Format_ARGB32);
-            tempPixmap.convertFromImage(tempImage->mirrored(false,true));
-            imagePreview->setPixmap(tempPixmap);
-            delete tempImage;
+            image = QImage(FreeImage_GetBits(bitmap),FreeImage_GetWidth(bitmap),FreeImage_GetHeight(bitmap),FreeImage_GetPitch(bitmap),QImage::Format_ARGB32).mirrored(false,true);
             break;
     };
+    return image;
+};
+
+PreviewEncodeTask::PreviewEncodeTask(QObject* resultReceiver, FIBITMAP* bitmap, int bpp, bool magicPink, FREE_IMAGE_FORMAT format, int saveFlags, int loadFlags, int requestId, const QByteArray& cacheKey)
+{
+    receiver = resultReceiver;
+    source = FreeImage_Clone(bitmap);
+    convertBpp = bpp;
+    convertMagicPink = magicPink;
+    fif = format;
+    saveOptions = saveFlags;
+    loadOptions = loadFlags;
+    request = requestId;
+    key = cacheKey;
+};
+
+PreviewEncodeTask::~PreviewEncodeTask()
+{
+    if(source)
+    FreeImage_Unload(source);
+};
+
+void PreviewEncodeTask::run()
+{
+    QImage image;
+    int size = -1;
+
+    FIBITMAP* converted = NULL;
+    if(source)
+    converted = TextureExportDialog::getConvertedTexture(source, convertBpp, convertMagicPink);
+
+    FreeImageMemFile memFile;
+    if(converted && FreeImage_SaveToHandle(fif, converted, memFile.getIOPointer(), memFile.getHandle(), saveOptions))
+    {
+        memFile.seekMemory(0,SEEK_SET);
+        FIBITMAP* preview = FreeImage_LoadFromHandle(fif, memFile.getIOPointer(), memFile.getHandle(), loadOptions);
+
+        memFile.seekMemory(0,SEEK_END);
+        size = memFile.tellMemory();
+
+        if(preview)
+        {
+            image = convertImage(preview);
+            FreeImage_Unload(preview);
+        }
+    }
+
+    if(converted)
+    FreeImage_Unload(converted);
+
+    QMetaObject::invokeMethod(receiver, "previewEncoded", Qt::QueuedConnection, Q_ARG(int, request), Q_ARG(QImage, image), Q_ARG(int, size), Q_ARG(QByteArray, key));
+};
+
+void TextureExportDialog::requestPreview(FREE_IMAGE_FORMAT fif, int saveFlags, int loadFlags)
+{
+    if(!textureBitmap || !cachedBpp)
+    return;
+
+    QByteArray key = QByteArray::number(textureIndex) + ":" + QByteArray::number(paletteIndex) + ":" + QByteArray::number(cachedBpp) + ":" + QByteArray::number(cachedMagicPink ? 1 : 0) + ":";
+    key += QByteArray::number((int)fif) + ":" + QByteArray::number(saveFlags) + ":" + QByteArray::number(loadFlags);
+
+    //Anything still waiting is stale, results of tasks already running are ignored but still cached.
+    previewRequest++;
+    previewPool.clear();
+
+    if(previewCache.contains(key))
+    {
+        previewCacheOrder.removeOne(key);
+        previewCacheOrder.append(key);
+
+        const PreviewResult& result = previewCache[key];
+        setPreviewSize(result.size);
+        imagePreview->setPixmap(QPixmap::fromImage(result.image));
+        return;
+    }
+
+    imageSize->setText(tr("Encoding preview..."));
+    previewPool.start(new PreviewEncodeTask(this, textureBitmap, cachedBpp, cachedMagicPink, fif, saveFlags, loadFlags, previewRequest, key));
 };
 
-FIBITMAP* TextureExportDialog::getConvertedTexture(int bpp, bool magicPink)
+void TextureExportDialog::previewEncoded(int request, QImage image, int size, QByteArray key)
+{
+    if(image.isNull())
+    {
+        if(request == previewRequest)
+        setPreviewSize(-1);
+        return;
+    }
+
+    if(!previewCache.contains(key))
+    {
+        while(previewCache.size() >= PREVIEW_CACHE_SIZE && !previewCacheOrder.isEmpty())
+        previewCache.remove(previewCacheOrder.takeFirst());
+
+        PreviewResult result;
+        result.image = image;
+        result.size = size;
+        previewCache.insert(key, result);
+        previewCacheOrder.append(key);
+    }
+
+    if(request == previewRequest)
+    {
+        setPreviewSize(size);
+        imagePreview->setPixmap(QPixmap::fromImage(image));
+    }
+};
+
+void TextureExportDialog::setConversion(int bpp, bool magicPink)
+{
+    cachedBpp = bpp;
+    cachedMagicPink = magicPink;
+};
+
+FIBITMAP* TextureExportDialog::getConvertedTexture(FIBITMAP* source, int bpp, bool magicPink)
 {
     FIBITMAP* temp = NULL;
-    if(textureBitmap)
+    if(source)
     {
         if(bpp == 8)
         {
-            if(FreeImage_GetBPP(textureBitmap) == 8)
+            if(FreeImage_GetBPP(source) == 8)
             {
-                temp = FreeImage_Clone(textureBitmap);
+                temp = FreeImage_Clone(source);
             }
             else
             {
-                FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(textureBitmap);
+                FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(source);
 
                 if(magicPink)
                 applyMagicPink(temp24);
 
-                temp = FreeImage_ColorQuantize(temp24,FIQ_NNQUANT);
+                temp = quantizeImage(temp24, NULL);
                 FreeImage_Unload(temp24);
             }
         }
         else if(bpp == 15)
         {
-            FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(textureBitmap);
+            FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(source);
 
             if(magicPink)
             applyMagicPink(temp24);
@@ -897,17 +1015,17 @@ FIBITMAP* TextureExportDialog::getConvertedTexture(int bpp, bool magicPink)
         }
         else if(bpp == 24)
         {
-            temp = FreeImage_ConvertTo24Bits(textureBitmap);
+            temp = FreeImage_ConvertTo24Bits(source);
             if(magicPink)
             applyMagicPink(temp);
         }
         else if(bpp == 32)
         {
-            temp = FreeImage_ConvertTo32Bits(textureBitmap);
+            temp = FreeImage_ConvertTo32Bits(source);
 
             if(magicPink)
             {
-                FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(textureBitmap);
+                FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(source);
                 for(int y = 0; y < 256; y++)
                 {
                     unsigned char* bits24 = FreeImage_GetScanLine(temp24,255-y);
@@ -935,26 +1053,14 @@ FIBITMAP* TextureExportDialog::getConvertedTexture(int bpp, bool magicPink)
 
 void TextureExportDialog::updateBmpPreview()
 {
-    if(cachedBitmap)
+    if(cachedBpp)
     {
-        previewMemFile.reset();
         int flags = 0;
 
         if(bmpCompress->checkState() == Qt::Checked && bmpPaletted->isChecked())
         flags = BMP_SAVE_RLE;
 
-        if(FreeImage_SaveToHandle(FIF_BMP, cachedBitmap, previewMemFile.getIOPointer(), previewMemFile.getHandle(), flags))
-        {
-            previewMemFile.seekMemory(0,SEEK_SET);
-            FIBITMAP* preview = FreeImage_LoadFromHandle(FIF_BMP, previewMemFile.getIOPointer(), previewMemFile.getHandle(), 0);
-
-            previewMemFile.seekMemory(0,SEEK_END);
-            setPreviewSize(previewMemFile.tellMemory());
-
-            updatePreviewImage(preview);
-
-            FreeImage_Unload(preview);
-        }
+        requestPreview(FIF_BMP, flags);
     }
 };
 
@@ -962,15 +1068,10 @@ void TextureExportDialog::selectBmpTruecolor()
 {
     bmpCompress->setEnabled(false);
 
-    if(cachedBitmap && FreeImage_GetBPP(cachedBitmap) == 24)
+    if(cachedBpp == 24)
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-    cachedBitmap = getConvertedTexture(24, (bmpMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
+    setConversion(24, (bmpMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
 
     updateBmpPreview();
 };
@@ -979,29 +1080,18 @@ void TextureExportDialog::selectBmpPaletted()
 {
     bmpCompress->setEnabled(true);
 
-    if(cachedBitmap && FreeImage_GetBPP(cachedBitmap) == 8)
+    if(cachedBpp == 8)
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-    cachedBitmap = getConvertedTexture(8, (bmpMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
+    setConversion(8, (bmpMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
     updateBmpPreview();
 };
 
 void TextureExportDialog::updateBmpMagicPink(int state)
 {
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-
     if(bmpTruecolor->isChecked())
-    cachedBitmap = getConvertedTexture(24, (state == Qt::Checked ? true : false));
-    else cachedBitmap = getConvertedTexture(8, (state == Qt::Checked ? true : false));
+    setConversion(24, (state == Qt::Checked ? true : false));
+    else setConversion(8, (state == Qt::Checked ? true : false));
 
     updateBmpPreview();
 };
@@ -1010,7 +1100,7 @@ void TextureExportDialog::updateBmpMagicPink(int state)
 
 void TextureExportDialog::updatePngPreview()
 {
-    if(cachedBitmap)
+    if(cachedBpp)
     {
         int compression = 0;
         switch(pngCompression->currentIndex())
@@ -1029,18 +1119,7 @@ void TextureExportDialog::updatePngPreview()
                 break;
         }
 
-        previewMemFile.reset();
-        if(FreeImage_SaveToHandle(FIF_PNG, cachedBitmap, previewMemFile.getIOPointer(), previewMemFile.getHandle(), (pngInterlaced->checkState() == Qt::Checked ? PNG_INTERLACED : 0)+compression))
-        {
-            previewMemFile.seekMemory(0,SEEK_SET);
-            FIBITMAP* preview = FreeImage_LoadFromHandle(FIF_PNG, previewMemFile.getIOPointer(), previewMemFile.getHandle(), 0);
-
-            previewMemFile.seekMemory(0,SEEK_END);
-            setPreviewSize(previewMemFile.tellMemory());
-
-            updatePreviewImage(preview);
-            FreeImage_Unload(preview);
-        }
+        requestPreview(FIF_PNG, (pngInterlaced->checkState() == Qt::Checked ? PNG_INTERLACED : 0)+compression);
     }
 };
 
@@ -1049,15 +1128,10 @@ void TextureExportDialog::selectPngPaletted()
     pngExportWithTransparency->setEnabled(false);
     pngMagicPink->setEnabled(true);
 
-    if(cachedBitmap && FreeImage_GetBPP(cachedBitmap) == 8)
+    if(cachedBpp == 8)
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-    cachedBitmap = getConvertedTexture(8, (pngMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
+    setConversion(8, (pngMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
     updatePngPreview();
 };
 
@@ -1065,41 +1139,32 @@ void TextureExportDialog::selectPngTruecolor()
 {
     pngExportWithTransparency->setEnabled(true);
 
-    if(cachedBitmap && ((FreeImage_GetBPP(cachedBitmap) == 24 && pngExportWithTransparency->checkState() != Qt::Checked) || (FreeImage_GetBPP(cachedBitmap) == 32 && pngExportWithTransparency->checkState() == Qt::Checked)))
+    if((cachedBpp == 24 && pngExportWithTransparency->checkState() != Qt::Checked) || (cachedBpp == 32 && pngExportWithTransparency->checkState() == Qt::Checked))
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
     if(transEnabled)
     {
         if(pngExportWithTransparency->checkState() == Qt::Checked)
         {
             pngMagicPink->setEnabled(false);
-            cachedBitmap = getConvertedTexture(32, true);
+            setConversion(32, true);
         }
         else
         {
             pngMagicPink->setEnabled(true);
-            cachedBitmap = getConvertedTexture(24, (pngMagicPink->checkState() == Qt::Checked ? true : false));
+            setConversion(24, (pngMagicPink->checkState() == Qt::Checked ? true : false));
         }
     }
     else
     {
-        cachedBitmap = getConvertedTexture(24, false);
+        setConversion(24, false);
     }
     updatePngPreview();
 };
 
 void TextureExportDialog::forcePngUpdate()
 {
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
+    cachedBpp = 0;
     if(pngTruecolor->isChecked())
     selectPngTruecolor();
     else selectPngPaletted();
@@ -1117,36 +1182,16 @@ void TextureExportDialog::setPng32Bit(int state)
 
 void TextureExportDialog::updateJpegMagicPink(int state)
 {
-    if(state == Qt::Checked && cachedBitmap)
-    {
-        applyMagicPink(cachedBitmap);
-    }
-    else
-    {
-        if(cachedBitmap)
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = getConvertedTexture(24,false);
-    }
+    setConversion(24, (state == Qt::Checked ? true : false));
     updateJpegPreview();
 };
 
 void TextureExportDialog::updateJpegPreview()
 {
-    if(cachedBitmap)
+    if(cachedBpp)
     {
         int quality = jpegQuality->value();
-        previewMemFile.reset();
-        if(FreeImage_SaveToHandle(FIF_JPEG, cachedBitmap, previewMemFile.getIOPointer(), previewMemFile.getHandle(), quality | (jpegProgressive->checkState() == Qt::Checked ? JPEG_PROGRESSIVE : 0)))
-        {
-            previewMemFile.seekMemory(0,SEEK_SET);
-            FIBITMAP* preview = FreeImage_LoadFromHandle(FIF_JPEG, previewMemFile.getIOPointer(), previewMemFile.getHandle(), JPEG_ACCURATE);
-
-            previewMemFile.seekMemory(0,SEEK_END);
-            setPreviewSize(previewMemFile.tellMemory());
-
-            updatePreviewImage(preview);
-            FreeImage_Unload(preview);
-        }
+        requestPreview(FIF_JPEG, quality | (jpegProgressive->checkState() == Qt::Checked ? JPEG_PROGRESSIVE : 0), JPEG_ACCURATE);
     }
 };
 
@@ -1187,7 +1232,7 @@ void TextureExportDialog::updateGifPreview()
 
 void TextureExportDialog::updateTiffPreview()
 {
-    if(cachedBitmap)
+    if(cachedBpp)
     {
         int compression = 0;
         switch(tiffCompression->currentIndex())
@@ -1209,56 +1254,31 @@ void TextureExportDialog::updateTiffPreview()
                 break;
         }
 
-        previewMemFile.reset();
-        if(FreeImage_SaveToHandle(FIF_TIFF, cachedBitmap, previewMemFile.getIOPointer(), previewMemFile.getHandle(), compression))
-        {
-            previewMemFile.seekMemory(0,SEEK_SET);
-            FIBITMAP* preview = FreeImage_LoadFromHandle(FIF_TIFF, previewMemFile.getIOPointer(), previewMemFile.getHandle(), 0);
-
-            previewMemFile.seekMemory(0,SEEK_END);
-            setPreviewSize(previewMemFile.tellMemory());
-
-            updatePreviewImage(preview);
-            FreeImage_Unload(preview);
-        }
+        requestPreview(FIF_TIFF, compression);
     }
 };
 
 void TextureExportDialog::selectTiffPaletted()
 {
-    if(cachedBitmap && FreeImage_GetBPP(cachedBitmap) == 8)
+    if(cachedBpp == 8)
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-    cachedBitmap = getConvertedTexture(8, (tiffMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
+    setConversion(8, (tiffMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
     updateTiffPreview();
 };
 
 void TextureExportDialog::selectTiffTruecolor()
 {
-    if(cachedBitmap && FreeImage_GetBPP(cachedBitmap) == 24)
+    if(cachedBpp == 24)
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-    cachedBitmap = getConvertedTexture(24, (tiffMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
+    setConversion(24, (tiffMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
     updateTiffPreview();
 };
 
 void TextureExportDialog::forceTiffUpdate()
 {
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
+    cachedBpp = 0;
     if(tiffTruecolor->isChecked())
     selectTiffTruecolor();
     else selectTiffPaletted();
@@ -1270,15 +1290,10 @@ void TextureExportDialog::selectTgaPaletted()
 {
     tgaMagicPink->setEnabled(true);
 
-    if(cachedBitmap && FreeImage_GetBPP(cachedBitmap) == 8)
+    if(cachedBpp == 8)
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-    cachedBitmap = getConvertedTexture(8, (tgaMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
+    setConversion(8, (tgaMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
     updateTgaPreview();
 };
 
@@ -1287,15 +1302,10 @@ void TextureExportDialog::selectTgaHighcolor()
     tgaMagicPink->setEnabled(true);
     tgaLastDepth = 15;
 
-    if(cachedBitmap && FreeImage_GetBPP(cachedBitmap) == 16)
+    if(cachedBpp == 15)
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-    cachedBitmap = getConvertedTexture(15, (tgaMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
+    setConversion(15, (tgaMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
     updateTgaPreview();
 };
 
@@ -1304,15 +1314,10 @@ void TextureExportDialog::selectTgaTruecolor24()
     tgaMagicPink->setEnabled(true);
     tgaLastDepth = 24;
 
-    if(cachedBitmap && FreeImage_GetBPP(cachedBitmap) == 24)
+    if(cachedBpp == 24)
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-    cachedBitmap = getConvertedTexture(24, (tgaMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
+    setConversion(24, (tgaMagicPink->checkState() == Qt::Checked ? true : false) && transEnabled);
     updateTgaPreview();
 };
 
@@ -1321,44 +1326,24 @@ void TextureExportDialog::selectTgaTruecolor32()
     tgaMagicPink->setEnabled(false);
     tgaLastDepth = 32;
 
-    if(cachedBitmap && FreeImage_GetBPP(cachedBitmap) == 32)
+    if(cachedBpp == 32)
     return;
 
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
-    cachedBitmap = getConvertedTexture(32, transEnabled);
+    setConversion(32, transEnabled);
     updateTgaPreview();
 };
 
 void TextureExportDialog::updateTgaPreview()
 {
-    if(cachedBitmap)
+    if(cachedBpp)
     {
-        previewMemFile.reset();
-        if(FreeImage_SaveToHandle(FIF_TARGA, cachedBitmap, previewMemFile.getIOPointer(), previewMemFile.getHandle(), (tgaCompress->checkState() == Qt::Checked ? TARGA_SAVE_RLE : 0)))
-        {
-            previewMemFile.seekMemory(0,SEEK_SET);
-            FIBITMAP* preview = FreeImage_LoadFromHandle(FIF_TARGA, previewMemFile.getIOPointer(), previewMemFile.getHandle(), 0);
-
-            previewMemFile.seekMemory(0,SEEK_END);
-            setPreviewSize(previewMemFile.tellMemory());
-
-            updatePreviewImage(preview);
-            FreeImage_Unload(preview);
-        }
+        requestPreview(FIF_TARGA, (tgaCompress->checkState() == Qt::Checked ? TARGA_SAVE_RLE : 0));
     }
 };
 
 void TextureExportDialog::forceTgaUpdate()
 {
-    if(cachedBitmap)
-    {
-        FreeImage_Unload(cachedBitmap);
-        cachedBitmap = NULL;
-    }
+    cachedBpp = 0;
 
     if(tgaHighcolor15->isChecked())
     selectTgaHighcolor();
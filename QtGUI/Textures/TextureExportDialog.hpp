@@ -5,6 +5,7 @@
 #include <FreeImage.h>
 #include "../../Driver_Routines/driver_levels.hpp"
 #include "../../Driver_Routines/driver_d3d.hpp"
+#include "../../Driver_Routines/DriverLevels/imageQuantizer.hpp"
 
 //TODO: Implement definitions exporting/importing.
 
@@ -43,6 +44,36 @@ class FreeImageMemFile
         FreeImageIO ioStruct;
 };
 
+const int PREVIEW_CACHE_SIZE = 32;
+
+//Converts a copy of the bitmap to the export depth, then encodes it to memory and decodes it again, so the preview shows what the saved file will look like.
+class PreviewEncodeTask : public QRunnable
+{
+    public:
+        PreviewEncodeTask(QObject* resultReceiver, FIBITMAP* bitmap, int bpp, bool magicPink, FREE_IMAGE_FORMAT format, int saveFlags, int loadFlags, int requestId, const QByteArray& cacheKey);
+        ~PreviewEncodeTask();
+        void run();
+
+        static QImage convertImage(FIBITMAP* bitmap);
+
+    protected:
+        QObject* receiver;
+        FIBITMAP* source;
+        int convertBpp;
+        bool convertMagicPink;
+        FREE_IMAGE_FORMAT fif;
+        int saveOptions;
+        int loadOptions;
+        int request;
+        QByteArray key;
+};
+
+struct PreviewResult
+{
+    QImage image;
+    int size;
+};
+
 class TextureExportDialog : public QDialog
 {
     Q_OBJECT
@@ -55,6 +86,10 @@ class TextureExportDialog : public QDialog
         void setLevel(DriverLevel* lev);
         void setD3D(DriverD3D* newD3D);
 
+        //Replaces the transparent colour of a 24 bit texture bitmap, or of an 8 bit one's palette, with magic pink.
+        static void applyMagicPink(FIBITMAP* bitmap);
+        static FIBITMAP* getConvertedTexture(FIBITMAP* source, int bpp, bool magicPink);
+
     public slots:
         int exec();
         void loadSettings();
@@ -91,12 +126,13 @@ class TextureExportDialog : public QDialog
         void selectTgaTruecolor32();
         void forceTgaUpdate();
 
+        void previewEncoded(int request, QImage image, int size, QByteArray key);
+
     protected:
-        void applyMagicPink(FIBITMAP* bitmap);
         void prepareFreeImageBitmap();
         void setPreviewSize(int size);
-        void updatePreviewImage(FIBITMAP* bitmap);
-        FIBITMAP* getConvertedTexture(int bpp, bool magicPink);
+        void requestPreview(FREE_IMAGE_FORMAT fif, int saveFlags, int loadFlags = 0);
+        void setConversion(int bpp, bool magicPink);
 
         void rebuildBmpCachedBitmap(bool paletted = false);
         void disableTransparencyItems();
@@ -110,8 +146,13 @@ class TextureExportDialog : public QDialog
         bool transEnabled;
         bool addExtension;
         FIBITMAP* textureBitmap;
-        FIBITMAP* cachedBitmap; //For storing a copy of the bitmap to be saved in the format to save in. (ex. jpeg saves in 24-bit)
-        FreeImageMemFile previewMemFile;
+        int cachedBpp; //Depth the texture is converted to when saved and previewed, 0 if none is selected. (ex. jpeg saves in 24-bit)
+        bool cachedMagicPink;
+
+        QThreadPool previewPool;
+        int previewRequest;
+        QHash<QByteArray, PreviewResult> previewCache;
+        QList<QByteArray> previewCacheOrder; //Least recently used first
 
         QStackedLayout* pages;
         QLabel* imagePreview;
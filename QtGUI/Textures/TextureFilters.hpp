@@ -0,0 +1,31 @@
+#ifndef TEXTURE_FILTERS_HPP
+#define TEXTURE_FILTERS_HPP
+
+#include "../../Driver_Routines/DriverLevels/textures.hpp"
+
+const int FILTER_ALL_TEXTURES = 0;
+const int FILTER_CAR_TEXTURES = 1;
+const int FILTER_PALETTED_TEXTURES = 2;
+const int FILTER_15_BIT_TEXTURES = 3;
+const int FILTER_TRANSPARENT_TEXTURES = 4;
+
+inline bool textureMatchesFilter(const DriverTexture* tex, int filter)
+{
+    if(!tex)
+    return false;
+
+    switch(filter)
+    {
+        case FILTER_CAR_TEXTURES:
+            return tex->getCarNumber() != -1 && (tex->isCleanTexture() || tex->isDamageTexture());
+        case FILTER_PALETTED_TEXTURES:
+            return tex->usesPalette();
+        case FILTER_15_BIT_TEXTURES:
+            return !tex->usesPalette();
+        case FILTER_TRANSPARENT_TEXTURES:
+            return tex->hasTransparency();
+    }
+    return true;
+};
+
+#endif
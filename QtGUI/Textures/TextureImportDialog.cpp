@@ -15,6 +15,16 @@ TextureImportDialog::TextureImportDialog(QWidget* parent) : QDialog(parent)
     useMagicPink = new QRadioButton(tr("Use magic pink"), this);
     useAlpha = new QRadioButton(tr("Use alpha channel"), this);
 
+    //Grouped so they are not exclusive with the transparency options.
+    paletteLabel = new QLabel(tr("Palette:"),this);
+    useNewPalette = new QRadioButton(tr("Create a new palette"), this);
+    useCurrentPalette = new QRadioButton(tr("Map colors to the current palette"), this);
+    paletteGroup = new QButtonGroup(this);
+    paletteGroup->addButton(useNewPalette);
+    paletteGroup->addButton(useCurrentPalette);
+    useNewPalette->setChecked(true);
+    useDither = new QCheckBox(tr("Dither"), this);
+
     imagePreview = new QLabel(this);
     QPixmap tempImage(256,256);
     tempImage.fill(Qt::black);
@@ -30,7 +40,12 @@ TextureImportDialog::TextureImportDialog(QWidget* parent) : QDialog(parent)
     optionsLayout->addWidget(transLabel,0,Qt::AlignTop);
     optionsLayout->addWidget(useDefaultColor,0,Qt::AlignTop);
     optionsLayout->addWidget(useMagicPink,0,Qt::AlignTop);
-    optionsLayout->addWidget(useAlpha,1,Qt::AlignTop);
+    optionsLayout->addWidget(useAlpha,0,Qt::AlignTop);
+    optionsLayout->addWidget(paletteLabel,0,Qt::AlignTop);
+    optionsLayout->addWidget(useNewPalette,0,Qt::AlignTop);
+    optionsLayout->addWidget(useCurrentPalette,0,Qt::AlignTop);
+    optionsLayout->addWidget(useDither,0,Qt::AlignTop);
+    optionsLayout->addStretch(1);
 
     QHBoxLayout* fullLayout = new QHBoxLayout();
     fullLayout->addLayout(optionsLayout);
@@ -96,6 +111,10 @@ void TextureImportDialog::loadSettings()
 
     lastNon32BitState = settings.value("TextureImportDialog/useMagicPink",0).toInt();
     prefered32BitState = settings.value("TextureImportDialog/preferred32Bit",2).toInt();
+    if(settings.value("TextureImportDialog/mapToPalette",false).toBool())
+    useCurrentPalette->setChecked(true);
+    else useNewPalette->setChecked(true);
+    useDither->setCheckState((settings.value("TextureImportDialog/dither",true).toBool() ? Qt::Checked : Qt::Unchecked));
 
     lastImageImportDir = settings.value("directories/lastImageImportDir").toString();
 };
@@ -107,6 +126,8 @@ void TextureImportDialog::saveSettings()
 
     settings.setValue("TextureImportDialog/useMagicPink", lastNon32BitState);
     settings.setValue("TextureImportDialog/preferred32Bit", prefered32BitState);
+    settings.setValue("TextureImportDialog/mapToPalette", useCurrentPalette->isChecked());
+    settings.setValue("TextureImportDialog/dither", (useDither->checkState() == Qt::Checked ? true : false));
 
     settings.setValue("directories/lastImageImportDir", lastImageImportDir);
 };
@@ -133,13 +154,7 @@ int TextureImportDialog::exec()
                 FreeImage_Unload(bitmap);
                 bitmap = NULL;
 
-                FREE_IMAGE_FORMAT fif = FIF_UNKNOWN;
-                fif = FreeImage_GetFileType(filename.toLocal8Bit().data(), 0);
-                if(fif == FIF_UNKNOWN)
-                fif = FreeImage_GetFIFFromFilename(filename.toLocal8Bit().data());
-
-                if((fif != FIF_UNKNOWN) && FreeImage_FIFSupportsReading(fif))
-                bitmap = FreeImage_Load(fif, filename.toLocal8Bit().data(), (fif == FIF_JPEG ? JPEG_ACCURATE : 0));
+                bitmap = loadImage(filename);
 
                 if(bitmap)
                 {
@@ -153,9 +168,18 @@ int TextureImportDialog::exec()
                         msgBox.exec();
                         return QDialog::Rejected;
                     }
-                    if(tex->hasTransparency() && !tex->usesPalette())
+                    if(tex->usesPalette() && getCurrentPalette())
+                    {
+                        setPreview(bitmap);
+                        showTransparencyOptions(false);
+                        showPaletteOptions(true);
+                        return QDialog::exec();
+                    }
+                    else if(tex->hasTransparency() && !tex->usesPalette())
                     {
                         setPreview(bitmap);
+                        showTransparencyOptions(true);
+                        showPaletteOptions(false);
 
                         if(FreeImage_GetBPP(bitmap) != 32)
                         {
@@ -210,6 +234,37 @@ void TextureImportDialog::setPreview(FIBITMAP* dib)
     FreeImage_Unload(bmp);
 };
 
+void TextureImportDialog::showTransparencyOptions(bool show)
+{
+    transLabel->setVisible(show);
+    useDefaultColor->setVisible(show);
+    useMagicPink->setVisible(show);
+    useAlpha->setVisible(show);
+};
+
+void TextureImportDialog::showPaletteOptions(bool show)
+{
+    paletteLabel->setVisible(show);
+    useNewPalette->setVisible(show);
+    useCurrentPalette->setVisible(show);
+    useDither->setVisible(show);
+};
+
+DriverPalette* TextureImportDialog::getCurrentPalette()
+{
+    if(!d3d || !textureBlock)
+    return NULL;
+
+    D3DEntry* entry = d3d->getTextureEntry(textureIndex);
+    if(!entry)
+    return NULL;
+
+    int slot = entry->getPaletteIndex(paletteIndex);
+    if(slot < 0)
+    return NULL;
+    return textureBlock->getIndexedPalette(slot);
+};
+
 void TextureImportDialog::selectDefault()
 {
     if(FreeImage_GetBPP(bitmap) == 32)
@@ -229,125 +284,190 @@ void TextureImportDialog::selectAlpha()
     prefered32BitState = 2;
 };
 
-void TextureImportDialog::importImage()
+FIBITMAP* TextureImportDialog::loadImage(const QString& file)
 {
-    if(textureBlock)
+    QByteArray name = file.toLocal8Bit();
+    FREE_IMAGE_FORMAT fif = FIF_UNKNOWN;
+    fif = FreeImage_GetFileType(name.data(), 0);
+    if(fif == FIF_UNKNOWN)
+    fif = FreeImage_GetFIFFromFilename(name.data());
+
+    if((fif != FIF_UNKNOWN) && FreeImage_FIFSupportsReading(fif))
+    return FreeImage_Load(fif, name.data(), (fif == FIF_JPEG ? JPEG_ACCURATE : 0));
+    return NULL;
+};
+
+void TextureImportDialog::copyIndices(FIBITMAP* dib8, unsigned char* indices)
+{
+    for(int i = 0; i < 256; i++)
     {
-        const DriverTexture* origTex = textureBlock->getTexture(textureIndex);
-        if(origTex)
+        memcpy(indices+i*256,FreeImage_GetScanLine(dib8,(255-i)),256);
+    }
+};
+
+bool TextureImportDialog::remapImage(FIBITMAP* dib, const DriverPalette* palette, int dither, unsigned char* indices)
+{
+    FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(dib);
+    if(!temp24)
+    return false;
+
+    PaletteRemapper remapper(palette);
+    remapper.setDither(dither);
+    for(int i = 0; i < 256; i++)
+    {
+        remapper.remapScanLine(FreeImage_GetScanLine(temp24,(255-i)), 3, FI_RGBA_RED, FI_RGBA_GREEN, FI_RGBA_BLUE, 256, i, indices+i*256);
+    }
+    FreeImage_Unload(temp24);
+    return true;
+};
+
+bool TextureImportDialog::convertTo15Bit(FIBITMAP* dib, bool transparent, int transparency, unsigned char* pixels)
+{
+    FIBITMAP* temp = FreeImage_ConvertTo16Bits555(dib);
+    if(!temp)
+    return false;
+
+    FIBITMAP* alpha = NULL;
+    if(transparent)
+    alpha = FreeImage_ConvertTo32Bits(dib);
+
+    for(int i = 0; i < 256; i++)
+    {
+        unsigned char* scanLine = FreeImage_GetScanLine(temp,(255-i));
+        if(alpha)
         {
-            DriverTexture tex = *origTex;
-            if(tex.usesPalette())
+            unsigned char* scanLineAlpha = FreeImage_GetScanLine(alpha,(255-i));
+            for(int j = 0; j < 256; j++)
             {
-                int paletteSlot = textureBlock->getNextOpenSlot();
-                if(d3d)
+                if(transparency == IMPORT_TRANSPARENCY_DEFAULT)
                 {
-                    D3DEntry* entry = d3d->getTextureEntry(textureIndex);
-                    if(!entry)
-                    {
-                        d3d->addEntry(textureIndex);
-                        entry = d3d->getTextureEntry(textureIndex);
-                    }
-
-                    int currentPalette = entry->getPaletteIndex(paletteIndex);
-
-                    if(currentPalette > -1)
-                    {
-                        int numReferences = 0;
-                        for(int i = 0; i < d3d->getNumEntries(); i++)
-                        {
-                            D3DEntry* tempEntry = d3d->getEntry(i);
-                            if(tempEntry)
-                            {
-                                for(int j = 0; j < tempEntry->getNumPaletteIndicies(); j++)
-                                {
-                                    if(tempEntry->getPaletteIndex(j) == currentPalette)
-                                    numReferences++;
-                                }
-                            }
-                        }
-                        if(numReferences == 1) //no other textures are using this palette slot
-                        paletteSlot = currentPalette;
-                    }
-                    entry->setPaletteIndex(paletteIndex, paletteSlot);
+                    if(scanLineAlpha[FI_RGBA_RED] == 8 && scanLineAlpha[FI_RGBA_GREEN] == 8 && scanLineAlpha[FI_RGBA_BLUE] == 8)
+                    *(unsigned short*)(scanLine+j*2) = 0b1000010000100001;
                 }
-
-                DriverPalette palette;
-                FIBITMAP* temp8 = NULL;
-                if(FreeImage_GetBPP(bitmap) == 8)
+                else if(transparency == IMPORT_TRANSPARENCY_MAGIC_PINK)
                 {
-                    temp8 = FreeImage_Clone(bitmap);
+                    if(scanLineAlpha[FI_RGBA_RED] == 255 && scanLineAlpha[FI_RGBA_GREEN] == 0 && scanLineAlpha[FI_RGBA_BLUE] == 255)
+                    *(unsigned short*)(scanLine+j*2) = 0b1000010000100001;
                 }
                 else
                 {
-                    FIBITMAP* temp24 = FreeImage_ConvertTo24Bits(bitmap);
-                    temp8 = FreeImage_ColorQuantize(temp24,FIQ_NNQUANT);
-                    FreeImage_Unload(temp24);
+                    if(scanLineAlpha[FI_RGBA_ALPHA] != 255)
+                    *(unsigned short*)(scanLine+j*2) = 0b1000010000100001;
                 }
+                scanLineAlpha += 4;
+            }
+        }
+        memcpy(pixels+i*512,scanLine,512);
+    }
+    if(alpha)
+        FreeImage_Unload(alpha);
+    FreeImage_Unload(temp);
+    return true;
+};
+
+int TextureImportDialog::assignPaletteSlot(DriverTextures* textures, DriverD3D* d3d, int textureIndex, int paletteIndex)
+{
+    int paletteSlot = textures->getNextOpenSlot();
+    if(d3d)
+    {
+        D3DEntry* entry = d3d->getTextureEntry(textureIndex);
+        int currentPalette = (entry ? entry->getPaletteIndex(paletteIndex) : -1);
+
+        if(currentPalette > -1)
+        {
+            if(d3d->getNumPaletteReferences(currentPalette) == 1) //no other textures are using this palette slot
+            paletteSlot = currentPalette;
+        }
+        setPaletteSlot(textures, d3d, textureIndex, paletteIndex, paletteSlot);
+    }
+    return paletteSlot;
+};
+
+void TextureImportDialog::setPaletteSlot(DriverTextures* textures, DriverD3D* d3d, int textureIndex, int paletteIndex, int slot)
+{
+    if(!d3d)
+    return;
+
+    D3DEntry* entry = d3d->getTextureEntry(textureIndex);
+    if(!entry)
+    {
+        d3d->addEntry(textureIndex);
+        entry = d3d->getTextureEntry(textureIndex);
+    }
+
+    //setPaletteIndex ignores positions past the end of the list, so new palettes are added instead.
+    if(paletteIndex < 0 || paletteIndex >= entry->getNumPaletteIndicies())
+    {
+        entry->addPaletteIndex(slot);
+        return;
+    }
+
+    int oldSlot = entry->getPaletteIndex(paletteIndex);
+    entry->setPaletteIndex(paletteIndex, slot);
+    if(oldSlot > -1 && oldSlot != slot && d3d->getNumPaletteReferences(oldSlot) == 0 && textures->getIndexedPalette(oldSlot))
+    textures->removeIndexedPalette(oldSlot);
+};
 
-                RGBQUAD *pal = FreeImage_GetPalette(temp8);
-                for (int i = 0; i < 256; i++)
+void TextureImportDialog::importImage()
+{
+    if(textureBlock)
+    {
+        const DriverTexture* origTex = textureBlock->getTexture(textureIndex);
+        if(origTex)
+        {
+            DriverTexture tex = *origTex;
+            DriverPalette* currentPalette = getCurrentPalette();
+            if(tex.usesPalette() && currentPalette && useCurrentPalette->isChecked())
+            {
+                //Keeps the palette slot, so other palettes of this texture stay valid variations of it.
+                unsigned char* indices = new unsigned char[256*256];
+                if(remapImage(bitmap, currentPalette, (useDither->checkState() == Qt::Checked ? IMPORT_DITHER_AMOUNT : 0), indices))
                 {
-                    palette.colors[i].r = pal[i].rgbRed;
-                    palette.colors[i].g = pal[i].rgbGreen;
-                    palette.colors[i].b = pal[i].rgbBlue;
+                    tex.setData(indices);
+                    textureBlock->setTexture(textureIndex, &tex);
+                    delete[] indices;
+                    emit accept();
                 }
-                palette.paletteNumber = paletteSlot;
+                else delete[] indices;
+            }
+            else if(tex.usesPalette())
+            {
+                DriverPalette palette;
+                FIBITMAP* temp8 = quantizeImage(bitmap, &palette);
+                if(!temp8)
+                return;
+
+                palette.paletteNumber = assignPaletteSlot(textureBlock, d3d, textureIndex, paletteIndex);
+                textureBlock->beginChanges();
                 textureBlock->setPaletteIndexed(&palette);
 
                 for(int i = 0; i < 256; i++)
                 {
                     tex.setScanLine(i,FreeImage_GetScanLine(temp8,(255-i)));
                 }
+                FreeImage_Unload(temp8);
 
                 textureBlock->setTexture(textureIndex, &tex);
+                textureBlock->commitChanges();
                 emit accept();
             }
             else
             {
-                FIBITMAP* temp = FreeImage_ConvertTo16Bits555(bitmap);
-
-                if(temp)
+                int transparency = IMPORT_TRANSPARENCY_ALPHA;
+                if(useDefaultColor->isChecked())
+                transparency = IMPORT_TRANSPARENCY_DEFAULT;
+                else if(useMagicPink->isChecked())
+                transparency = IMPORT_TRANSPARENCY_MAGIC_PINK;
+
+                unsigned char* pixels = new unsigned char[256*256*2];
+                if(convertTo15Bit(bitmap, tex.hasTransparency(), transparency, pixels))
                 {
-                    FIBITMAP* alpha = NULL;
-                    if(tex.hasTransparency())
-                    alpha = FreeImage_ConvertTo32Bits(bitmap);
-
-                    for(int i = 0; i < 256; i++)
-                    {
-                        unsigned char* scanLine = FreeImage_GetScanLine(temp,(255-i));
-                        if(tex.hasTransparency())
-                        {
-                            unsigned char* scanLineAlpha = FreeImage_GetScanLine(alpha,(255-i));
-                            for(int j = 0; j < 256; j++)
-                            {
-                                if(useDefaultColor->isChecked())
-                                {
-                                    if(scanLineAlpha[FI_RGBA_RED] == 8 && scanLineAlpha[FI_RGBA_GREEN] == 8 && scanLineAlpha[FI_RGBA_BLUE] == 8)
-                                    *(unsigned short*)(scanLine+j*2) = 0b1000010000100001;
-                                }
-                                else if(useMagicPink->isChecked())
-                                {
-                                    if(scanLineAlpha[FI_RGBA_RED] == 255 && scanLineAlpha[FI_RGBA_GREEN] == 0 && scanLineAlpha[FI_RGBA_BLUE] == 255)
-                                    *(unsigned short*)(scanLine+j*2) = 0b1000010000100001;
-                                }
-                                else
-                                {
-                                    if(scanLineAlpha[FI_RGBA_ALPHA] != 255)
-                                    *(unsigned short*)(scanLine+j*2) = 0b1000010000100001;
-                                }
-                                scanLineAlpha += 4;
-                            }
-                        }
-                        tex.setScanLine(i,scanLine);
-                    }
-                    if(alpha)
-                        FreeImage_Unload(alpha);
-                    FreeImage_Unload(temp);
-
+                    tex.setData(pixels);
                     textureBlock->setTexture(textureIndex, &tex);
+                    delete[] pixels;
                     emit accept();
                 }
+                else delete[] pixels;
             }
         }
     }
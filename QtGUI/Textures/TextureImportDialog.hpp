@@ -5,6 +5,14 @@
 #include <FreeImage.h>
 #include "../../Driver_Routines/driver_levels.hpp"
 #include "../../Driver_Routines/driver_d3d.hpp"
+#include "../../Driver_Routines/DriverLevels/paletteRemap.hpp"
+#include "../../Driver_Routines/DriverLevels/imageQuantizer.hpp"
+
+const int IMPORT_TRANSPARENCY_DEFAULT = 0;
+const int IMPORT_TRANSPARENCY_MAGIC_PINK = 1;
+const int IMPORT_TRANSPARENCY_ALPHA = 2;
+
+const int IMPORT_DITHER_AMOUNT = 16;
 
 class TextureImportDialog : public QDialog
 {
@@ -24,6 +32,17 @@ class TextureImportDialog : public QDialog
 
         void connectChangeHandler(QWidget* handler);
 
+        //Shared with the batch importer, none of these touch the dialog so they are safe on worker threads
+        //except assignPaletteSlot and setPaletteSlot, which modify the D3D and must run on the GUI thread.
+        static FIBITMAP* loadImage(const QString& file);
+        static void copyIndices(FIBITMAP* dib8, unsigned char* indices);
+        static bool remapImage(FIBITMAP* dib, const DriverPalette* palette, int dither, unsigned char* indices);
+        static bool convertTo15Bit(FIBITMAP* dib, bool transparent, int transparency, unsigned char* pixels);
+        static int assignPaletteSlot(DriverTextures* textures, DriverD3D* d3d, int textureIndex, int paletteIndex);
+        //Points a palette of a texture at slot, adding it to the D3D entry if needed. The old slot is removed
+        //once nothing refers to it any more.
+        static void setPaletteSlot(DriverTextures* textures, DriverD3D* d3d, int textureIndex, int paletteIndex, int slot);
+
     public slots:
         void loadSettings();
         void saveSettings();
@@ -36,6 +55,9 @@ class TextureImportDialog : public QDialog
 
     protected:
         void setPreview(FIBITMAP* dib);
+        void showTransparencyOptions(bool show);
+        void showPaletteOptions(bool show);
+        DriverPalette* getCurrentPalette();
 
         DriverTextures* textureBlock;
         DriverD3D* d3d;
@@ -54,6 +76,11 @@ class TextureImportDialog : public QDialog
         QRadioButton* useDefaultColor;
         QRadioButton* useMagicPink;
         QRadioButton* useAlpha;
+        QLabel* paletteLabel;
+        QButtonGroup* paletteGroup;
+        QRadioButton* useNewPalette;
+        QRadioButton* useCurrentPalette;
+        QCheckBox* useDither;
         QPushButton* importButton;
         QPushButton* cancelButton;
 };
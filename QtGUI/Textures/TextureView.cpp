@@ -927,6 +927,11 @@ void TextureViewGL::textureChanged(int /*idx*/)
     update();
 };
 
+void TextureViewGL::textureBatchChanged(const int* /*indices*/, int /*count*/)
+{
+    update();
+};
+
 void TextureViewGL::textureMoved(int /*from*/, int /*to*/)
 {
     rebuildView();
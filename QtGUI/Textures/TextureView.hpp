@@ -68,6 +68,7 @@ class TextureViewGL : public QOpenGLWidget, IDriverTextureEvents
         void texturesOpened();
         void textureRemoved(int idx);
         void textureChanged(int idx);
+        void textureBatchChanged(const int* indices, int count);
         void textureInserted(int idx);
         void textureMoved(int from, int to);
 
@@ -0,0 +1,212 @@
+#include "VisibilityCheckDialog.hpp"
+
+VisibilitySectorTask::VisibilitySectorTask(QObject* resultReceiver, const VisibilityBuilder* visBuilder, int sectorIdx, SectorBitset* sectorResult, std::atomic<bool>* cancelFlag)
+{
+    receiver = resultReceiver;
+    builder = visBuilder;
+    sector = sectorIdx;
+    result = sectorResult;
+    cancelled = cancelFlag;
+};
+
+void VisibilitySectorTask::run()
+{
+    if(!cancelled->load())
+    builder->buildSector(sector, result);
+    QMetaObject::invokeMethod(receiver, "sectorFinished", Qt::QueuedConnection, Q_ARG(int, sector));
+};
+
+VisibilityCheckDialog::VisibilityCheckDialog(QWidget* parent) : QDialog(parent)
+{
+    level = NULL;
+    cancelled = false;
+    numFinished = 0;
+
+    setWindowTitle(tr("Check Visibility Tables"));
+
+    samplesLabel = new QLabel(tr("Sample points per sector side:"),this);
+    samplesSelect = new QSpinBox(this);
+    samplesSelect->setRange(1,8);
+    samplesSelect->setToolTip(tr("More samples find more visible sectors but take longer."));
+    eyeHeightLabel = new QLabel(tr("Eye height:"),this);
+    eyeHeightSelect = new QDoubleSpinBox(this);
+    eyeHeightSelect->setRange(-100000.0,100000.0);
+    eyeHeightSelect->setDecimals(1);
+    distanceLabel = new QLabel(tr("Maximum view distance (0 for no limit):"),this);
+    distanceSelect = new QDoubleSpinBox(this);
+    distanceSelect->setRange(0.0,10000000.0);
+    distanceSelect->setDecimals(1);
+    occluderLabel = new QLabel(tr("Smallest occluding model:"),this);
+    occluderSelect = new QDoubleSpinBox(this);
+    occluderSelect->setRange(0.0,100000.0);
+    occluderSelect->setDecimals(1);
+
+    resultLabel = new QLabel(this);
+    progress = new QProgressBar(this);
+    progress->setMinimum(0);
+    progress->setMaximum(1);
+    progress->setValue(0);
+
+    buildButton = new QPushButton(tr("Compare"),this);
+    buildButton->setMaximumWidth(100);
+    closeButton = new QPushButton(tr("Close"),this);
+    closeButton->setMaximumWidth(100);
+
+    QGridLayout* optionsLayout = new QGridLayout();
+    optionsLayout->addWidget(samplesLabel,0,0);
+    optionsLayout->addWidget(samplesSelect,0,1);
+    optionsLayout->addWidget(eyeHeightLabel,1,0);
+    optionsLayout->addWidget(eyeHeightSelect,1,1);
+    optionsLayout->addWidget(distanceLabel,2,0);
+    optionsLayout->addWidget(distanceSelect,2,1);
+    optionsLayout->addWidget(occluderLabel,3,0);
+    optionsLayout->addWidget(occluderSelect,3,1);
+
+    QHBoxLayout* buttonsLayout = new QHBoxLayout();
+    buttonsLayout->addWidget(buildButton);
+    buttonsLayout->addWidget(closeButton);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout();
+    mainLayout->addLayout(optionsLayout);
+    mainLayout->addWidget(resultLabel);
+    mainLayout->addWidget(progress);
+    mainLayout->addLayout(buttonsLayout);
+    setLayout(mainLayout);
+    hide();
+
+    connect(buildButton, SIGNAL(clicked()), this, SLOT(startBuild()));
+    connect(closeButton, SIGNAL(clicked()), this, SLOT(reject()));
+};
+
+VisibilityCheckDialog::~VisibilityCheckDialog()
+{
+    cancelBuild();
+};
+
+void VisibilityCheckDialog::setLevel(DriverLevel* lev)
+{
+    if(lev != level)
+    {
+        cancelBuild();
+        setRunning(false);
+    }
+    level = lev;
+};
+
+void VisibilityCheckDialog::loadSettings()
+{
+    QSettings settings;
+    samplesSelect->setValue(settings.value("VisibilityCheckDialog/samplesPerSide",3).toInt());
+    eyeHeightSelect->setValue(settings.value("VisibilityCheckDialog/eyeHeight",0.0).toDouble());
+    distanceSelect->setValue(settings.value("VisibilityCheckDialog/maxDistance",0.0).toDouble());
+    occluderSelect->setValue(settings.value("VisibilityCheckDialog/minOccluderSize",0.0).toDouble());
+};
+
+void VisibilityCheckDialog::saveSettings()
+{
+    QSettings settings;
+    settings.setValue("VisibilityCheckDialog/samplesPerSide",samplesSelect->value());
+    settings.setValue("VisibilityCheckDialog/eyeHeight",eyeHeightSelect->value());
+    settings.setValue("VisibilityCheckDialog/maxDistance",distanceSelect->value());
+    settings.setValue("VisibilityCheckDialog/minOccluderSize",occluderSelect->value());
+};
+
+void VisibilityCheckDialog::reject()
+{
+    cancelBuild();
+    setRunning(false);
+    QDialog::reject();
+};
+
+void VisibilityCheckDialog::cancelBuild()
+{
+    cancelled = true;
+    pool.clear();
+    pool.waitForDone();
+    results.clear();
+};
+
+void VisibilityCheckDialog::setRunning(bool running)
+{
+    buildButton->setEnabled(!running);
+    samplesSelect->setEnabled(!running);
+    eyeHeightSelect->setEnabled(!running);
+    distanceSelect->setEnabled(!running);
+    occluderSelect->setEnabled(!running);
+};
+
+void VisibilityCheckDialog::startBuild()
+{
+    if(!level)
+        return;
+
+    builder.setSamplesPerSide(samplesSelect->value());
+    builder.setEyeHeight(eyeHeightSelect->value());
+    builder.setMaxDistance(distanceSelect->value());
+    builder.setMinOccluderSize(occluderSelect->value());
+
+    if(level->visibility.getNumSectors() != level->world.getNumSectors())
+    {
+        resultLabel->setText(tr("The visibility table has %1 sectors but the world has %2, so they cannot be matched up.").arg(level->visibility.getNumSectors()).arg(level->world.getNumSectors()));
+        return;
+    }
+
+    //Everything the workers need is copied out of the level here, so they never touch it.
+    int numSectors = builder.prepare(level);
+    if(numSectors == 0)
+    {
+        resultLabel->setText(tr("This level has no visibility table to check."));
+        return;
+    }
+
+    cancelled = false;
+    numFinished = 0;
+    results.clear();
+    results.resize(numSectors);
+    progress->setMaximum(numSectors);
+    progress->setValue(0);
+    //Every pair of sectors in range costs samples^4 rays, which adds up fast without a view distance.
+    long long numRays = builder.getMaxRayCount();
+    if(numRays > VISIBILITY_CHECK_WARN_RAYS)
+    {
+        QMessageBox msgBox(this);
+        msgBox.setText(tr("This check may cast up to %1 million rays and take a long time.").arg(numRays/1000000));
+        msgBox.setInformativeText(tr("Lowering the sample points or setting a maximum view distance makes it faster. Continue anyway?"));
+        msgBox.setIcon(QMessageBox::Warning);
+        msgBox.setStandardButtons(QMessageBox::Yes|QMessageBox::No);
+        if(msgBox.exec() != QMessageBox::Yes)
+        return;
+    }
+    resultLabel->setText(tr("Using %1 occluding models.").arg(builder.getNumOccluders()));
+
+    //Tasks are taken from a shared queue, so threads that finish cheap sectors early move on to the next one.
+    setRunning(true);
+    for(int i = 0; i < numSectors; i++)
+    pool.start(new VisibilitySectorTask(this, &builder, i, &results[i], &cancelled));
+};
+
+void VisibilityCheckDialog::sectorFinished(int sector)
+{
+    if(cancelled || sector < 0 || sector >= results.size())
+        return;
+
+    numFinished++;
+    progress->setValue(numFinished);
+    if(numFinished < results.size())
+        return;
+
+    //The table format is not verified yet, so the results are only compared against the level's own tables.
+    int totalVisible = 0;
+    int numDiffering = 0;
+    for(int i = 0; i < results.size(); i++)
+    {
+        totalVisible += results[i].count();
+        const SectorBitset* current = level->visibility.getVisibility(i);
+        if(!current || *current != results[i])
+        numDiffering++;
+    }
+    resultLabel->setText(tr("Estimated %1 sectors, each seeing %2 sectors on average. %3 sectors differ from the level's tables as currently decoded. This is only a diagnostic, the level is not changed.")
+                         .arg(results.size()).arg((double)totalVisible/results.size(), 0, 'f', 1).arg(numDiffering));
+    results.clear();
+    setRunning(false);
+};
@@ -0,0 +1,71 @@
+#ifndef VISIBILITY_CHECK_DIALOG_HPP
+#define VISIBILITY_CHECK_DIALOG_HPP
+
+#include <QtWidgets>
+#include <atomic>
+#include "../../Driver_Routines/driver_levels.hpp"
+#include "../../Driver_Routines/DriverLevels/visibilityBuilder.hpp"
+
+#define VISIBILITY_CHECK_WARN_RAYS 1000000000LL
+
+//Builds the visibility of one sector on a worker thread. Each task only writes its own result.
+class VisibilitySectorTask : public QRunnable
+{
+    public:
+        VisibilitySectorTask(QObject* resultReceiver, const VisibilityBuilder* visBuilder, int sectorIdx, SectorBitset* sectorResult, std::atomic<bool>* cancelFlag);
+        void run();
+
+    protected:
+        QObject* receiver;
+        const VisibilityBuilder* builder;
+        int sector;
+        SectorBitset* result;
+        std::atomic<bool>* cancelled;
+};
+
+class VisibilityCheckDialog : public QDialog
+{
+    Q_OBJECT
+
+    public:
+        VisibilityCheckDialog(QWidget* parent = NULL);
+        ~VisibilityCheckDialog();
+
+        void setLevel(DriverLevel* lev);
+
+    public slots:
+        void loadSettings();
+        void saveSettings();
+        void reject();
+
+    protected slots:
+        void startBuild();
+        void sectorFinished(int sector);
+
+    protected:
+        void cancelBuild();
+        void setRunning(bool running);
+
+        DriverLevel* level;
+        VisibilityBuilder builder;
+
+        QThreadPool pool;
+        std::atomic<bool> cancelled;
+        QVector<SectorBitset> results;
+        int numFinished;
+
+        QLabel* samplesLabel;
+        QSpinBox* samplesSelect;
+        QLabel* eyeHeightLabel;
+        QDoubleSpinBox* eyeHeightSelect;
+        QLabel* distanceLabel;
+        QDoubleSpinBox* distanceSelect;
+        QLabel* occluderLabel;
+        QDoubleSpinBox* occluderSelect;
+        QLabel* resultLabel;
+        QProgressBar* progress;
+        QPushButton* buildButton;
+        QPushButton* closeButton;
+};
+
+#endif
@@ -0,0 +1,28 @@
+#version 330
+
+uniform sampler2D colorTexture;
+uniform sampler2D paletteTexture;
+uniform float paletteRow;
+smooth in vec4 color;
+smooth in vec2 texCoord;
+out vec4 fragColor;
+
+vec4 lookup(vec2 coord)
+{
+	float index = texture(colorTexture, coord).r;
+	return texture(paletteTexture, vec2((index*255.0+0.5)/256.0, paletteRow));
+}
+
+void main(void)
+{
+	//Indices can't be interpolated, so filter the four looked up colours instead.
+	vec2 size = vec2(textureSize(colorTexture, 0));
+	vec2 pos = texCoord*size-0.5;
+	vec2 weight = fract(pos);
+	vec2 base = (floor(pos)+0.5)/size;
+	vec2 texel = 1.0/size;
+	vec4 top = mix(lookup(base), lookup(base+vec2(texel.x, 0.0)), weight.x);
+	vec4 bottom = mix(lookup(base+vec2(0.0, texel.y)), lookup(base+texel), weight.x);
+	vec4 textureColor = mix(top, bottom, weight.y);
+    fragColor = textureColor * color;
+}
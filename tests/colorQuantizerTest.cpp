@@ -0,0 +1,51 @@
+#include <cassert>
+#include <cstdio>
+#include "../Driver_Routines/DriverLevels/colorQuantizer.hpp"
+
+static unsigned int seed = 1;
+
+static int nextRandom(int range)
+{
+    seed = seed*1103515245+12345;
+    return (seed >> 16)%range;
+};
+
+//Images with only a few colours quantized to fewer entries still leave most of the palette unused. k-means used to
+//remap pixels onto those unused entries once the first colour moved and wrote past the end of its sums.
+static void testFewColors()
+{
+    for(int image = 0; image < 500; image++)
+    {
+        int numColors = 2+nextRandom(6);
+        int numDistinct = numColors+1+nextRandom(6);
+        unsigned char distinct[16][3];
+        for(int i = 0; i < numDistinct; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            distinct[i][j] = nextRandom(256);
+        }
+
+        unsigned char pixels[64*3];
+        for(int i = 0; i < 64; i++)
+        {
+            int c = nextRandom(numDistinct);
+            for(int j = 0; j < 3; j++)
+            pixels[i*3+j] = distinct[c][j];
+        }
+
+        ColorQuantizer quantizer;
+        quantizer.addPixels(pixels,3,0,1,2,64);
+        DriverPalette palette;
+        int used = quantizer.quantize(&palette,numColors);
+        assert(used >= 1 && used <= numColors);
+        for(int i = used; i < 256; i++)
+        assert(palette.colors[i].r == 0 && palette.colors[i].g == 0 && palette.colors[i].b == 0);
+    }
+};
+
+int main()
+{
+    testFewColors();
+    printf("colorQuantizerTest passed\n");
+    return 0;
+};
@@ -0,0 +1,16 @@
+CONFIG += console
+CONFIG -= qt
+CONFIG -= app_bundle
+
+TEMPLATE = app
+TARGET = colorQuantizerTest
+
+SOURCES += \
+    colorQuantizerTest.cpp \
+    ../vector.cpp \
+    ../Log_Routines/debug_logger.cpp \
+    ../Log_Routines/default_loggers.cpp \
+    ../Driver_Routines/ioFuncs.cpp \
+    ../Driver_Routines/DriverLevels/colorQuantizer.cpp \
+    ../Driver_Routines/DriverLevels/paletteRemap.cpp \
+    ../Driver_Routines/DriverLevels/textures.cpp \